@@ -1,627 +1,11362 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <ctype.h>
-
-#define MAX_NAME_LEN 20     // Maximum characters for student name
-#define MAX_STUDENTS 30     // Maximum number of students
-#define MAX_COURSES 6       // Maximum number of courses
-
-typedef struct {
-    long id;                    // Student ID (4 digits)
-    char name[MAX_NAME_LEN];    // Student name
-    float scores[MAX_COURSES];  // Course scores
-    float total;                // Total score
-    float average;              // Average score
-} Student;
-
-// Function declarations
-int showMenu(void);
-void showHelp();
-int inputStudentData(Student students[], int studentCount, int courseCount);
-void showCourseStatistics(Student students[], int studentCount, int courseCount);
-void showStudentStatistics(Student students[], int studentCount, int courseCount);
-void sortByTotalScore(Student students[], int studentCount, int courseCount, int descending);
-void sortByStudentId(Student students[], int studentCount, int courseCount);
-void sortByStudentName(Student students[], int studentCount, int courseCount);
-void searchByStudentId(Student students[], int studentCount, int courseCount);
-void searchByStudentName(Student students[], int studentCount, int courseCount);
-void showGradeStatistics(Student students[], int studentCount, int courseCount);
-void displayAllStudents(Student students[], int studentCount, int courseCount);
-void clearInputBuffer();
-int isValidStudentName(const char *name);
-int hasDataBeenEntered = 0;  // Global flag to track if data exists
-
-// Function 1: Display main menu
-int showMenu(void) {
-    int choice;
-
-    printf("\n============================================\n");
-    printf("        STUDENT MANAGEMENT SYSTEM\n");
-    printf("============================================\n");
-    printf("1. Show Instructions\n");
-    printf("2. Enter Student Data\n");
-    printf("3. Show Course Statistics\n");
-    printf("4. Show Student Statistics\n");
-    printf("5. Sort: Highest to Lowest Scores\n");
-    printf("6. Sort: Lowest to Highest Scores\n");
-    printf("7. Sort by Student ID\n");
-    printf("8. Sort by Student Name\n");
-    printf("9. Search by Student ID\n");
-    printf("10. Search by Student Name\n");
-    printf("11. Show Grade Distribution\n");
-    printf("12. Display All Students\n");
-    printf("0. Exit Program\n");
-    printf("============================================\n");
-    printf("Enter your choice (0-12): ");
-
-    if (scanf("%d", &choice) != 1) {
-        clearInputBuffer();
-        return -1;
-    }
-    return choice;
-}
-
-// Function 2: Show instructions
-void showHelp() {
-    printf("\n============================================\n");
-    printf("                INSTRUCTIONS\n");
-    printf("============================================\n");
-    printf("1. Maximum 30 students and 6 courses\n");
-    printf("2. Student ID must be 4 digits (1000-9999)\n");
-    printf("3. Student name: letters and spaces only\n");
-    printf("4. Scores must be between 0 and 100\n");
-    printf("5. Data is saved until program ends\n");
-    printf("6. You can use menu options in any order\n");
-    printf("============================================\n");
-}
-
-// Function 3: Clear input buffer
-void clearInputBuffer() {
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF);
-}
-
-// Function 4: Validate student name
-int isValidStudentName(const char *name) {
-    int i;
-
-    // Check if name is empty
-    if (strlen(name) == 0) {
-        return 0;
-    }
-
-    // Check each character
-    for (i = 0; name[i] != '\0'; i++) {
-        // Allow only letters, spaces, and hyphens
-        if (!isalpha(name[i]) && name[i] != ' ' && name[i] != '-') {
-            return 0;
-        }
-
-        // Check for consecutive spaces
-        if (name[i] == ' ' && name[i + 1] == ' ') {
-            return 0;
-        }
-    }
-
-    // Name must start with a letter
-    if (!isalpha(name[0])) {
-        return 0;
-    }
-
-    return 1;
-}
-
-// Function 5: Input student data
-int inputStudentData(Student students[], int studentCount, int courseCount) {
-    int i, j;
-    char confirm;
-
-    // Check if data already exists
-    if (hasDataBeenEntered) {
-        printf("\nWARNING: Student data already exists!\n");
-        printf("Entering new data will overwrite existing records.\n");
-        printf("Do you want to continue? (y/n): ");
-        clearInputBuffer();
-        scanf("%c", &confirm);
-        if (confirm != 'y' && confirm != 'Y') {
-            printf("Data entry cancelled.\n");
-            return 0;
-        }
-    }
-
-    printf("\n============================================\n");
-    printf("          ENTER STUDENT INFORMATION\n");
-    printf("============================================\n");
-
-    for (i = 0; i < studentCount; i++) {
-        printf("\n--- Student %d ---\n", i + 1);
-
-        // Input student ID with validation
-        while (1) {
-            printf("Student ID (4 digits, 1000-9999): ");
-            if (scanf("%ld", &students[i].id) != 1) {
-                printf("ERROR: Invalid input. Please enter numbers only.\n");
-                clearInputBuffer();
-                continue;
-            }
-            clearInputBuffer();
-
-            // Validate ID range
-            if (students[i].id < 1000 || students[i].id > 9999) {
-                printf("ERROR: ID must be 4 digits (1000-9999).\n");
-                continue;
-            }
-
-            // Check for duplicate IDs
-            int duplicate = 0;
-            for (j = 0; j < i; j++) {
-                if (students[j].id == students[i].id) {
-                    printf("ERROR: This ID already exists. Please enter a unique ID.\n");
-                    duplicate = 1;
-                    break;
-                }
-            }
-            if (!duplicate) break;
-        }
-
-        // Input student name with validation
-        while (1) {
-            printf("Student Name (letters and spaces only): ");
-            fgets(students[i].name, MAX_NAME_LEN, stdin);
-
-            // Remove newline character
-            students[i].name[strcspn(students[i].name, "\n")] = '\0';
-
-            // Validate name
-            if (strlen(students[i].name) == 0) {
-                printf("ERROR: Name cannot be empty.\n");
-                continue;
-            }
-
-            if (strlen(students[i].name) >= MAX_NAME_LEN) {
-                printf("ERROR: Name is too long. Maximum %d characters.\n", MAX_NAME_LEN - 1);
-                clearInputBuffer();
-                continue;
-            }
-
-            if (!isValidStudentName(students[i].name)) {
-                printf("ERROR: Invalid name. Use letters and spaces only.\n");
-                continue;
-            }
-            break;
-        }
-
-        // Input scores for each course
-        printf("Enter scores for %d courses:\n", courseCount);
-        students[i].total = 0;
-
-        for (j = 0; j < courseCount; j++) {
-            while (1) {
-                printf("  Course %d (0-100): ", j + 1);
-                if (scanf("%f", &students[i].scores[j]) != 1) {
-                    printf("    ERROR: Invalid input. Enter a number.\n");
-                    clearInputBuffer();
-                    continue;
-                }
-                clearInputBuffer();
-
-                if (students[i].scores[j] < 0 || students[i].scores[j] > 100) {
-                    printf("    ERROR: Score must be between 0 and 100.\n");
-                    continue;
-                }
-                break;
-            }
-            students[i].total += students[i].scores[j];
-        }
-
-        // Calculate average
-        students[i].average = (courseCount > 0) ? students[i].total / courseCount : 0;
-    }
-
-    hasDataBeenEntered = 1;
-    printf("\nSUCCESS: %d student records have been saved.\n", studentCount);
-    return 1;
-}
-
-// Function 6: Display all students in a clean table
-void displayAllStudents(Student students[], int studentCount, int courseCount) {
-    int i, j;
-
-    if (studentCount <= 0) {
-        printf("\nERROR: No student data available.\n");
-        printf("Please enter student data first (Option 2).\n");
-        return;
-    }
-
-    printf("\n=========================================================================================================\n");
-    printf("                                     STUDENT RECORDS\n");
-    printf("=========================================================================================================\n");
-
-    // Print table header
-    printf("Student ID    Student Name         ");
-    for (j = 0; j < courseCount; j++) {
-        printf("Course %-2d  ", j + 1);
-    }
-    printf("   Total     Average\n");
-
-    printf("------------  -------------------- ");
-    for (j = 0; j < courseCount; j++) {
-        printf("---------- ");
-    }
-    printf("  ---------  ---------\n");
-
-    // Print student data
-    for (i = 0; i < studentCount; i++) {
-        printf("%-12ld  %-20s", students[i].id, students[i].name);
-
-        for (j = 0; j < courseCount; j++) {
-            printf("  %8.1f", students[i].scores[j]);
-        }
-
-        printf("  %9.1f  %8.2f\n", students[i].total, students[i].average);
-    }
-
-    printf("=========================================================================================================\n");
-    printf("Total Students: %d, Total Courses: %d\n", studentCount, courseCount);
-}
-
-// Function 7: Calculate course statistics
-void showCourseStatistics(Student students[], int studentCount, int courseCount) {
-    int i, j;
-
-    if (studentCount <= 0) {
-        printf("\nERROR: No data available.\n");
-        return;
-    }
-
-    printf("\n============================================\n");
-    printf("            COURSE STATISTICS\n");
-    printf("============================================\n");
-
-    for (j = 0; j < courseCount; j++) {
-        float total = 0, highest = 0, lowest = 100;
-
-        for (i = 0; i < studentCount; i++) {
-            float score = students[i].scores[j];
-            total += score;
-            if (score > highest) highest = score;
-            if (score < lowest) lowest = score;
-        }
-
-        float average = total / studentCount;
-
-        printf("\nCourse %d:\n", j + 1);
-        printf("  Average Score: %.2f\n", average);
-        printf("  Highest Score: %.2f\n", highest);
-        printf("  Lowest Score:  %.2f\n", lowest);
-        printf("  Total Score:   %.2f\n", total);
-    }
-}
-
-// Function 8: Calculate student statistics
-void showStudentStatistics(Student students[], int studentCount, int courseCount) {
-    int i;
-
-    if (studentCount <= 0) {
-        printf("\nERROR: No data available.\n");
-        return;
-    }
-
-    printf("\n============================================\n");
-    printf("           STUDENT STATISTICS\n");
-    printf("============================================\n");
-
-    for (i = 0; i < studentCount; i++) {
-        printf("\nID: %ld, Name: %s\n", students[i].id, students[i].name);
-        printf("  Total Score: %.1f, Average: %.2f\n", students[i].total, students[i].average);
-    }
-}
-
-// Function 9: Sort by total score
-void sortByTotalScore(Student students[], int studentCount, int courseCount, int descending) {
-    int i, j;
-
-    for (i = 0; i < studentCount - 1; i++) {
-        for (j = 0; j < studentCount - i - 1; j++) {
-            int shouldSwap = 0;
-
-            if (descending) {
-                shouldSwap = students[j].total < students[j + 1].total;
-            } else {
-                shouldSwap = students[j].total > students[j + 1].total;
-            }
-
-            if (shouldSwap) {
-                Student temp = students[j];
-                students[j] = students[j + 1];
-                students[j + 1] = temp;
-            }
-        }
-    }
-}
-
-// Function 10: Sort by student ID
-void sortByStudentId(Student students[], int studentCount, int courseCount) {
-    int i, j;
-
-    for (i = 0; i < studentCount - 1; i++) {
-        for (j = 0; j < studentCount - i - 1; j++) {
-            if (students[j].id > students[j + 1].id) {
-                Student temp = students[j];
-                students[j] = students[j + 1];
-                students[j + 1] = temp;
-            }
-        }
-    }
-}
-
-// Function 11: Sort by student name
-void sortByStudentName(Student students[], int studentCount, int courseCount) {
-    int i, j;
-
-    for (i = 0; i < studentCount - 1; i++) {
-        for (j = 0; j < studentCount - i - 1; j++) {
-            if (strcasecmp(students[j].name, students[j + 1].name) > 0) {
-                Student temp = students[j];
-                students[j] = students[j + 1];
-                students[j + 1] = temp;
-            }
-        }
-    }
-}
-
-// Function 12: Search by student ID
-void searchByStudentId(Student students[], int studentCount, int courseCount) {
-    long searchId;
-    int i, j, found = 0;
-
-    if (studentCount <= 0) {
-        printf("\nERROR: No data available.\n");
-        return;
-    }
-
-    printf("\nEnter Student ID to search: ");
-    if (scanf("%ld", &searchId) != 1) {
-        printf("ERROR: Invalid input.\n");
-        clearInputBuffer();
-        return;
-    }
-    clearInputBuffer();
-
-    for (i = 0; i < studentCount; i++) {
-        if (students[i].id == searchId) {
-            printf("\nSTUDENT FOUND:\n");
-            printf("  ID: %ld\n", students[i].id);
-            printf("  Name: %s\n", students[i].name);
-            printf("  Scores: ");
-            for (j = 0; j < courseCount; j++) {
-                printf("Course %d: %.1f  ", j + 1, students[i].scores[j]);
-            }
-            printf("\n  Total: %.1f, Average: %.2f\n", students[i].total, students[i].average);
-            found = 1;
-            break;
-        }
-    }
-
-    if (!found) {
-        printf("\nERROR: Student with ID %ld not found.\n", searchId);
-    }
-}
-
-// Function 13: Search by student name
-void searchByStudentName(Student students[], int studentCount, int courseCount) {
-    char searchName[MAX_NAME_LEN];
-    int i, j, found = 0;
-
-    if (studentCount <= 0) {
-        printf("\nERROR: No data available.\n");
-        return;
-    }
-
-    printf("\nEnter Student Name to search: ");
-    clearInputBuffer();
-    fgets(searchName, MAX_NAME_LEN, stdin);
-    searchName[strcspn(searchName, "\n")] = '\0';
-
-    for (i = 0; i < studentCount; i++) {
-        if (strcasecmp(students[i].name, searchName) == 0) {
-            printf("\nSTUDENT FOUND:\n");
-            printf("  ID: %ld\n", students[i].id);
-            printf("  Name: %s\n", students[i].name);
-            printf("  Scores: ");
-            for (j = 0; j < courseCount; j++) {
-                printf("Course %d: %.1f  ", j + 1, students[i].scores[j]);
-            }
-            printf("\n  Total: %.1f, Average: %.2f\n", students[i].total, students[i].average);
-            found = 1;
-        }
-    }
-
-    if (!found) {
-        printf("\nERROR: Student '%s' not found.\n", searchName);
-    }
-}
-
-// Function 14: Show grade distribution
-void showGradeStatistics(Student students[], int studentCount, int courseCount) {
-    int i, j;
-
-    if (studentCount <= 0) {
-        printf("\nERROR: No data available.\n");
-        return;
-    }
-
-    printf("\n============================================\n");
-    printf("          GRADE DISTRIBUTION\n");
-    printf("============================================\n");
-
-    for (j = 0; j < courseCount; j++) {
-        int gradeCount[5] = {0}; // F, D, C, B, A
-
-        for (i = 0; i < studentCount; i++) {
-            float score = students[i].scores[j];
-            if (score >= 90) gradeCount[4]++;      // A
-            else if (score >= 80) gradeCount[3]++; // B
-            else if (score >= 70) gradeCount[2]++; // C
-            else if (score >= 60) gradeCount[1]++; // D
-            else gradeCount[0]++;                  // F
-        }
-
-        printf("\nCourse %d:\n", j + 1);
-        printf("  A (90-100):   %2d students\n", gradeCount[4]);
-        printf("  B (80-89):    %2d students\n", gradeCount[3]);
-        printf("  C (70-79):    %2d students\n", gradeCount[2]);
-        printf("  D (60-69):    %2d students\n", gradeCount[1]);
-        printf("  F (0-59):     %2d students\n", gradeCount[0]);
-    }
-}
-
-// Main Function
-int main() {
-    Student students[MAX_STUDENTS];
-    int studentCount = 0, courseCount = 0;
-    int choice;
-
-    printf("\n============================================\n");
-    printf("     STUDENT MANAGEMENT SYSTEM\n");
-    printf("============================================\n");
-
-    // Get number of students
-    while (studentCount <= 0 || studentCount > MAX_STUDENTS) {
-        printf("\nEnter number of students (1-%d): ", MAX_STUDENTS);
-        if (scanf("%d", &studentCount) != 1) {
-            printf("ERROR: Invalid input.\n");
-            clearInputBuffer();
-            continue;
-        }
-
-        if (studentCount <= 0 || studentCount > MAX_STUDENTS) {
-            printf("ERROR: Please enter between 1 and %d.\n", MAX_STUDENTS);
-        }
-    }
-
-    // Get number of courses
-    while (courseCount <= 0 || courseCount > MAX_COURSES) {
-        printf("Enter number of courses (1-%d): ", MAX_COURSES);
-        if (scanf("%d", &courseCount) != 1) {
-            printf("ERROR: Invalid input.\n");
-            clearInputBuffer();
-            continue;
-        }
-
-        if (courseCount <= 0 || courseCount > MAX_COURSES) {
-            printf("ERROR: Please enter between 1 and %d.\n", MAX_COURSES);
-        }
-    }
-
-    clearInputBuffer();
-
-    // Main program loop
-    do {
-        choice = showMenu();
-
-        switch (choice) {
-            case 1:
-                showHelp();
-                break;
-            case 2:
-                inputStudentData(students, studentCount, courseCount);
-                break;
-            case 3:
-                if (hasDataBeenEntered) {
-                    showCourseStatistics(students, studentCount, courseCount);
-                } else {
-                    printf("\nERROR: Please enter student data first (Option 2).\n");
-                }
-                break;
-            case 4:
-                if (hasDataBeenEntered) {
-                    showStudentStatistics(students, studentCount, courseCount);
-                } else {
-                    printf("\nERROR: Please enter student data first (Option 2).\n");
-                }
-                break;
-            case 5:
-                if (hasDataBeenEntered) {
-                    sortByTotalScore(students, studentCount, courseCount, 1);
-                    printf("\nSORTED BY HIGHEST SCORES:\n");
-                    displayAllStudents(students, studentCount, courseCount);
-                } else {
-                    printf("\nERROR: Please enter student data first (Option 2).\n");
-                }
-                break;
-            case 6:
-                if (hasDataBeenEntered) {
-                    sortByTotalScore(students, studentCount, courseCount, 0);
-                    printf("\nSORTED BY LOWEST SCORES:\n");
-                    displayAllStudents(students, studentCount, courseCount);
-                } else {
-                    printf("\nERROR: Please enter student data first (Option 2).\n");
-                }
-                break;
-            case 7:
-                if (hasDataBeenEntered) {
-                    sortByStudentId(students, studentCount, courseCount);
-                    printf("\nSORTED BY STUDENT ID:\n");
-                    displayAllStudents(students, studentCount, courseCount);
-                } else {
-                    printf("\nERROR: Please enter student data first (Option 2).\n");
-                }
-                break;
-            case 8:
-                if (hasDataBeenEntered) {
-                    sortByStudentName(students, studentCount, courseCount);
-                    printf("\nSORTED BY STUDENT NAME:\n");
-                    displayAllStudents(students, studentCount, courseCount);
-                } else {
-                    printf("\nERROR: Please enter student data first (Option 2).\n");
-                }
-                break;
-            case 9:
-                if (hasDataBeenEntered) {
-                    searchByStudentId(students, studentCount, courseCount);
-                } else {
-                    printf("\nERROR: Please enter student data first (Option 2).\n");
-                }
-                break;
-            case 10:
-                if (hasDataBeenEntered) {
-                    searchByStudentName(students, studentCount, courseCount);
-                } else {
-                    printf("\nERROR: Please enter student data first (Option 2).\n");
-                }
-                break;
-            case 11:
-                if (hasDataBeenEntered) {
-                    showGradeStatistics(students, studentCount, courseCount);
-                } else {
-                    printf("\nERROR: Please enter student data first (Option 2).\n");
-                }
-                break;
-            case 12:
-                if (hasDataBeenEntered) {
-                    displayAllStudents(students, studentCount, courseCount);
-                } else {
-                    printf("\nERROR: Please enter student data first (Option 2).\n");
-                }
-                break;
-            case 0:
-                printf("\nThank you for using the Student Management System.\n");
-                break;
-            default:
-                if (choice != -1) {
-                    printf("\nERROR: Invalid choice. Please enter a number from 0 to 12.\n");
-                }
-                clearInputBuffer();
-        }
-
-        if (choice != 0) {
-            printf("\nPress Enter to continue...");
-            clearInputBuffer();
-        }
-
-    } while (choice != 0);
-
-    return 0;
-}
+#define _GNU_SOURCE         // fopencookie, used to count the bytes each operation prints
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <limits.h>
+#include <stddef.h>
+#include <time.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1  // Build the SSE2/AVX2 statistics kernels
+#endif
+
+#define MAX_NAME_LEN 128    // Longest student name in bytes (UTF-8), plus the terminator
+#define LEGACY_NAME_LEN 20  // Fixed name width in version 1 and 2 snapshots and version 1 journals
+#define NAME_ARENA_SLACK (64 << 10)  // Unused arena bytes tolerated before names are compacted
+#define MAX_COURSES 40      // Maximum number of courses
+#define MAX_ATTRIBUTES 4    // Categorical columns (section, year, ...) a table can carry
+#define ATTRIBUTE_NAME_LEN 32   // Longest attribute name, plus the terminator
+#define ATTRIBUTE_VALUE_LEN 32  // Longest attribute value in bytes, plus the terminator
+#define MAX_ATTRIBUTE_VALUES 65535  // Dictionary codes per attribute, the empty value's 0 included
+#define INITIAL_CAPACITY 64 // Rows allocated the first time a table grows
+#define MIN_STUDENT_ID 1000 // Smallest valid student ID
+#define MAX_STUDENT_ID 9999 // Largest valid student ID unless --max-id raises it
+#define IMPORT_BUFFER_SIZE (1 << 20)  // Bytes read from a CSV file at a time
+#define IMPORT_CHUNK_SIZE (64 << 10)  // Bytes of whole lines handed to a parser thread at a time
+#define IMPORT_CHUNKS_PER_PARSER 4    // Chunks in flight per parser thread
+#define IMPORT_MAX_PARSERS 8          // Parser threads one import starts at most
+#define IMPORT_PIPELINE_MIN (8 << 20) // Smaller files are imported on the calling thread alone
+#define MENU_MAX_CHOICE 23  // Highest menu option number
+#define SNAPSHOT_MAGIC "STUSNAP\0"    // First 8 bytes of every snapshot file
+#define SNAPSHOT_VERSION 5  // Bumped whenever the snapshot layout changes
+#define SNAPSHOT_ALIGN 64   // Every column in a snapshot starts on this boundary
+#define SNAPSHOT_HEADER_BLOCK 128   // Bytes before the first column from version 4; SNAPSHOT_ALIGN before
+#define DEFAULT_SNAPSHOT_PATH "students.snap"
+#define VIEW_NONE -1        // Rows are listed in storage order
+#define SEARCH_PREFIX_MARK '*'  // "Jo*" finds every name starting with Jo
+#define SEARCH_FUZZY_MARK '~'   // "~Jon" finds names within a small edit distance
+#define SCORE_FIXED_ONE 4294967296.0    // Fixed-point units per score point (2^32)
+#define SQUARE_FIXED_ONE 262144.0       // Fixed-point units per squared point (2^18)
+#define ROUNDING_MAGIC 6755399441055744.0   // 1.5 * 2^52: adding it rounds a double to an integer
+#define ROUNDING_MAGIC_BITS 0x4338000000000000LL
+#define GRADE_BANDS 5       // F, D, C, B, A
+#define MAX_THREADS 256     // Upper limit for --threads
+#define PARALLEL_MIN_ROWS 65536 // Smaller scans are not worth waking the workers for
+#define RANK_BY_TOTAL -1    // Course argument meaning "rank by total score"
+#define RANGE_BY_AVERAGE -2 // Field argument meaning "the average column"
+#define RANGE_ANY_COURSE -3 // Range condition field meaning "at least one course"
+#define MAX_RANGE_CONDITIONS 8  // Fields one range query can restrict
+#define SCORE_BINS 1001     // Exact histogram bins: one per 0.1 point from 0 to 100
+#define SKETCH_SUB_BITS 7   // Sketch buckets per power of two: 2^7, so values are within 0.4%
+#define SKETCH_MIN_EXPONENT -10 // Sketch values below 2^-10 count as zero
+#define SKETCH_OCTAVES 32   // Powers of two the sketch covers above its smallest value
+#define SKETCH_BUCKETS (SKETCH_OCTAVES << SKETCH_SUB_BITS)
+#define DISTRIBUTION_SUM_ONE 65536.0    // Fixed-point units per point in distribution sums (2^16)
+#define DISTRIBUTION_SQUARE_ONE 256.0   // Fixed-point units per squared point (2^8)
+#define BATCH_LINE_LEN 1024 // Longest batch command
+#define BATCH_MAX_ARGS 16   // Words looked at in a batch command
+#define RENDER_BUFFER_SIZE (1 << 20)  // Bytes of formatted rows written at a time
+#define RENDER_ROW_MAX 1024 // Upper bound on one formatted row
+#define DEFAULT_PAGE_SIZE 50    // Rows per page when only --page is given
+#define COLUMN_ID MAX_COURSES   // Column numbers after the courses for --columns
+#define COLUMN_NAME (MAX_COURSES + 1)
+#define COLUMN_TOTAL (MAX_COURSES + 2)
+#define COLUMN_AVERAGE (MAX_COURSES + 3)
+#define COLUMN_COUNT (MAX_COURSES + 4)
+#define VIEW_MASK_ALL ((1 << VIEW_COUNT) - 1)   // Every cached view
+#define VIEW_MASK_TOTALS ((1 << VIEW_TOTAL_DESC) | (1 << VIEW_TOTAL_ASC))
+#define DEFAULT_BENCH_SIZES "1000,100000,10000000"   // Roster sizes --benchmark runs when none are given
+#define DEFAULT_BENCH_OUTPUT "benchmark.tsv"
+#define DEFAULT_GENERATE_COURSES 5  // Courses in generated rosters unless --courses is given
+#define DEFAULT_SEED 1      // Generator seed unless --seed is given
+#define BENCH_LOOKUPS 10000 // Searches timed per roster size, one sample each
+#define BENCH_ROW_BUDGET 2000000    // Rows an operation should touch across its runs at one size
+#define BENCH_MIN_REPS 3    // Runs per operation even on the largest rosters
+#define BENCH_MAX_REPS 200  // Runs per operation on small rosters
+#define LATENCY_SUB_BITS 3  // Latency histogram buckets per power of two: 2^3, so percentiles are within 6%
+#define LATENCY_BUCKETS (64 << LATENCY_SUB_BITS)
+#define STAT_INGEST (MENU_MAX_CHOICE + 1)   // Statistics slot for CSV imports; menu options use their number
+#define STAT_BATCH_FIRST (STAT_INGEST + 1)  // Batch commands follow, in batchCommandNames order
+#define BATCH_COMMAND_COUNT 20
+#define STAT_SLOTS (STAT_BATCH_FIRST + BATCH_COMMAND_COUNT)
+#define STATS_ENV "STUDENT_STATS"   // Set to collect operation statistics and print them on exit
+#define JOURNAL_MAGIC "STUJRNL\0"    // First 8 bytes of every journal file
+#define JOURNAL_VERSION 4   // Bumped whenever the record layout changes
+#define JOURNAL_COMMIT_DELAY_MS 5   // How long a commit waits for more records to share its fsync
+#define JOURNAL_FLUSH_BYTES (64 << 10)  // Queued bytes that start a commit without waiting
+#define JOURNAL_DEFAULT_LIMIT (64L << 20)   // Journal length that triggers a background snapshot
+#define JOURNAL_MAX_RECORD (10 + MAX_NAME_LEN + MAX_COURSES * 4 + MAX_ATTRIBUTES * ATTRIBUTE_VALUE_LEN)  // Largest payload (an insert)
+#define SERVER_BACKLOG 64   // Connections waiting to be accepted
+#define SERVER_POLL_MS 200  // How often the accept loop checks for a shutdown signal
+#define DEFAULT_LOAD_CLIENTS 8  // Connections --loadgen opens unless --clients is given
+#define DEFAULT_LOAD_SECONDS 5  // How long --loadgen runs unless --duration is given
+#define DEFAULT_WRITE_PERCENT 1 // Share of --loadgen commands that update a score
+#define DEFAULT_MEMORY_LIMIT (256L << 20)   // Bytes --external-sort and --external-stats use unless --memory-limit is given
+#define EXTERNAL_MIN_MEMORY (16L << 20) // Smallest --memory-limit accepted
+#define EXTERNAL_RESERVED (8L << 20)    // Part of the limit kept for the program, the input and write buffers and statistics
+#define EXTERNAL_WRITE_BUFFER (1 << 20) // Bytes buffered per output or spill file
+#define EXTERNAL_MIN_BUFFER (256 << 10) // Smallest read buffer per run while merging; more runs take another pass
+#define HISTORY_MAGIC "STUHIST\0"    // First 8 bytes of every term history file
+#define HISTORY_VERSION 1   // Bumped whenever the term layout changes
+#define TERM_MAGIC 0x4d524554u  // "TERM", the first 4 bytes of every term in a history file
+#define TERM_NAME_LEN 32    // Longest term name, plus the terminator
+
+typedef struct {
+    long id;                    // Student ID (4 digits)
+    char name[MAX_NAME_LEN];    // Student name
+    float scores[MAX_COURSES];  // Course scores
+    float total;                // Total score
+    float average;              // Average score
+    char attributes[MAX_ATTRIBUTES][ATTRIBUTE_VALUE_LEN];   // Section, year, ...; "" when not given
+} Student;                      // A single record, used while entering one row
+
+typedef struct {
+    uint32_t offset;            // Where the name starts in the name arena
+    uint32_t length;            // Bytes in the name; its folded key follows at offset + length + 1
+} NameRef;
+
+typedef struct {
+    char *bytes;                // Each name then its case-folded key, both NUL-terminated
+    size_t used;                // Bytes handed out, including names no row refers to any more
+    size_t capacity;            // Bytes allocated; 0 while the arena lives in a snapshot mapping
+    size_t live;                // Bytes the rows' names would take if none were shared
+    uint32_t *internSlots;      // Arena offset + 1 of each distinct name, 0 when empty; NULL until needed
+    uint32_t internMask;        // Slot count minus one
+    uint32_t internCount;       // Occupied slots
+} NameArena;
+
+typedef struct {
+    char name[ATTRIBUTE_NAME_LEN];  // Column name, as given to --attributes
+    uint16_t *codes;            // Dictionary code of every row's value, 0 when it has none
+    char (*values)[ATTRIBUTE_VALUE_LEN];    // Text of each code in the order first seen; code 0 is ""
+    int valueCount;             // Codes handed out, the empty value's included once any is
+    int valueCapacity;          // Entries allocated in values
+    uint16_t *lookup;           // Hash of the values: the code in each slot, 0 when empty
+    uint32_t lookupMask;        // Slot count minus one
+} AttributeColumn;              // A categorical column, stored as small codes into a dictionary
+
+typedef struct {
+    int *slots;                 // Row holding each slot's ID, -1 when the slot is empty
+    int mask;                   // Slot count minus one; the slot count is a power of two
+    int used;                   // Occupied slots
+} IdIndex;
+
+typedef enum {
+    VIEW_TOTAL_DESC,            // Highest total first
+    VIEW_TOTAL_ASC,             // Lowest total first
+    VIEW_ID,                    // Ascending student ID
+    VIEW_NAME,                  // Dictionary order of names, ignoring case
+    VIEW_COUNT
+} ViewKind;
+
+typedef struct {
+    int *rows;                  // Rows changed since a cache was last merged, in change order, with repeats
+    int count;                  // Rows noted
+    int capacity;               // Rows the array can hold
+} PendingRows;
+
+typedef struct {
+    int *rows;                  // Row numbers in sorted order
+    int entries;                // Entries in rows; the roster size once pending rows are merged
+    PendingRows pending;        // Changed rows whose entries are dropped and re-placed on the next read
+    unsigned long version;      // Table version the order was built for
+} SortedView;
+
+typedef struct {
+    uint32_t *keys;             // Sort key of every entry's value, ascending
+    int *rows;                  // Row of every entry; equal keys keep row order
+    int entries;                // Entries in keys and rows; the roster size once pending rows are merged
+    PendingRows pending;        // Changed rows whose entries are dropped and re-placed on the next read
+    unsigned long version;      // Table version the index was built for
+} RangeIndex;
+
+typedef struct {
+    int field;                  // Course index, RANK_BY_TOTAL, RANGE_BY_AVERAGE or RANGE_ANY_COURSE
+    uint32_t lowKey;            // Smallest matching sort key
+    uint32_t highKey;           // Largest matching sort key; below lowKey when nothing matches
+} RangeCondition;
+
+typedef struct {
+    RangeCondition conditions[MAX_RANGE_CONDITIONS];   // All must hold; one per field
+    int count;
+} RangeQuery;
+
+typedef struct {
+    int row;                    // Matching row
+    int distance;               // Edit distance from the query, 0 for exact and prefix hits
+} NameMatch;
+
+typedef struct {
+    long count;                 // Scores included
+    int64_t sum;                // Sum in 1/2^32-point units; integer adds keep it exact
+    int64_t sumSquares;         // Sum of squared scores in 1/2^18 units
+    float lowest;               // Smallest score
+    float highest;              // Largest score
+    long lowestCount;           // Rows holding the smallest score
+    long highestCount;          // Rows holding the largest score
+    int extremesStale;          // The last lowest/highest row was removed; rescan before use
+    long bands[GRADE_BANDS];    // Students per grade band, F first
+} CourseAggregate;
+
+typedef struct {
+    long count;                 // Values included
+    long *bins;                 // Exact counts per 0.1 point from 0 up to the field's largest value
+    int binCount;               // Bins: SCORE_BINS for a course, one per 0.1 point up to 100 per course for totals
+    long offGrid;               // Values the bins cannot hold exactly
+    long *sketch;               // Log-linear bucket counts, NULL while the bins are enough
+    long sketchZero;            // Sketch values below the smallest bucket
+    int64_t sum;                // Sum in 1/2^16-point units
+    int64_t sumSquares;         // Sum of squares in 1/2^8 units
+} Distribution;
+
+typedef struct {
+    int count;                  // Number of student records stored
+    int capacity;               // Rows allocated in every column
+    int courseCount;            // Number of score columns
+    long *ids;                  // Student ID column
+    NameRef *names;             // Student name column: handles into nameArena
+    NameArena nameArena;        // Storage for every name and its case-folded key
+    void **scores;              // One contiguous column per course: scores[course][row]
+    int tenths;                 // Scores stored as uint16_t tenths of a point rather than floats
+    float *totals;              // Total score column
+    float *averages;            // Average score column
+    int attributeCount;         // Categorical columns, 0 for none
+    AttributeColumn attributes[MAX_ATTRIBUTES];
+    void *mapping;              // Snapshot the columns point into, NULL when heap-owned
+    size_t mappingSize;         // Length of the mapping in bytes
+    IdIndex idIndex;            // ID -> row hash index, built on first lookup
+    unsigned long version;      // Bumped on every change so cached views know they are stale
+    SortedView views[VIEW_COUNT];   // Cached sort orders, rebuilt only when stale
+    RangeIndex *ranges;         // Value-ordered indexes: each course, the total, the average; NULL until queried
+    int activeView;             // Order used for listings, VIEW_NONE for storage order
+    CourseAggregate *aggregates;    // Running per-course statistics, NULL until first needed
+    Distribution *distributions;    // Per-course histograms plus one for totals, NULL until first needed
+    uint64_t generation;        // Snapshot generation the rows descend from
+} StudentTable;
+
+typedef struct {
+    long lines;                 // Lines read, including header and blank lines
+    long imported;              // Records appended to the table
+    long rejected;              // Rows written to the reject report
+    long long bytes;            // Bytes read from the file
+    double seconds;             // Wall-clock time spent importing
+} ImportSummary;
+
+typedef struct {
+    char magic[8];              // SNAPSHOT_MAGIC
+    uint32_t version;           // SNAPSHOT_VERSION
+    uint32_t headerSize;        // sizeof(SnapshotHeader)
+    uint32_t courseCount;       // Number of score columns
+    uint32_t nameLength;        // Bytes per name in versions 1-2; 0 for NameRef handles plus a name arena
+    uint64_t recordCount;       // Number of rows in every column
+    uint64_t fileSize;          // Total file length, used to detect truncation
+    uint64_t dataChecksum;      // Checksum of everything after the header block
+    uint64_t headerChecksum;    // Checksum of this header with this field zeroed
+    uint64_t generation;        // Checkpoint number; journals of older generations are included
+    uint32_t scoreBytes;        // Bytes per stored score: 4 for floats, 2 for tenths
+    uint32_t attributeCount;    // Attribute code columns after the averages
+    uint32_t dictionaryBytes;   // Length of the attribute names and values after those
+} SnapshotHeader;                // Version 1 headers end before generation, which reads as 0;
+                                // from version 3 the name arena fills the file after the last column;
+                                // headers before version 4 end before scoreBytes (floats) and sit in a
+                                // SNAPSHOT_ALIGN block, later ones in a SNAPSHOT_HEADER_BLOCK;
+                                // version 4 headers end before dictionaryBytes and have no attributes
+
+typedef void (*RangeTask)(void *context, int part, int begin, int end);
+
+typedef struct {
+    pthread_t *threads;         // Worker threads; the calling thread is part 0
+    int threadCount;            // Parts a job is split into, workers plus the caller
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        // Signalled when a new job is posted
+    pthread_cond_t done;        // Signalled when the last part of a job finishes
+    unsigned long generation;   // Incremented for every job
+    int pending;                // Parts still running
+    int stopping;               // Set when the pool shuts down
+    RangeTask task;             // Current job
+    void *context;
+    int rowCount;               // Rows the current job covers
+} WorkerPool;
+
+typedef struct {
+    const StudentTable *table;
+    int firstCourse;            // First course column to aggregate
+    int courseCount;            // Number of course columns to aggregate
+    CourseAggregate *partials;  // [part][course] partial results
+} AggregateJob;
+
+typedef struct {
+    StudentTable *table;
+    int repair;                 // Rewrite the stored totals instead of only counting mismatches
+    long *mismatches;           // Per-part count of rows whose stored totals differ
+} TotalsJob;
+
+typedef struct {
+    const StudentTable *table;
+    Distribution *partials;     // [part][field] partial histograms, the total last in each part
+} DistributionJob;
+
+typedef struct {
+    long page;                  // 1-based page to list, used when pageSize > 0
+    long pageSize;              // Rows per page, 0 to list every row
+    int selected;               // 0 lists every column, otherwise only those in show
+    unsigned char show[COLUMN_COUNT];   // Courses first, then COLUMN_ID .. COLUMN_AVERAGE
+} ListingOptions;
+
+typedef enum {
+    BATCH_FAILED,               // Command failed; the reason is in the session
+    BATCH_OK,                   // Command ran; its result lines are written
+    BATCH_SKIP,                 // Blank line or comment
+    BATCH_QUIT                  // Stop reading commands
+} BatchStatus;
+
+typedef struct {
+    StudentTable *table;
+    FILE *out;                  // Where results go
+    const char *snapshotPath;   // Default path for "save", NULL when snapshots are off
+    long rows;                  // Result lines the current command wrote
+    char error[256];            // Why the current command failed
+} BatchSession;
+
+typedef struct {
+    uint64_t calls;
+    uint64_t nanos;             // Total time spent
+    uint64_t records;           // Rows the calls covered
+    uint64_t bytes;             // Bytes printed (read, for CSV ingest)
+    uint64_t latency[LATENCY_BUCKETS];  // Log-linear histogram of call durations in nanoseconds
+} OperationStats;
+
+typedef struct {
+    struct timespec began;
+    uint64_t bytes;             // outputBytes when the operation started
+} OperationTimer;
+
+typedef enum {
+    BENCH_INGEST,
+    BENCH_SORT_TOTAL_DESC,
+    BENCH_SORT_TOTAL_ASC,
+    BENCH_SORT_ID,
+    BENCH_SORT_NAME,
+    BENCH_SEARCH_ID,
+    BENCH_SEARCH_NAME,
+    BENCH_COURSE_STATS,
+    BENCH_STUDENT_STATS,
+    BENCH_GRADE_STATS,
+    BENCH_DISPLAY,
+    BENCH_OPERATION_COUNT
+} BenchOperation;
+
+typedef enum {
+    JOURNAL_RESET = 1,          // Every row dropped; payload is the course count, the score layout, then any attribute names
+    JOURNAL_INSERT,             // id, name, one float per course, then each attribute value
+    JOURNAL_UPDATE,             // id, course, float
+    JOURNAL_RENAME,             // id, name
+    JOURNAL_DELETE              // id
+} JournalOp;
+
+typedef struct {
+    char magic[8];              // JOURNAL_MAGIC
+    uint32_t version;           // JOURNAL_VERSION
+    uint32_t headerSize;        // sizeof(JournalHeader)
+    uint64_t generation;        // Snapshot generation the records apply on top of
+} JournalHeader;                // Followed by records: u32 size, u32 checksum, payload
+
+typedef struct {
+    int fd;                     // Open journal, -1 when journaling is off
+    char path[1024];            // <snapshot>.journal
+    char oldPath[1024];         // Journal being folded into a snapshot by the compactor
+    const char *snapshotPath;
+    uint64_t generation;        // Generation in the open journal's header
+    long limit;                 // Length that triggers compaction
+    off_t fileSize;             // Length of the journal including queued records
+    pthread_t flusher;          // Group-commit thread
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        // Records queued, a writer is waiting, or shutting down
+    pthread_cond_t durable;     // A commit finished
+    char *pending;              // Records queued since the last commit
+    size_t pendingUsed;
+    size_t pendingCapacity;
+    char *writing;              // Records the flusher is writing
+    size_t writingCapacity;
+    uint64_t appended;          // Bytes queued so far
+    uint64_t synced;            // Bytes known to be on disk
+    int syncWaiters;            // Callers blocked in journalSync
+    int stopping;
+    int failed;                 // A write or fsync failed; nothing more is journaled
+    pthread_t compactor;        // Background snapshot thread
+    int compacting;             // 0 idle, 1 running, 2 finished and waiting to be joined
+    int compactionFailed;       // Stop retrying after a failed background snapshot
+    int shapePending;           // A new table's shape is journaled with its first row, not before
+    StudentTable image;         // Rows the compactor is writing
+} Journal;
+
+typedef enum {
+    SERVER_READ,                // Runs alongside other reads
+    SERVER_WRITE,               // Queued for the writer thread
+    SERVER_REFUSED              // Not offered in server mode
+} ServerCommandKind;
+
+typedef struct ServerWrite {
+    BatchSession *session;      // Client that sent it; results go to its reply buffer
+    char *line;
+    int status;                 // BatchStatus once applied
+    int done;
+    struct ServerWrite *next;
+} ServerWrite;
+
+typedef struct {
+    StudentTable *table;
+    const char *snapshotPath;
+    int listenFd;
+    pthread_rwlock_t lock;      // Shared by readers, held exclusively while a batch of writes is applied
+    int exclusiveReads;         // Caches could not be built, so reads take the lock exclusively too
+    pthread_mutex_t queueLock;
+    pthread_cond_t queued;      // A write arrived, or shutting down
+    pthread_cond_t applied;     // A batch of writes finished
+    ServerWrite *head, *tail;   // Writes waiting for the next batch
+    pthread_t writer;
+    int stopping;
+    long reads, writes, batches;
+} QueryServer;
+
+typedef struct {
+    const char *socketPath;
+    double seconds;
+    int writePercent;
+    uint64_t seed;
+    long studentCount;          // IDs asked about run from MIN_STUDENT_ID up this many
+    int courseCount;
+    pthread_t thread;
+    OperationStats reads, writes;
+    long errors;
+} LoadClient;
+
+typedef struct {
+    FILE *file;
+    char *buffer;               // IMPORT_BUFFER_SIZE bytes read ahead
+    size_t start;               // Offset of the first unreturned line in buffer
+    size_t used;                // Valid bytes in buffer
+    int atEof;
+    int skipping;               // Inside an over-long line whose head was dropped
+    long lines;                 // Lines returned so far, blank ones included
+    long long bytes;            // Bytes read from the file
+} CsvLineReader;
+
+typedef struct {
+    uint64_t key;               // Sort key: the total or ID mapped to an unsigned order; 0 when sorting by name
+    uint64_t sequence;          // Position in the input, so equal keys keep their input order
+    int64_t id;                 // Student ID
+    uint32_t nameLength;        // Bytes of name, then of each attribute value after a comma
+    uint32_t foldedLength;      // Bytes of case-folded name after it; 0 unless sorting by name
+    uint32_t size;              // Bytes in the whole record, a multiple of 8
+} RunRecord;                    // Followed by courseCount float scores, the name and the folded name
+
+typedef struct {
+    uint64_t start;             // Offset of a sorted run's first record in its spill file
+    uint64_t end;               // Offset just past its last record
+} SortRun;
+
+typedef struct {
+    int fd;                     // Spill file the run lives in
+    uint64_t next;              // File offset of the next unread byte
+    uint64_t end;               // End of the run
+    char *buffer;               // Bytes of the run read ahead
+    size_t capacity;
+    size_t used;                // Valid bytes in buffer
+    size_t position;            // Offset of the current record in buffer
+    const RunRecord *current;   // Smallest record not yet merged, NULL once the run is used up
+} RunReader;
+
+typedef struct {
+    ViewKind order;             // Output order; VIEW_COUNT when only gathering statistics
+    int courseCount;            // Score columns, set by the first line
+    int attributeCount;         // Attribute columns between the name and the scores
+    size_t memoryLimit;         // Bytes the job may hold at once (--memory-limit)
+    char *arena;                // Records of the run being gathered from the front, pointers to them from the back
+    size_t arenaSize;
+    size_t arenaUsed;           // Record bytes at the front of the arena
+    size_t arenaRecords;        // Pointers at the back of the arena
+    FILE *spill[2];             // Unnamed temporary files: runs are merged from the first into the second
+    uint64_t spillBytes;        // Bytes written to the spill file being filled
+    SortRun *runs;              // Runs in spill[0], in the order they were written
+    int runCount;
+    int runCapacity;
+    int passes;                 // Merge passes over the data, the final one included
+    long records;               // Rows read and kept
+    long rejected;              // Rows written to the reject report
+    CourseAggregate *aggregates;    // Per-course statistics when they are asked for
+    Distribution *distributions;    // Per-course histograms, then the totals'
+} ExternalJob;
+
+typedef struct {
+    Student student;            // The parsed row, when reason is NULL
+    const char *reason;         // Why the row was rejected, NULL if it parsed
+    const char *line;           // The row's text in its chunk, for the reject report
+    int length;
+    int lineIndex;              // Line of the chunk the row is on, from 0
+} ParsedRow;
+
+typedef struct {
+    char *text;                 // Whole lines copied from the read buffer, each ending in '\n'
+    size_t length;
+    size_t capacity;
+    int tooLong;                // Stands for one line too long for the read buffer, instead of text
+    int lineCount;              // Lines in text, blank ones included; set by the parser
+    ParsedRow *rows;            // The non-blank lines in order, set by the parser
+    int rowCount;
+    int rowCapacity;
+    int outOfMemory;            // The parser could not grow rows
+} ImportChunk;
+
+typedef struct {
+    ImportChunk **slots;
+    unsigned long mask;         // Slot count minus one; the slot count is a power of two
+    unsigned long head;         // Next slot to take; only the consumer writes it
+    unsigned long tail;         // Next slot to fill; only the producer writes it
+} ChunkRing;                    // Bounded single-producer, single-consumer queue without locks
+
+typedef struct {
+    struct ImportPipeline *pipeline;
+    int index;                  // Which ring pair the parser serves
+    pthread_t thread;
+} ImportParser;
+
+typedef struct ImportPipeline {
+    StudentTable *table;
+    StudentTable shape;         // Course count and score layout the parsers check rows against
+    int parserCount;
+    ImportParser *parsers;
+    pthread_t inserter;
+    ChunkRing *toParser;        // Reader to parser k: chunks k, k + parserCount, k + 2 * parserCount, ...
+    ChunkRing *toInserter;      // Parser k to the inserter, in the same order
+    ChunkRing freeChunks;       // Inserter back to the reader, chunks ready for reuse
+    ImportChunk *chunks;        // Every chunk, IMPORT_CHUNKS_PER_PARSER per parser
+    int chunkCount;
+    ImportChunk *filling;       // Chunk the reader is copying lines into
+    unsigned long sequence;     // Chunks sent to the parsers so far
+    ImportSummary *summary;     // Line and row counts, kept by the inserter while the pipeline runs
+    const char *rejectPath;
+    FILE **rejects;
+    int failed;                 // Set by the inserter when memory runs out; the reader then stops
+} ImportPipeline;
+
+typedef struct {
+    int64_t sum;                // Tenths for the courses of a tenths table, else 1/2^32-point units
+    float lowest;               // Smallest value
+    float highest;              // Largest value
+    long bands[GRADE_BANDS];    // Values per grade band, F first
+} GroupCell;
+
+typedef struct {
+    uint64_t *keys;             // Attribute codes of each group, 16 bits apiece, in the order first seen
+    long *counts;               // Rows in each group
+    GroupCell *cells;           // [group][field]: each course, then the average
+    int groupCount;
+    int groupCapacity;
+    int *slots;                 // Hash of the keys: group + 1 in each slot, 0 when empty
+    uint32_t slotMask;          // Slot count minus one
+    int failed;                 // Memory ran out
+} GroupPart;                    // One thread's share of a group report
+
+typedef struct {
+    const StudentTable *table;
+    int attributes[MAX_ATTRIBUTES];     // Attributes grouped by, first one in the key's top bits
+    int attributeCount;
+    int fieldCount;             // Courses plus the average
+    int *rowGroups;             // Group of every row in its part's hash table
+    GroupPart *parts;
+    float tenthsScores[SCORE_BINS];     // Score and grade band of each count of tenths
+    unsigned char tenthsBands[SCORE_BINS];
+} GroupJob;
+
+typedef struct {
+    uint64_t sortKey;           // Value ranks of the group's attributes, 16 bits apiece
+    int group;
+} GroupOrder;
+
+typedef struct {
+    int attributes[MAX_ATTRIBUTES];
+    int attributeCount;
+    int fieldCount;             // Courses plus the average
+    int tenths;                 // Course sums are in tenths
+    int groupCount;
+    uint64_t *keys;             // Groups in value order: by the first attribute, then the next
+    long *counts;
+    GroupCell *cells;           // [group][field]
+} GroupReport;
+
+typedef enum {
+    TERM_BLOCK_IDS,             // IDs of the students first seen this term, ascending, as varint gaps
+    TERM_BLOCK_NAMES,           // Names of new and renamed students: key gap, length, bytes
+    TERM_BLOCK_MEMBERS,         // Earlier students who left or came back, as key gaps
+    TERM_BLOCK_COURSES          // Then one block per course: key gap and score change of every changed score
+} TermBlockKind;
+
+typedef struct {
+    char magic[8];              // HISTORY_MAGIC
+    uint32_t version;           // HISTORY_VERSION
+    uint32_t headerSize;        // sizeof(HistoryHeader)
+    uint32_t courseCount;       // Courses every term in the file has
+    uint32_t reserved;
+} HistoryHeader;                // Followed by the terms, oldest first
+
+typedef struct {
+    uint32_t magic;             // TERM_MAGIC
+    uint32_t blockCount;        // TERM_BLOCK_COURSES + the course count
+    char name[TERM_NAME_LEN];   // As given when the term was closed
+    uint32_t keyCount;          // Students seen in this or an earlier term; each keeps its key for good
+    uint32_t memberCount;       // Students on this term's roster
+    uint64_t changeCount;       // Scores stored because they differ from the student's previous ones
+} TermHeader;                   // Followed by blockCount TermBlocks, then the blocks in order
+
+typedef struct {
+    uint32_t size;              // Bytes in the block
+    uint32_t checksum;          // journalChecksum of those bytes
+} TermBlock;
+
+typedef struct {
+    TermHeader header;
+    TermBlock blocks[TERM_BLOCK_COURSES + MAX_COURSES];
+    off_t offset;               // Where the term's first block starts in the file
+    uint32_t firstKey;          // Keys of the students first seen this term start here
+} TermInfo;
+
+typedef struct {
+    int fd;                     // Open history file, -1 until it is first used
+    char path[1024];            // <snapshot>.history or --history; empty when there is none
+    int courseCount;            // 0 while the file holds no term
+    int termCount;
+    int termCapacity;
+    TermInfo *terms;            // Index of the terms, read once when the file is opened
+    off_t validEnd;             // End of the last whole term; a torn one after it is overwritten
+    pthread_mutex_t lock;       // Server clients may read and close terms at the same time
+} TermHistory;
+
+typedef struct {
+    unsigned char *bytes;
+    size_t used;
+    size_t capacity;
+    int failed;                 // Set once memory ran out; later appends are dropped
+} ByteBuffer;
+
+typedef struct {
+    int term;                   // Terms applied so far
+    uint32_t keyCount;          // Students seen in those terms
+    uint32_t capacity;          // Students the arrays have room for
+    long memberCount;           // Students on the roster of the last applied term
+    int wantIds;
+    int wantNames;
+    uint64_t courseMask;        // Courses decoded; the others' blocks are never read
+    uint8_t *members;           // 1 for each student on that roster
+    long *ids;                  // Each student's ID, if wanted
+    uint32_t *nameOffsets;      // Each student's latest name in names, if wanted
+    ByteBuffer names;
+    float *scores[MAX_COURSES]; // Each student's latest score per decoded course, 0 before their first term
+    double sums[MAX_COURSES];   // Each decoded course summed over the roster
+    ByteBuffer block;           // The block being decoded
+} TermCursor;                   // Replays a term history one term at a time
+
+typedef struct {
+    uint32_t key;
+    long id;
+    float before;
+    float after;
+} ImproverCandidate;
+
+typedef struct {
+    long id;
+    char name[MAX_NAME_LEN];    // Name in the later of the two terms
+    float before;               // Field value in the "from" term
+    float after;                // Field value in the "to" term
+} TermImprover;
+
+// Function declarations
+int showMenu(void);
+void showHelp();
+int inputStudentData(StudentTable *table, int studentCount);
+void showCourseStatistics(StudentTable *table);
+void showStudentStatistics(StudentTable *table);
+int sortByTotalScore(StudentTable *table, int descending);
+int sortByStudentId(StudentTable *table);
+int sortByStudentName(StudentTable *table);
+void searchByStudentId(StudentTable *table);
+void searchByStudentName(StudentTable *table);
+void showGradeStatistics(StudentTable *table);
+void displayAllStudents(StudentTable *table);
+void clearInputBuffer();
+int isValidStudentName(const char *name);
+int initStudentTable(StudentTable *table, int courseCount);
+void freeStudentTable(StudentTable *table);
+int reserveStudentRows(StudentTable *table, int minCapacity);
+int appendStudent(StudentTable *table, const Student *student);
+const int *listingOrder(StudentTable *table);
+void printStudentRecord(const StudentTable *table, int row);
+int importStudentsCsv(StudentTable *table, const char *path, const char *rejectPath, ImportSummary *summary);
+int parseStudentCsvLine(char *line, char *end, const StudentTable *table, Student *student, const char **reason);
+int parseScoreField(const char *start, const char *end, float *value);
+int parseIdField(const char *start, const char *end, long *value);
+int countCsvFields(const char *line, const char *end);
+int isHeaderLine(const char *line, const char *end);
+double elapsedSeconds(const struct timespec *start);
+uint64_t updateChecksum(uint64_t lanes[4], const void *data, size_t size);
+uint64_t finishChecksum(const uint64_t lanes[4]);
+size_t snapshotSize(size_t headerBlock, int courseCount, size_t recordCount, size_t nameWidth, size_t scoreSize,
+                    int attributeCount, size_t dictionaryBytes, size_t arenaBytes);
+int saveSnapshot(const StudentTable *table, const char *path);
+int loadSnapshot(StudentTable *table, const char *path, int verifyData);
+int detachMappedColumns(StudentTable *table, int newCapacity);
+int findStudentById(StudentTable *table, long id);
+int buildIdIndex(StudentTable *table, int minCount);
+void freeIdIndex(IdIndex *index);
+int idIndexHome(const IdIndex *index, long id);
+int insertIdIndex(StudentTable *table, int row);
+int idIndexSlot(const StudentTable *table, int row);
+void removeIdIndex(StudentTable *table, long id);
+void clearStudentRows(StudentTable *table);
+const int *getSortedView(StudentTable *table, ViewKind kind);
+int sortViewRows(const StudentTable *table, ViewKind kind, int *rows, int n);
+int radixSortRows(uint64_t *keys, int *rows, int n, int keyBytes);
+void mergeSortRowsByName(const StudentTable *table, int *rows, int *scratch, int n);
+uint32_t floatSortKey(float value);
+int findNameRange(StudentTable *table, const char *name, int prefixOnly, int *first, int *last);
+int fuzzySearchNames(StudentTable *table, const char *query, int maxDistance, NameMatch **matches);
+int foldedPrefixLength(const char *a, const char *b);
+int defaultFuzzyDistance(const char *query);
+int64_t scoreToFixed(float score);
+int gradeBand(float score);
+void computeCourseAggregate(const StudentTable *table, int course, CourseAggregate *aggregate);
+int64_t squareToFixed(float score);
+int64_t roundToInt64(double value);
+void aggregateColumnScalar(const float *column, int n, CourseAggregate *aggregate);
+void aggregateColumnSse2(const float *column, int n, CourseAggregate *aggregate);
+void aggregateColumnAvx2(const float *column, int n, CourseAggregate *aggregate);
+int selectStatisticsKernel(const char *requested);
+int startWorkerPool(int threadCount);
+void stopWorkerPool(void);
+void *workerMain(void *argument);
+void runParallel(RangeTask task, void *context, int rowCount);
+void partRange(int rowCount, int part, int parts, int *begin, int *end);
+void aggregateRangeTask(void *context, int part, int begin, int end);
+void aggregateCourses(const StudentTable *table, int firstCourse, int courseCount, CourseAggregate *out);
+void mergeCourseAggregate(CourseAggregate *into, const CourseAggregate *part);
+long recomputeStudentTotals(StudentTable *table, int repair);
+void totalsRangeTask(void *context, int part, int begin, int end);
+void printReportTiming(const struct timespec *began);
+float rankingScore(const StudentTable *table, int course, int row);
+int selectTopRows(StudentTable *table, int course, int k, int descending, int *out);
+void siftDownWorst(uint32_t *keys, int *rows, int size, int at, int descending);
+int rankedBefore(uint32_t keyA, int rowA, uint32_t keyB, int rowB, int descending);
+void countAroundTotal(StudentTable *table, float total, long *greater, long *equal);
+void showTopStudents(StudentTable *table);
+void showStudentRank(StudentTable *table);
+int scoreBin(float score);
+int sketchBucket(float value);
+float sketchBucketValue(int bucket);
+void updateDistribution(Distribution *distribution, float value, int bin, long delta);
+int buildDistributions(const StudentTable *table, Distribution *out);
+void distributionRangeTask(void *context, int part, int begin, int end);
+void mergeDistribution(Distribution *into, const Distribution *part);
+void freeDistributions(Distribution *distributions, int fieldCount);
+int fillSketch(Distribution *distribution, const StudentTable *table, int field);
+const Distribution *getDistribution(StudentTable *table, int course);
+int distributionIsExact(const Distribution *distribution);
+double distributionValueAtRank(const Distribution *distribution, long rank);
+double distributionQuantile(const Distribution *distribution, double probability);
+double distributionStdDev(const Distribution *distribution);
+void printDistribution(const Distribution *distribution);
+int verifyDistributions(StudentTable *table);
+long runBatch(StudentTable *table, FILE *in, FILE *out, const char *snapshotPath);
+int runBatchCommand(BatchSession *session, char *line);
+int batchError(BatchSession *session, const char *format, ...);
+void writeBatchRecord(BatchSession *session, int row);
+int batchLoad(BatchSession *session, const char *path);
+int batchSave(BatchSession *session, const char *path);
+int batchSort(BatchSession *session, char **args, int argCount);
+int batchList(BatchSession *session, long limit);
+int batchTop(BatchSession *session, char **args, int argCount);
+int batchRank(BatchSession *session, const char *idText);
+int batchFindId(BatchSession *session, const char *idText);
+int batchFindName(BatchSession *session, char *query);
+int batchStats(BatchSession *session, char **args, int argCount);
+int batchGrades(BatchSession *session);
+int batchExport(BatchSession *session, const char *path);
+long exportStudentsCsv(StudentTable *table, const char *path);
+int parseColumnList(const char *list, ListingOptions *options);
+int showListingColumn(const ListingOptions *options, int column);
+char *renderStudentRow(const StudentTable *table, const ListingOptions *options, int row, char *out);
+char *formatFixed(char *out, float value, int decimals, int width);
+char *formatLeft(char *out, const char *text, size_t length, int width);
+void promptStudentRecord(StudentTable *table, Student *student);
+void promptStudentName(char *name);
+void promptScore(const StudentTable *table, int course, float *score);
+int insertStudent(StudentTable *table, const Student *student);
+void updateStudentScore(StudentTable *table, int row, int course, float score);
+void renameStudent(StudentTable *table, int row, const char *name);
+void deleteStudent(StudentTable *table, int row);
+int currentViews(const StudentTable *table);
+void refreshViews(StudentTable *table, int current, int affected, int row);
+int viewRowBefore(const StudentTable *table, ViewKind kind, int a, int b);
+int viewPosition(const StudentTable *table, ViewKind kind, int row, int n);
+int mergePendingViewRows(StudentTable *table, ViewKind kind);
+int queuePendingRow(PendingRows *pending, int row, int limit);
+void addOneStudent(StudentTable *table);
+int promptExistingStudent(StudentTable *table);
+void editStudentScore(StudentTable *table);
+void editStudentName(StudentTable *table);
+void removeStudent(StudentTable *table);
+int batchInsert(BatchSession *session, char *record);
+int batchUpdate(BatchSession *session, char **args);
+int batchRename(BatchSession *session, const char *idText, const char *name);
+int batchDelete(BatchSession *session, const char *idText);
+long openJournal(StudentTable *table, const char *snapshotPath, int replay);
+void closeJournal(void);
+int createJournal(const char *path, uint64_t generation);
+long replayJournal(StudentTable *table, const char *path, uint64_t minGeneration, off_t *validEnd);
+int applyJournalRecord(StudentTable *table, const unsigned char *payload, uint32_t size, uint32_t version);
+int journalAppend(const unsigned char *payload, uint32_t size);
+int journalSync(void);
+void *journalFlusherMain(void *argument);
+void journalInsert(const StudentTable *table, int row);
+void journalUpdate(int64_t id, int course, float score);
+void journalRename(int64_t id, const char *name);
+void journalDelete(int64_t id);
+void journalReset(const StudentTable *table);
+uint32_t journalChecksum(const unsigned char *data, uint32_t size);
+int checkpointTable(StudentTable *table, const char *path);
+uint64_t nextGeneration(const StudentTable *table);
+void maybeCompactJournal(StudentTable *table);
+void *compactorMain(void *argument);
+void finishCompaction(void);
+int copyStudentTable(const StudentTable *source, StudentTable *copy);
+int writeAll(int fd, const void *data, size_t size);
+void syncParentDirectory(const char *path);
+uint64_t nextRandom(uint64_t *state);
+double randomUnit(uint64_t *state);
+void randomStudentName(uint64_t *state, char *name);
+float randomScore(uint64_t *state, double mean, double spread);
+int generateRoster(const char *path, long studentCount, int courseCount, int sectionCount, uint64_t seed);
+int silenceStdout(void);
+void restoreStdout(int saved);
+void dropDerivedData(StudentTable *table);
+double timeBenchOperation(StudentTable *table, BenchOperation operation);
+void reportBenchmark(FILE *out, long records, const char *operation, double *samples, int count,
+                     double itemsPerSample);
+int runBenchmarks(const char *sizes, int courseCount, uint64_t seed, const char *outputPath);
+int compareDoubles(const void *a, const void *b);
+void enableOperationStats(void);
+ssize_t countOutputBytes(void *cookie, const char *data, size_t size);
+void beginOperation(OperationTimer *timer);
+void endOperation(const OperationTimer *timer, int slot, long records);
+void recordOperation(int slot, double seconds, long records, uint64_t bytes);
+int latencyBucket(uint64_t nanos);
+double latencyBucketValue(int bucket);
+double latencyPercentile(const OperationStats *stats, double fraction);
+const char *operationName(int slot);
+int batchCommandSlot(const char *line);
+int writeOperationStats(FILE *out, int tabSeparated);
+void showOperationStats(void);
+int batchOperationStats(BatchSession *session);
+long menuRecordsTouched(const StudentTable *table, int choice, int studentCount);
+const char *studentName(const StudentTable *table, int row);
+const char *foldedName(const StudentTable *table, int row);
+int storeName(StudentTable *table, const char *name, NameRef *ref);
+void releaseName(StudentTable *table, NameRef ref);
+int growNameIntern(StudentTable *table, int seedFromRows);
+uint32_t nameHash(const char *name, size_t length);
+int compactNameArena(StudentTable *table, int force);
+void foldName(const char *name, size_t length, char *out);
+int utf8SequenceLength(const unsigned char *text);
+int validArenaName(const NameArena *arena, NameRef ref, uint64_t *checked);
+int totalBin(const StudentTable *table, int row);
+int scoresTotalBin(const float *scores, int courseCount);
+unsigned int utf8CodePoint(const unsigned char *text, int length);
+int isNameLetter(unsigned int codePoint);
+void reserveImportRows(StudentTable *table, long long fileBytes, long lineBytes);
+int parsePlainCsvLine(const char *p, const char *end, const StudentTable *table, Student *student);
+int displayWidth(const char *text, size_t length);
+int namePadding(const char *name, int width);
+int insideMapping(const StudentTable *table, const void *pointer);
+int runServer(StudentTable *table, const char *socketPath, const char *snapshotPath);
+void handleServerSignal(int signalNumber);
+void *serverClientMain(void *argument);
+int serverCommandKind(const char *line);
+int submitServerWrite(BatchSession *session, char *line);
+void *serverWriterMain(void *argument);
+int prepareForReaders(StudentTable *table);
+void writeBatchStatus(BatchSession *session, int status);
+int connectServer(const char *socketPath);
+long runClient(const char *socketPath, FILE *in, FILE *out);
+int readServerReply(FILE *replies, FILE *out);
+int runLoadGenerator(const char *socketPath, int clientCount, double seconds, int writePercent, uint64_t seed);
+void *loadClientMain(void *argument);
+size_t scoreWidth(const StudentTable *table);
+float scoreAt(const StudentTable *table, int course, int row);
+void setScore(StudentTable *table, int course, int row, float score);
+float tenthsValue(int tenths);
+float tenthsTotal(const StudentTable *table, int row);
+void countTenths(const uint16_t *column, int n, long *counts);
+void aggregateTenths(const uint16_t *column, int n, CourseAggregate *aggregate);
+int rangeSlot(const StudentTable *table, int field);
+uint32_t rangeKey(const StudentTable *table, int slot, int row);
+const RangeIndex *getRangeIndex(StudentTable *table, int slot);
+uint64_t currentRangeIndexes(const StudentTable *table);
+void refreshRangeIndexes(StudentTable *table, uint64_t current, uint64_t affected, int row);
+int rangeEntryPosition(const RangeIndex *index, uint32_t key, int row, int n);
+int mergePendingRangeRows(StudentTable *table, int slot);
+int settlePendingRows(PendingRows *pending, int n, uint64_t **changed);
+void findRangeEntries(const RangeIndex *index, int n, uint32_t lowKey, uint32_t highKey, int *first, int *last);
+int parseRangeQuery(const StudentTable *table, char **words, int wordCount, RangeQuery *query, const char **reason);
+int rowMatchesCondition(const StudentTable *table, const RangeCondition *condition, int row);
+long runRangeQuery(StudentTable *table, const RangeQuery *query, int **matches);
+int batchWhere(BatchSession *session, char **args, int argCount);
+void showRangeQuery(StudentTable *table);
+void printListingHeader(const StudentTable *table, const ListingOptions *options);
+int verifyRangeIndexes(StudentTable *table);
+void addScoreToAggregate(CourseAggregate *course, float score);
+void printCourseSummary(int course, const CourseAggregate *aggregate, const Distribution *distribution);
+void writeScoreField(FILE *file, float score);
+long parseMemorySize(const char *text);
+int readCsvLine(CsvLineReader *reader, char **line, char **end);
+size_t makeRunRecord(const ExternalJob *job, const Student *student, uint64_t sequence, RunRecord *out);
+size_t runRecordSize(int courseCount, size_t nameLength, size_t foldedLength);
+int compareRunRecords(const RunRecord *a, const RunRecord *b, int courseCount);
+int compareRunPointers(const void *a, const void *b);
+int writeRunRecord(ExternalJob *job, const RunRecord *record, FILE *file, int asCsv);
+FILE *openSpillFile(const char *directory, char *buffer);
+int spillRun(ExternalJob *job, FILE *output);
+int loadRunRecord(RunReader *reader);
+int runReaderBefore(const RunReader *readers, int a, int b, int courseCount);
+void buildTournament(int *tree, const RunReader *readers, int k, int courseCount);
+void replayTournament(int *tree, const RunReader *readers, int k, int leaf, int courseCount);
+int mergeRuns(ExternalJob *job, const SortRun *runs, int k, size_t bufferSize, FILE *to, int asCsv);
+int mergeAllRuns(ExternalJob *job, FILE *output);
+void printExternalStatistics(const ExternalJob *job);
+int runExternalJob(const char *inputPath, const char *outputPath, ViewKind order, int withStats,
+                   size_t memoryLimit, const char *tempDir, const char *rejectPath);
+int applyImportRow(StudentTable *table, const Student *student, const char *reason, const char *line, int length,
+                   ImportSummary *summary, const char *rejectPath, FILE **rejects);
+void ringBackoff(int *attempts);
+int initChunkRing(ChunkRing *ring, int minSlots);
+void pushChunk(ChunkRing *ring, ImportChunk *chunk);
+ImportChunk *popChunk(ChunkRing *ring);
+void parseImportChunk(const StudentTable *shape, ImportChunk *chunk);
+void *importParserMain(void *arg);
+void *importInserterMain(void *arg);
+int startImportPipeline(ImportPipeline *pipeline, StudentTable *table, ImportSummary *summary,
+                        const char *rejectPath, FILE **rejects, int parserCount);
+void dispatchImportChunk(ImportPipeline *pipeline);
+int queueImportLines(ImportPipeline *pipeline, const char *start, const char *end);
+void queueTooLongLine(ImportPipeline *pipeline);
+int finishImportPipeline(ImportPipeline *pipeline);
+void freeImportPipeline(ImportPipeline *pipeline);
+int parseAttributeList(const char *list);
+const char *attributeValue(const StudentTable *table, int attribute, int row);
+int findAttribute(const StudentTable *table, const char *name);
+uint32_t attributeHash(const char *text);
+int internAttributeValue(AttributeColumn *column, const char *value);
+int isValidAttributeValue(const char *text);
+const char *parseAttributeField(const char *field, const char *end, char *value);
+void promptAttributeValues(const StudentTable *table, Student *student);
+void freeAttributeColumns(StudentTable *table);
+int copyAttributeDictionaries(const StudentTable *source, StudentTable *copy);
+char *encodeAttributeDictionary(const StudentTable *table, size_t *size);
+int decodeAttributeDictionary(StudentTable *table, const char *blob, size_t size, int attributeCount);
+int parseGroupAttributes(const StudentTable *table, const char *list, int *attributes, const char **reason);
+int findGroup(GroupPart *part, uint64_t key);
+int allocateGroupCells(GroupPart *part, int fieldCount);
+void groupRangeTask(void *context, int part, int begin, int end);
+int compareGroupOrders(const void *a, const void *b);
+int compareAttributeValues(const void *a, const void *b);
+int runGroupReport(const StudentTable *table, const int *attributes, int attributeCount, GroupReport *report);
+void freeGroupPart(GroupPart *part);
+void freeGroupReport(GroupReport *report);
+double groupMean(const GroupReport *report, int group, int field);
+void groupLabel(const StudentTable *table, const GroupReport *report, int group, const char *none, char *label,
+                size_t size);
+void showGroupReport(StudentTable *table);
+int batchGroup(BatchSession *session, char **args, int argCount);
+size_t runRecordTextLength(const ExternalJob *job, const Student *student);
+unsigned char *reserveBytes(ByteBuffer *buffer, size_t extra);
+void putBytes(ByteBuffer *buffer, const void *data, size_t size);
+void putVarint(ByteBuffer *buffer, uint64_t value);
+int getVarint(const unsigned char **cursor, const unsigned char *end, uint64_t *value);
+int historyTenths(float score);
+void putScoreChange(ByteBuffer *block, uint32_t gap, float before, float after);
+int getScoreChange(const unsigned char **cursor, const unsigned char *end, float before, float *after);
+int skipScoreChange(const unsigned char **cursor, const unsigned char *end);
+uint64_t termBytes(const TermInfo *info);
+int openTermHistory(int create, const char **reason);
+void closeTermHistory(void);
+int findTerm(const char *text);
+int loadTermBlock(int term, int block, ByteBuffer *into);
+void startTermCursor(TermCursor *cursor, int wantIds, int wantNames, uint64_t courseMask);
+int growTermCursor(TermCursor *cursor, uint32_t keyCount);
+int advanceTermCursor(TermCursor *cursor);
+void freeTermCursor(TermCursor *cursor);
+float historyTotal(const float *scores, int courseCount);
+float termFieldValue(const TermCursor *cursor, uint32_t key, int field);
+int compareLongs(const void *a, const void *b);
+int closeTerm(StudentTable *table, const char *name, TermInfo *closed, const char **reason);
+int termStudentHistory(long id, Student **records, uint8_t **present, const char **reason);
+int termFieldMeans(int field, double **means, long **counts, const char **reason);
+int compareImprovers(const void *a, const void *b);
+int termImprovers(int from, int to, int field, int k, TermImprover **out, const char **reason);
+int listTerms(TermInfo **terms, const char **reason);
+int parseTermField(char **args, int argCount, int *field);
+int batchTerm(BatchSession *session, char **args, int argCount);
+void showTermHistory(StudentTable *table);
+int ensureAggregates(StudentTable *table);
+void addRowToAggregates(StudentTable *table, int row);
+void removeRowFromAggregates(StudentTable *table, int row);
+const CourseAggregate *getCourseAggregate(StudentTable *table, int course);
+int verifyAggregates(StudentTable *table);
+int hasDataBeenEntered = 0;  // Global flag to track if data exists
+int hasUnsavedChanges = 0;   // Global flag set whenever the table changes after a save
+int selfCheckEnabled = 0;    // Debug mode: recompute aggregates after every menu action
+void (*aggregateColumn)(const float *, int, CourseAggregate *) = aggregateColumnScalar;  // Chosen at startup
+const char *statisticsKernelName = "scalar";
+WorkerPool workerPool;       // Shared analytics workers, started in main
+ListingOptions listingOptions;  // Paging and columns for full listings, set from the command line
+int statsEnabled = 0;        // Operation statistics are collected only when this is set
+uint64_t outputBytes = 0;    // Bytes written to stdout while statistics are on
+OperationStats operationStats[STAT_SLOTS];
+const char *batchCommandNames[BATCH_COMMAND_COUNT] = {
+    "load", "save", "insert", "count", "sort", "list", "top", "bottom", "rank", "find", "stats", "grades",
+    "export", "update", "rename", "delete", "where", "group", "term", "other"
+};
+int internNames = 1;         // Share one arena copy between students with the same name (--no-intern)
+int compactScores = 0;       // New tables keep scores as tenths of a point (--compact-scores)
+int attributeSchemaCount = 0;    // Attribute columns new tables get (--attributes)
+char attributeSchema[MAX_ATTRIBUTES][ATTRIBUTE_NAME_LEN];
+long maxStudentId = MAX_STUDENT_ID;  // Raised by --max-id for generated rosters past 9000 students
+Journal journal = {.fd = -1, .limit = JOURNAL_DEFAULT_LIMIT};  // Write-ahead log of changes since the snapshot
+QueryServer server = {.listenFd = -1};  // Shared state of --serve
+volatile sig_atomic_t serverStopping = 0;   // Set by SIGINT or SIGTERM while serving
+int externalCourseCount = 0; // Course count compareRunPointers sorts by; qsort passes it no context
+ImportChunk importEndMarker; // Sent through the import rings after the last chunk
+TermHistory history = {.fd = -1, .lock = PTHREAD_MUTEX_INITIALIZER};  // Terms closed so far (menu option 23, "term")
+pthread_mutex_t statsLock = PTHREAD_MUTEX_INITIALIZER;  // Server clients record statistics concurrently
+
+// Function 1: Display main menu
+int showMenu(void) {
+    int choice;
+
+    printf("\n============================================\n");
+    printf("        STUDENT MANAGEMENT SYSTEM\n");
+    printf("============================================\n");
+    printf("1. Show Instructions\n");
+    printf("2. Enter Student Data\n");
+    printf("3. Show Course Statistics\n");
+    printf("4. Show Student Statistics\n");
+    printf("5. Sort: Highest to Lowest Scores\n");
+    printf("6. Sort: Lowest to Highest Scores\n");
+    printf("7. Sort by Student ID\n");
+    printf("8. Sort by Student Name\n");
+    printf("9. Search by Student ID\n");
+    printf("10. Search by Student Name\n");
+    printf("11. Show Grade Distribution\n");
+    printf("12. Display All Students\n");
+    printf("13. Save Snapshot\n");
+    printf("14. Top/Bottom Students\n");
+    printf("15. Student Rank and Percentile\n");
+    printf("16. Add One Student\n");
+    printf("17. Update a Score\n");
+    printf("18. Rename a Student\n");
+    printf("19. Delete a Student\n");
+    printf("20. Operation Statistics\n");
+    printf("21. Find Students by Score Range\n");
+    printf("22. Group Statistics by Section or Year\n");
+    printf("23. Term History\n");
+    printf("0. Exit Program\n");
+    printf("============================================\n");
+    printf("Enter your choice (0-%d): ", MENU_MAX_CHOICE);
+
+    if (scanf("%d", &choice) != 1) {
+        clearInputBuffer();
+        return -1;
+    }
+    return choice;
+}
+
+// Function 2: Show instructions
+void showHelp() {
+    printf("\n============================================\n");
+    printf("                INSTRUCTIONS\n");
+    printf("============================================\n");
+    printf("1. Any number of students and up to 40 courses\n");
+    printf("2. Student ID must be 4 digits (1000-9999)\n");
+    printf("3. Student name: letters and spaces only\n");
+    printf("4. Scores must be between 0 and 100\n");
+    printf("5. Data is saved to a snapshot on exit (Option 13 saves now)\n");
+    printf("6. You can use menu options in any order\n");
+    printf("7. Name search: Jo* matches names starting with Jo,\n");
+    printf("   ~Jon also matches similar spellings\n");
+    printf("============================================\n");
+}
+
+// Function 3: Clear input buffer
+void clearInputBuffer() {
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF);
+}
+
+// Function 4: Validate student name
+int isValidStudentName(const char *name) {
+    const unsigned char *text = (const unsigned char *)name;
+    unsigned int codePoint;
+    int i, length;
+
+    // Check if name is empty
+    if (strlen(name) == 0) {
+        return 0;
+    }
+
+    // Check each character
+    for (i = 0; text[i] != '\0'; i += length) {
+        // A non-ASCII character must be a well-formed letter; an accent mark may follow one
+        if (text[i] >= 0x80) {
+            if ((length = utf8SequenceLength(text + i)) == 0) {
+                return 0;
+            }
+            codePoint = utf8CodePoint(text + i, length);
+            if (codePoint >= 0x300 && codePoint <= 0x36F) {
+                if (i == 0 || text[i - 1] == ' ' || text[i - 1] == '-') {
+                    return 0;
+                }
+            } else if (!isNameLetter(codePoint)) {
+                return 0;
+            }
+            continue;
+        }
+        length = 1;
+
+        // Allow only letters, spaces, and hyphens
+        if (!isalpha(text[i]) && text[i] != ' ' && text[i] != '-') {
+            return 0;
+        }
+
+        // Check for consecutive spaces
+        if (text[i] == ' ' && text[i + 1] == ' ') {
+            return 0;
+        }
+    }
+
+    // Name must start with a letter
+    if (text[0] < 0x80 && !isalpha(text[0])) {
+        return 0;
+    }
+
+    return 1;
+}
+
+// Function 5: Input student data
+int inputStudentData(StudentTable *table, int studentCount) {
+    int i;
+    char confirm;
+    Student student;
+
+    // Check if data already exists
+    if (hasDataBeenEntered) {
+        printf("\nWARNING: Student data already exists!\n");
+        printf("Entering new data will overwrite existing records.\n");
+        printf("Do you want to continue? (y/n): ");
+        clearInputBuffer();
+        scanf("%c", &confirm);
+        if (confirm != 'y' && confirm != 'Y') {
+            printf("Data entry cancelled.\n");
+            return 0;
+        }
+    }
+
+    if (!reserveStudentRows(table, studentCount)) {
+        printf("ERROR: Not enough memory for %d students.\n", studentCount);
+        return 0;
+    }
+    clearStudentRows(table);
+    journalReset(table);
+
+    printf("\n============================================\n");
+    printf("          ENTER STUDENT INFORMATION\n");
+    printf("============================================\n");
+
+    for (i = 0; i < studentCount; i++) {
+        printf("\n--- Student %d ---\n", i + 1);
+
+        promptStudentRecord(table, &student);
+        insertStudent(table, &student);
+    }
+
+    hasDataBeenEntered = 1;
+    hasUnsavedChanges = 1;
+    printf("\nSUCCESS: %d student records have been saved.\n", studentCount);
+    return 1;
+}
+
+// Function 6: Display all students in a clean table
+void displayAllStudents(StudentTable *table) {
+    const ListingOptions *options = &listingOptions;
+    int row, courseCount = table->courseCount;
+    long i, first = 0, last = table->count, pages = 1;
+    const int *order = listingOrder(table);
+    char *buffer, *out;
+
+    if (table->count <= 0) {
+        printf("\nERROR: No student data available.\n");
+        printf("Please enter student data first (Option 2).\n");
+        return;
+    }
+
+    // Only the requested page is formatted; rows before it are skipped by index
+    if (options->pageSize > 0) {
+        pages = (table->count + options->pageSize - 1) / options->pageSize;
+        if (options->page > pages) {
+            printf("\nERROR: Page %ld is past the last page (%ld).\n", options->page, pages);
+            return;
+        }
+        first = (options->page - 1) * options->pageSize;
+        if (last > first + options->pageSize) last = first + options->pageSize;
+    }
+    if ((buffer = malloc(RENDER_BUFFER_SIZE)) == NULL) {
+        printf("\nERROR: Not enough memory.\n");
+        return;
+    }
+
+    printf("\n=========================================================================================================\n");
+    printf("                                     STUDENT RECORDS\n");
+    printf("=========================================================================================================\n");
+
+    // Print table header
+    printListingHeader(table, options);
+
+    // Rows are formatted into one large buffer and written out in big blocks
+    out = buffer;
+    for (i = first; i < last; i++) {
+        row = order ? order[i] : (int)i;
+        out = renderStudentRow(table, options, row, out);
+        if (out - buffer > RENDER_BUFFER_SIZE - RENDER_ROW_MAX) {
+            fwrite(buffer, 1, out - buffer, stdout);
+            out = buffer;
+        }
+    }
+    fwrite(buffer, 1, out - buffer, stdout);
+    free(buffer);
+
+    printf("=========================================================================================================\n");
+    printf("Total Students: %d, Total Courses: %d\n", table->count, courseCount);
+    if (options->pageSize > 0) {
+        printf("Showing rows %ld-%ld (page %ld of %ld)\n", first + 1, last, options->page, pages);
+    }
+}
+
+// Function 7: Calculate course statistics
+void showCourseStatistics(StudentTable *table) {
+    const Distribution *distribution;
+    int j;
+    int studentCount = table->count, courseCount = table->courseCount;
+    struct timespec began;
+
+    if (studentCount <= 0) {
+        printf("\nERROR: No data available.\n");
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    if (!ensureAggregates(table)) {
+        printf("\nERROR: Not enough memory.\n");
+        return;
+    }
+
+    printf("\n============================================\n");
+    printf("            COURSE STATISTICS\n");
+    printf("============================================\n");
+
+    // Running aggregates make this O(courses) instead of a rescan of every student
+    for (j = 0; j < courseCount; j++) {
+        const CourseAggregate *course = getCourseAggregate(table, j);
+
+        if ((distribution = getDistribution(table, j)) == NULL) {
+            printf("\nERROR: Not enough memory.\n");
+            return;
+        }
+        printCourseSummary(j, course, distribution);
+    }
+
+    // Totals have their own exact bins, up to 100 points per course
+    if ((distribution = getDistribution(table, RANK_BY_TOTAL)) == NULL) {
+        printf("\nERROR: Not enough memory.\n");
+        return;
+    }
+    printf("\nTotal Score per Student:\n");
+    printf("  Average Score: %.2f\n", distribution->sum / DISTRIBUTION_SUM_ONE / distribution->count);
+    printDistribution(distribution);
+    printReportTiming(&began);
+}
+
+// Function 8: Calculate student statistics
+void showStudentStatistics(StudentTable *table) {
+    int i, row;
+    const int *order;
+    struct timespec began;
+
+    if (table->count <= 0) {
+        printf("\nERROR: No data available.\n");
+        return;
+    }
+
+    // Totals and averages are recalculated from the score columns across the workers
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    recomputeStudentTotals(table, 1);
+    order = listingOrder(table);
+
+    printf("\n============================================\n");
+    printf("           STUDENT STATISTICS\n");
+    printf("============================================\n");
+
+    for (i = 0; i < table->count; i++) {
+        row = order ? order[i] : i;
+        printf("\nID: %ld, Name: %s\n", table->ids[row], studentName(table, row));
+        printf("  Total Score: %.1f, Average: %.2f\n", table->totals[row], table->averages[row]);
+    }
+    printReportTiming(&began);
+}
+
+// Function 9: Sort by total score
+int sortByTotalScore(StudentTable *table, int descending) {
+    ViewKind kind = descending ? VIEW_TOTAL_DESC : VIEW_TOTAL_ASC;
+
+    if (getSortedView(table, kind) == NULL) {
+        printf("\nERROR: Not enough memory to sort.\n");
+        return 0;
+    }
+    table->activeView = kind;
+    return 1;
+}
+
+// Function 10: Sort by student ID
+int sortByStudentId(StudentTable *table) {
+    if (getSortedView(table, VIEW_ID) == NULL) {
+        printf("\nERROR: Not enough memory to sort.\n");
+        return 0;
+    }
+    table->activeView = VIEW_ID;
+    return 1;
+}
+
+// Function 11: Sort by student name
+int sortByStudentName(StudentTable *table) {
+    if (getSortedView(table, VIEW_NAME) == NULL) {
+        printf("\nERROR: Not enough memory to sort.\n");
+        return 0;
+    }
+    table->activeView = VIEW_NAME;
+    return 1;
+}
+
+// Function 12: Search by student ID
+void searchByStudentId(StudentTable *table) {
+    long searchId;
+    int row;
+
+    if (table->count <= 0) {
+        printf("\nERROR: No data available.\n");
+        return;
+    }
+
+    printf("\nEnter Student ID to search: ");
+    if (scanf("%ld", &searchId) != 1) {
+        printf("ERROR: Invalid input.\n");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+
+    row = findStudentById(table, searchId);
+    if (row >= 0) {
+        printStudentRecord(table, row);
+    } else {
+        printf("\nERROR: Student with ID %ld not found.\n", searchId);
+    }
+}
+
+// Function 13: Search by student name
+void searchByStudentName(StudentTable *table) {
+    char searchName[MAX_NAME_LEN + 2];
+    const int *byName;
+    NameMatch *matches = NULL;
+    int i, first, last, found = 0;
+    size_t length;
+
+    if (table->count <= 0) {
+        printf("\nERROR: No data available.\n");
+        return;
+    }
+
+    printf("\nEnter Student Name to search (Jo* for prefix, ~Jon for similar): ");
+    clearInputBuffer();
+    fgets(searchName, sizeof(searchName), stdin);
+    searchName[strcspn(searchName, "\n")] = '\0';
+    length = strlen(searchName);
+
+    if ((byName = getSortedView(table, VIEW_NAME)) == NULL) {
+        printf("\nERROR: Not enough memory to search.\n");
+        return;
+    }
+
+    if (searchName[0] == SEARCH_FUZZY_MARK) {
+        found = fuzzySearchNames(table, searchName + 1, defaultFuzzyDistance(searchName + 1), &matches);
+        for (i = 0; i < found; i++) {
+            printStudentRecord(table, matches[i].row);
+        }
+        if (found == 0) {
+            printf("\nERROR: No student name is close to '%s'.\n", searchName + 1);
+        }
+        free(matches);
+        return;
+    }
+
+    if (length > 0 && searchName[length - 1] == SEARCH_PREFIX_MARK) {
+        searchName[length - 1] = '\0';
+        found = findNameRange(table, searchName, 1, &first, &last);
+    } else {
+        found = findNameRange(table, searchName, 0, &first, &last);
+    }
+    for (i = first; i < last; i++) {
+        printStudentRecord(table, byName[i]);
+    }
+
+    if (!found) {
+        printf("\nERROR: Student '%s' not found.\n", searchName);
+
+        // Offer close spellings instead of a bare miss
+        found = fuzzySearchNames(table, searchName, defaultFuzzyDistance(searchName), &matches);
+        if (found > 0) {
+            printf("Did you mean:\n");
+            for (i = 0; i < found; i++) {
+                const char *name = studentName(table, matches[i].row);
+                printf("  %s%*s (ID %ld)\n", name, namePadding(name, 20), "", table->ids[matches[i].row]);
+            }
+        }
+        free(matches);
+    }
+}
+
+// Function 14: Show grade distribution
+void showGradeStatistics(StudentTable *table) {
+    int j;
+    int studentCount = table->count, courseCount = table->courseCount;
+    struct timespec began;
+
+    if (studentCount <= 0) {
+        printf("\nERROR: No data available.\n");
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    if (!ensureAggregates(table)) {
+        printf("\nERROR: Not enough memory.\n");
+        return;
+    }
+
+    printf("\n============================================\n");
+    printf("          GRADE DISTRIBUTION\n");
+    printf("============================================\n");
+
+    for (j = 0; j < courseCount; j++) {
+        const long *gradeCount = table->aggregates[j].bands; // F, D, C, B, A
+
+        printf("\nCourse %d:\n", j + 1);
+        printf("  A (90-100):   %2ld students\n", gradeCount[4]);
+        printf("  B (80-89):    %2ld students\n", gradeCount[3]);
+        printf("  C (70-79):    %2ld students\n", gradeCount[2]);
+        printf("  D (60-69):    %2ld students\n", gradeCount[1]);
+        printf("  F (0-59):     %2ld students\n", gradeCount[0]);
+    }
+    printReportTiming(&began);
+}
+
+// Function 15: Prepare an empty table with one score column per course
+int initStudentTable(StudentTable *table, int courseCount) {
+    int a;
+
+    memset(table, 0, sizeof(*table));
+    table->courseCount = courseCount;
+    table->version = 1;
+    table->activeView = VIEW_NONE;
+    table->tenths = compactScores;
+    table->attributeCount = attributeSchemaCount;
+    for (a = 0; a < attributeSchemaCount; a++) {
+        memcpy(table->attributes[a].name, attributeSchema[a], ATTRIBUTE_NAME_LEN);
+    }
+    table->scores = calloc(courseCount > 0 ? courseCount : 1, sizeof(void *));
+    return table->scores != NULL;
+}
+
+// Function 16: Release every column owned by the table
+void freeStudentTable(StudentTable *table) {
+    int j;
+
+    freeIdIndex(&table->idIndex);
+    for (j = 0; j < VIEW_COUNT; j++) {
+        free(table->views[j].rows);
+        free(table->views[j].pending.rows);
+    }
+    for (j = 0; table->ranges != NULL && j < table->courseCount + 2; j++) {
+        free(table->ranges[j].keys);
+        free(table->ranges[j].rows);
+        free(table->ranges[j].pending.rows);
+    }
+    free(table->ranges);
+    free(table->aggregates);
+    freeDistributions(table->distributions, table->courseCount + 1);
+    freeAttributeColumns(table);
+    free(table->nameArena.internSlots);
+    if (table->nameArena.capacity > 0) {
+        free(table->nameArena.bytes);
+    }
+    if (table->mapping != NULL) {
+        // Columns live inside the snapshot mapping (names too, for current-format snapshots)
+        if (!insideMapping(table, table->names)) {
+            free(table->names);
+        }
+        munmap(table->mapping, table->mappingSize);
+        free(table->scores);
+        memset(table, 0, sizeof(*table));
+        return;
+    }
+
+    if (table->scores != NULL) {
+        for (j = 0; j < table->courseCount; j++) {
+            free(table->scores[j]);
+        }
+    }
+    free(table->scores);
+    free(table->ids);
+    free(table->names);
+    free(table->totals);
+    free(table->averages);
+    memset(table, 0, sizeof(*table));
+}
+
+// Function 17: Grow every column so it can hold at least minCapacity rows
+int reserveStudentRows(StudentTable *table, int minCapacity) {
+    int j, newCapacity;
+    void *grown;
+
+    if (minCapacity <= table->capacity) {
+        return 1;
+    }
+
+    newCapacity = table->capacity > 0 ? table->capacity : INITIAL_CAPACITY;
+    while (newCapacity < minCapacity) {
+        newCapacity = (newCapacity > INT_MAX / 2) ? minCapacity : newCapacity * 2;
+    }
+
+    // Snapshot columns cannot grow in place; move them to the heap first
+    if (table->mapping != NULL) {
+        return detachMappedColumns(table, newCapacity);
+    }
+
+    // Columns are grown one at a time; a failure leaves the old rows intact
+    if ((grown = realloc(table->ids, newCapacity * sizeof(long))) == NULL) return 0;
+    table->ids = grown;
+    if ((grown = realloc(table->names, newCapacity * sizeof(*table->names))) == NULL) return 0;
+    table->names = grown;
+    if ((grown = realloc(table->totals, newCapacity * sizeof(float))) == NULL) return 0;
+    table->totals = grown;
+    if ((grown = realloc(table->averages, newCapacity * sizeof(float))) == NULL) return 0;
+    table->averages = grown;
+    for (j = 0; j < table->courseCount; j++) {
+        if ((grown = realloc(table->scores[j], newCapacity * scoreWidth(table))) == NULL) return 0;
+        table->scores[j] = grown;
+    }
+    for (j = 0; j < table->attributeCount; j++) {
+        if ((grown = realloc(table->attributes[j].codes, newCapacity * sizeof(uint16_t))) == NULL) return 0;
+        table->attributes[j].codes = grown;
+    }
+
+    table->capacity = newCapacity;
+    return 1;
+}
+
+// Function 18: Append one record to the end of every column
+int appendStudent(StudentTable *table, const Student *student) {
+    int j, code, row = table->count;
+
+    if (!reserveStudentRows(table, row + 1)) {
+        return 0;
+    }
+
+    for (j = 0; j < table->attributeCount; j++) {
+        if ((code = internAttributeValue(&table->attributes[j], student->attributes[j])) < 0) {
+            return 0;
+        }
+        table->attributes[j].codes[row] = (uint16_t)code;
+    }
+    table->ids[row] = student->id;
+    if (!storeName(table, student->name, &table->names[row])) {
+        return 0;
+    }
+    for (j = 0; j < table->courseCount; j++) {
+        setScore(table, j, row, student->scores[j]);
+    }
+    if (table->tenths) {
+        // Tenths are summed exactly instead of taking the float total from data entry
+        table->totals[row] = tenthsTotal(table, row);
+        table->averages[row] = table->totals[row] / table->courseCount;
+    } else {
+        table->totals[row] = student->total;
+        table->averages[row] = student->average;
+    }
+    table->count++;
+    table->version++;
+
+    if (table->idIndex.slots != NULL && !insertIdIndex(table, row)) {
+        table->count--;
+        return 0;
+    }
+    addRowToAggregates(table, row);
+    return 1;
+}
+
+// Function 19: Row order used for listings, NULL for storage order
+const int *listingOrder(StudentTable *table) {
+    if (table->activeView == VIEW_NONE) {
+        return NULL;
+    }
+    // Falls back to storage order if a stale view cannot be rebuilt
+    return getSortedView(table, table->activeView);
+}
+
+// Function 20: Print one student's full record
+void printStudentRecord(const StudentTable *table, int row) {
+    int j;
+
+    printf("\nSTUDENT FOUND:\n");
+    printf("  ID: %ld\n", table->ids[row]);
+    printf("  Name: %s\n", studentName(table, row));
+    for (j = 0; j < table->attributeCount; j++) {
+        printf("  %s: %s\n", table->attributes[j].name, attributeValue(table, j, row));
+    }
+    printf("  Scores: ");
+    for (j = 0; j < table->courseCount; j++) {
+        printf("Course %d: %.1f  ", j + 1, scoreAt(table, j, row));
+    }
+    printf("\n  Total: %.1f, Average: %.2f\n", table->totals[row], table->averages[row]);
+}
+
+// Function 21: Seconds elapsed since a monotonic start time
+double elapsedSeconds(const struct timespec *start) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Function 22: Count comma-separated fields on one line
+int countCsvFields(const char *line, const char *end) {
+    int fields = 1;
+
+    while ((line = memchr(line, ',', end - line)) != NULL) {
+        fields++;
+        line++;
+    }
+    return fields;
+}
+
+// Function 23: A header line is one whose first field is not a number
+int isHeaderLine(const char *line, const char *end) {
+    while (line < end && *line == ' ') line++;
+    return line < end && !isdigit((unsigned char)*line);
+}
+
+// Function 24: Parse a student ID field (digits only)
+int parseIdField(const char *start, const char *end, long *value) {
+    long id = 0;
+    int digits = 0;
+
+    while (start < end && *start == ' ') start++;
+    while (end > start && end[-1] == ' ') end--;
+
+    for (; start < end; start++) {
+        if (*start < '0' || *start > '9' || ++digits > 18) {
+            return 0;
+        }
+        id = id * 10 + (*start - '0');
+    }
+
+    *value = id;
+    return digits > 0;
+}
+
+// Function 25: Parse a score field without scanf
+int parseScoreField(const char *start, const char *end, float *value) {
+    static const float powersOfTen[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f};
+    const char *p;
+    long mantissa = 0;
+    int digits = 0, decimals = 0, seenPoint = 0;
+
+    while (start < end && *start == ' ') start++;
+    while (end > start && end[-1] == ' ') end--;
+
+    for (p = start; p < end; p++) {
+        if (*p >= '0' && *p <= '9') {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits++;
+            decimals += seenPoint;
+        } else if (*p == '.' && !seenPoint) {
+            seenPoint = 1;
+        } else {
+            break;
+        }
+    }
+
+    // Up to 7 digits fit exactly in a float, so one float division gives the
+    // same correctly rounded result as scanf("%f")
+    if (p == end && digits > 0 && digits <= 7) {
+        *value = (float)mantissa / powersOfTen[decimals];
+        return 1;
+    }
+
+    // Anything unusual (signs, exponents, long fractions) goes through strtof
+    if (end > start && end - start < 64) {
+        char field[64];
+        char *stop;
+
+        memcpy(field, start, end - start);
+        field[end - start] = '\0';
+        *value = strtof(field, &stop);
+        return stop != field && *stop == '\0';
+    }
+    return 0;
+}
+
+// Function 26: Parse and validate one CSV row: id,name,attribute1,...,score1,...,scoreN
+int parseStudentCsvLine(char *line, char *end, const StudentTable *table, Student *student, const char **reason) {
+    char *field = line, *comma;
+    int j, courseCount = table->courseCount;
+    size_t nameLen;
+
+    // Most rows take the one-pass parser; anything it does not handle is checked field by field below
+    if (parsePlainCsvLine(line, end, table, student)) {
+        return 1;
+    }
+    if (countCsvFields(line, end) != courseCount + 2 + table->attributeCount) {
+        *reason = "wrong number of fields";
+        return 0;
+    }
+
+    // Student ID
+    comma = memchr(field, ',', end - field);
+    if (!parseIdField(field, comma, &student->id)) {
+        *reason = "invalid ID";
+        return 0;
+    }
+    if (student->id < MIN_STUDENT_ID || student->id > maxStudentId) {
+        *reason = maxStudentId == MAX_STUDENT_ID ? "ID must be 4 digits (1000-9999)" : "ID out of range";
+        return 0;
+    }
+
+    // Student name, optionally wrapped in double quotes
+    field = comma + 1;
+    comma = memchr(field, ',', end - field);
+    while (field < comma && *field == ' ') field++;
+    nameLen = comma - field;
+    while (nameLen > 0 && field[nameLen - 1] == ' ') nameLen--;
+    if (nameLen >= 2 && field[0] == '"' && field[nameLen - 1] == '"') {
+        field++;
+        nameLen -= 2;
+    }
+    if (nameLen == 0) {
+        *reason = "name cannot be empty";
+        return 0;
+    }
+    if (nameLen >= MAX_NAME_LEN) {
+        *reason = "name is too long";
+        return 0;
+    }
+    memcpy(student->name, field, nameLen);
+    student->name[nameLen] = '\0';
+    if (!isValidStudentName(student->name)) {
+        *reason = "invalid name";
+        return 0;
+    }
+
+    // Attribute values sit between the name and the scores
+    for (j = 0; j < table->attributeCount; j++) {
+        field = comma + 1;
+        comma = memchr(field, ',', end - field);
+        if ((*reason = parseAttributeField(field, comma, student->attributes[j])) != NULL) {
+            return 0;
+        }
+    }
+
+    // Scores, accumulated in course order exactly as inputStudentData does
+    student->total = 0;
+    for (j = 0; j < courseCount; j++) {
+        field = comma + 1;
+        comma = (j == courseCount - 1) ? end : memchr(field, ',', end - field);
+        if (!parseScoreField(field, comma, &student->scores[j])) {
+            *reason = "invalid score";
+            return 0;
+        }
+        if (student->scores[j] < 0 || student->scores[j] > 100) {
+            *reason = "score must be between 0 and 100";
+            return 0;
+        }
+        if (table->tenths && scoreBin(student->scores[j]) < 0) {
+            *reason = "score must have at most one decimal";
+            return 0;
+        }
+        student->total += student->scores[j];
+    }
+    student->average = (courseCount > 0) ? student->total / courseCount : 0;
+    return 1;
+}
+
+// Function 27: Stream a CSV roster into the table, writing bad rows to a reject report
+int importStudentsCsv(StudentTable *table, const char *path, const char *rejectPath, ImportSummary *summary) {
+    FILE *file, *rejects = NULL;
+    char *buffer, *start, *end, *newline;
+    size_t used = 0, got;
+    int atEof = 0, skipping = 0, sawFirstLine = 0, sized = 0, ok = 1, parsers = 0, pipelined = 0;
+    struct timespec began;
+    struct stat info;
+    ImportPipeline pipeline;
+    Student student;
+    const char *reason;
+
+    memset(summary, 0, sizeof(*summary));
+    clock_gettime(CLOCK_MONOTONIC, &began);
+
+    if ((file = fopen(path, "rb")) == NULL) {
+        printf("ERROR: Cannot open '%s'.\n", path);
+        return 0;
+    }
+    if ((buffer = malloc(IMPORT_BUFFER_SIZE + 1)) == NULL) {
+        printf("ERROR: Not enough memory.\n");
+        fclose(file);
+        return 0;
+    }
+    if (fstat(fileno(file), &info) != 0) {
+        info.st_size = 0;
+    }
+    // Large files are parsed on several threads once the first line has set the course count
+    if (workerPool.threadCount > 1 && info.st_size >= IMPORT_PIPELINE_MIN) {
+        parsers = workerPool.threadCount - 1 < IMPORT_MAX_PARSERS ? workerPool.threadCount - 1 : IMPORT_MAX_PARSERS;
+    }
+
+    while (ok && !atEof) {
+        got = fread(buffer + used, 1, IMPORT_BUFFER_SIZE - used, file);
+        summary->bytes += got;
+        used += got;
+        atEof = (got == 0);
+        start = buffer;
+        end = buffer + used;
+
+        while (start < end) {
+            if (pipelined && !skipping) {
+                // Whole lines go to the parser threads in bulk
+                newline = atEof ? end : memrchr(start, '\n', end - start);
+                if (newline == NULL) break;   // Wait for the rest of the line
+                if (!atEof) newline++;
+                if (!queueImportLines(&pipeline, start, newline)) {
+                    ok = 0;
+                    break;
+                }
+                start = newline;
+                continue;
+            }
+
+            newline = memchr(start, '\n', end - start);
+            if (newline == NULL) {
+                if (!atEof) break;        // Wait for the rest of the line
+                newline = end;            // Last line without a trailing newline
+            }
+
+            char *lineEnd = newline;
+            if (lineEnd > start && lineEnd[-1] == '\r') lineEnd--;
+
+            if (skipping) {
+                skipping = 0;             // Tail of an over-long line
+            } else {
+                summary->lines++;
+                if (lineEnd == start) {
+                    // Blank line
+                } else if (!sawFirstLine && isHeaderLine(start, lineEnd)) {
+                    sawFirstLine = 1;
+                    if (table->count == 0) {
+                        int courseCount = countCsvFields(start, lineEnd) - 2 - table->attributeCount;
+                        if (courseCount < 1 || courseCount > MAX_COURSES) {
+                            printf("ERROR: '%s' must have between 1 and %d course columns.\n", path, MAX_COURSES);
+                            ok = 0;
+                            break;
+                        }
+                        if (courseCount != table->courseCount) {
+                            freeStudentTable(table);
+                            if (!initStudentTable(table, courseCount)) {
+                                ok = 0;
+                                break;
+                            }
+                        }
+                    }
+                } else {
+                    if (!sawFirstLine && table->count == 0) {
+                        int courseCount = countCsvFields(start, lineEnd) - 2 - table->attributeCount;
+                        if (courseCount >= 1 && courseCount <= MAX_COURSES && courseCount != table->courseCount) {
+                            freeStudentTable(table);
+                            if (!initStudentTable(table, courseCount)) {
+                                ok = 0;
+                                break;
+                            }
+                        }
+                    }
+                    sawFirstLine = 1;
+                    if (!sized) {
+                        reserveImportRows(table, info.st_size, (long)(newline + 1 - start));
+                        sized = 1;
+                    }
+
+                    if (parseStudentCsvLine(start, lineEnd, table, &student, &reason)) {
+                        reason = NULL;
+                    }
+                    if (!applyImportRow(table, &student, reason, start, (int)(lineEnd - start), summary, rejectPath,
+                                        &rejects)) {
+                        ok = 0;
+                        break;
+                    }
+                }
+            }
+            start = newline + 1;
+
+            if (sawFirstLine && parsers > 0) {
+                pipelined = startImportPipeline(&pipeline, table, summary, rejectPath, &rejects, parsers);
+                parsers = 0;              // Stay on this thread if the threads could not start
+            }
+        }
+        if (pipelined && __atomic_load_n(&pipeline.failed, __ATOMIC_ACQUIRE)) {
+            ok = 0;
+        }
+
+        // Keep the unfinished line for the next read
+        used = (start < end) ? (size_t)(end - start) : 0;
+        if (used == IMPORT_BUFFER_SIZE) {
+            // A single line filled the whole buffer: reject it and drop the rest
+            if (!skipping && pipelined) {
+                queueTooLongLine(&pipeline);
+            } else if (!skipping) {
+                summary->lines++;
+                applyImportRow(table, NULL, "line is too long", NULL, 0, summary, rejectPath, &rejects);
+            }
+            skipping = 1;
+            used = 0;
+        } else if (used > 0) {
+            memmove(buffer, start, used);
+        }
+    }
+
+    if (pipelined && !finishImportPipeline(&pipeline)) {
+        ok = 0;
+    }
+    free(buffer);
+    fclose(file);
+    if (rejects != NULL) {
+        fclose(rejects);
+    }
+    summary->seconds = elapsedSeconds(&began);
+    if (statsEnabled) {
+        recordOperation(STAT_INGEST, summary->seconds, summary->lines, summary->bytes);
+    }
+    return ok;
+}
+
+// Function 28: Fold data into a four-lane checksum (size must be a multiple of 32 bytes)
+uint64_t updateChecksum(uint64_t lanes[4], const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    size_t i;
+    int k;
+
+    for (i = 0; i + 32 <= size; i += 32) {
+        for (k = 0; k < 4; k++) {
+            uint64_t word;
+            memcpy(&word, bytes + i + k * 8, 8);
+            lanes[k] = (lanes[k] ^ word) * 0x100000001b3ULL;
+            lanes[k] ^= lanes[k] >> 29;
+        }
+    }
+    return finishChecksum(lanes);
+}
+
+// Function 29: Combine the four checksum lanes into one value
+uint64_t finishChecksum(const uint64_t lanes[4]) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    int k;
+
+    for (k = 0; k < 4; k++) {
+        hash = (hash ^ lanes[k]) * 0x9e3779b97f4a7c15ULL;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+// Function 30: File size of a snapshot holding recordCount rows (nameWidth bytes of name column
+// and scoreSize bytes of each score column per row)
+size_t snapshotSize(size_t headerBlock, int courseCount, size_t recordCount, size_t nameWidth, size_t scoreSize,
+                    int attributeCount, size_t dictionaryBytes, size_t arenaBytes) {
+    size_t columnBytes[7];
+    size_t size = headerBlock;
+    int k;
+
+    columnBytes[0] = recordCount * sizeof(int64_t);   // IDs
+    columnBytes[1] = recordCount * nameWidth;         // Names, or name handles
+    columnBytes[2] = recordCount * scoreSize;         // Each score column
+    columnBytes[3] = recordCount * sizeof(float);     // Total and average columns
+    columnBytes[4] = recordCount * sizeof(uint16_t);  // Each attribute code column
+    columnBytes[5] = dictionaryBytes;                 // Attribute names and values
+    columnBytes[6] = arenaBytes;                      // Name arena
+    for (k = 0; k < 7; k++) {
+        columnBytes[k] = (columnBytes[k] + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+    }
+    return size + columnBytes[0] + columnBytes[1] + columnBytes[2] * courseCount + columnBytes[3] * 2 +
+           columnBytes[4] * attributeCount + columnBytes[5] + columnBytes[6];
+}
+
+// Function 31: Write the whole table to a snapshot file
+int saveSnapshot(const StudentTable *table, const char *path) {
+    SnapshotHeader header;
+    uint64_t lanes[4] = {0, 0, 0, 0};
+    static const char padding[SNAPSHOT_HEADER_BLOCK] = {0};
+    char tempPath[1024];
+    const void *columns[MAX_COURSES + MAX_ATTRIBUTES + 6];
+    size_t sizes[MAX_COURSES + MAX_ATTRIBUTES + 6];
+    int columnCount = 0, j, ok = 1;
+    size_t n = table->count, dictionaryBytes;
+    char *dictionary;
+    FILE *file;
+
+    if ((dictionary = encodeAttributeDictionary(table, &dictionaryBytes)) == NULL) {
+        printf("ERROR: Not enough memory.\n");
+        return 0;
+    }
+
+    // Columns in file order; the name arena goes last so its length need not be stored
+    columns[columnCount] = table->ids;       sizes[columnCount++] = n * sizeof(int64_t);
+    columns[columnCount] = table->names;     sizes[columnCount++] = n * sizeof(NameRef);
+    for (j = 0; j < table->courseCount; j++) {
+        columns[columnCount] = table->scores[j]; sizes[columnCount++] = n * scoreWidth(table);
+    }
+    columns[columnCount] = table->totals;    sizes[columnCount++] = n * sizeof(float);
+    columns[columnCount] = table->averages;  sizes[columnCount++] = n * sizeof(float);
+    for (j = 0; j < table->attributeCount; j++) {
+        columns[columnCount] = table->attributes[j].codes; sizes[columnCount++] = n * sizeof(uint16_t);
+    }
+    columns[columnCount] = dictionary;       sizes[columnCount++] = dictionaryBytes;
+    columns[columnCount] = table->nameArena.bytes;  sizes[columnCount++] = table->nameArena.used;
+
+    // Write beside the target and rename, so a crash never leaves half a snapshot
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    if ((file = fopen(tempPath, "wb")) == NULL) {
+        printf("ERROR: Cannot write '%s'.\n", tempPath);
+        free(dictionary);
+        return 0;
+    }
+    setvbuf(file, NULL, _IOFBF, IMPORT_BUFFER_SIZE);
+
+    memset(&header, 0, sizeof(header));
+    ok = fwrite(padding, 1, SNAPSHOT_HEADER_BLOCK, file) == SNAPSHOT_HEADER_BLOCK;
+
+    for (j = 0; ok && j < columnCount; j++) {
+        size_t bytes = sizes[j];
+        size_t padded = (bytes + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+        size_t whole = bytes / 32 * 32;
+        unsigned char tail[64];
+
+        ok = fwrite(columns[j], 1, bytes, file) == bytes &&
+             fwrite(padding, 1, padded - bytes, file) == padded - bytes;
+
+        // The checksum sees the padded column, in 32-byte steps
+        updateChecksum(lanes, columns[j], whole);
+        memset(tail, 0, sizeof(tail));
+        if (bytes > whole) memcpy(tail, (const char *)columns[j] + whole, bytes - whole);
+        updateChecksum(lanes, tail, padded - whole);
+    }
+
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(header);
+    header.generation = table->generation;
+    header.courseCount = table->courseCount;
+    header.nameLength = 0;
+    header.recordCount = n;
+    header.scoreBytes = scoreWidth(table);
+    header.attributeCount = table->attributeCount;
+    header.dictionaryBytes = dictionaryBytes;
+    header.fileSize = snapshotSize(SNAPSHOT_HEADER_BLOCK, table->courseCount, n, sizeof(NameRef), header.scoreBytes,
+                                   table->attributeCount, dictionaryBytes, table->nameArena.used);
+    header.dataChecksum = finishChecksum(lanes);
+    memset(lanes, 0, sizeof(lanes));
+    {
+        unsigned char block[SNAPSHOT_HEADER_BLOCK] = {0};
+        memcpy(block, &header, sizeof(header));
+        header.headerChecksum = updateChecksum(lanes, block, SNAPSHOT_HEADER_BLOCK);
+    }
+
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = (fclose(file) == 0) && ok;
+    free(dictionary);
+    if (!ok || rename(tempPath, path) != 0) {
+        printf("ERROR: Failed to write snapshot '%s'.\n", path);
+        remove(tempPath);
+        return 0;
+    }
+    return 1;
+}
+
+// Function 32: Map a snapshot and point the table's columns straight into it
+int loadSnapshot(StudentTable *table, const char *path, int verifyData) {
+    SnapshotHeader header;
+    uint64_t lanes[4] = {0, 0, 0, 0};
+    struct stat info;
+    unsigned char *base, *column, *names, *dictionary;
+    size_t n, floatBytes, scoreBytes, codeBytes, nameWidth, fixedSize, headerBlock, row;
+    int fd, j, knownLayout;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        printf("ERROR: Cannot open snapshot '%s'.\n", path);
+        return 0;
+    }
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < SNAPSHOT_ALIGN) {
+        printf("ERROR: Snapshot '%s' is too short.\n", path);
+        close(fd);
+        return 0;
+    }
+
+    // A private mapping lets the program edit rows; the file itself never changes
+    base = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        printf("ERROR: Cannot map snapshot '%s'.\n", path);
+        return 0;
+    }
+
+    // Headers before version 4 fit in one SNAPSHOT_ALIGN block, and the file may end there
+    memset(&header, 0, sizeof(header));
+    memcpy(&header, base, SNAPSHOT_ALIGN);
+    headerBlock = header.version >= 4 ? SNAPSHOT_HEADER_BLOCK : SNAPSHOT_ALIGN;
+    if (headerBlock > (size_t)info.st_size) {
+        printf("ERROR: Snapshot '%s' is too short.\n", path);
+        munmap(base, info.st_size);
+        return 0;
+    }
+    memcpy(&header, base, sizeof(header) < headerBlock ? sizeof(header) : headerBlock);
+    {
+        unsigned char block[SNAPSHOT_HEADER_BLOCK];
+        memcpy(block, base, headerBlock);
+        memset(block + offsetof(SnapshotHeader, headerChecksum), 0, sizeof(header.headerChecksum));
+        if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+            updateChecksum(lanes, block, headerBlock) != header.headerChecksum) {
+            printf("ERROR: '%s' is not a valid snapshot.\n", path);
+            munmap(base, info.st_size);
+            return 0;
+        }
+    }
+    // Version 1 files lack the generation field; versions 1 and 2 store names at a fixed width;
+    // versions before 4 lack scoreBytes and always store floats; versions before 5 have no attributes
+    if (header.version < 4) {
+        header.scoreBytes = sizeof(float);
+    }
+    if (header.version < 5) {
+        header.attributeCount = header.dictionaryBytes = 0;
+    }
+    knownLayout = (header.version == SNAPSHOT_VERSION && header.headerSize == sizeof(header) && header.nameLength == 0 &&
+                   (header.scoreBytes == sizeof(float) || header.scoreBytes == sizeof(uint16_t))) ||
+                  (header.version == 4 && header.headerSize == offsetof(SnapshotHeader, dictionaryBytes) &&
+                   header.nameLength == 0 &&
+                   (header.scoreBytes == sizeof(float) || header.scoreBytes == sizeof(uint16_t))) ||
+                  (header.version == 3 && header.headerSize == offsetof(SnapshotHeader, scoreBytes) &&
+                   header.nameLength == 0) ||
+                  (header.version == 2 && header.headerSize == offsetof(SnapshotHeader, scoreBytes) &&
+                   header.nameLength == LEGACY_NAME_LEN) ||
+                  (header.version == 1 && header.headerSize == offsetof(SnapshotHeader, generation) &&
+                   header.nameLength == LEGACY_NAME_LEN);
+    if (!knownLayout || sizeof(long) != sizeof(int64_t)) {
+        printf("ERROR: Snapshot '%s' was written by an incompatible version.\n", path);
+        munmap(base, info.st_size);
+        return 0;
+    }
+    nameWidth = header.nameLength > 0 ? header.nameLength : sizeof(NameRef);
+    fixedSize = header.courseCount <= MAX_COURSES && header.attributeCount <= MAX_ATTRIBUTES
+                    ? snapshotSize(headerBlock, header.courseCount, header.recordCount, nameWidth, header.scoreBytes,
+                                   header.attributeCount, header.dictionaryBytes, 0) : 0;
+    if (header.courseCount < 1 || header.courseCount > MAX_COURSES || header.attributeCount > MAX_ATTRIBUTES ||
+        header.recordCount > INT_MAX ||
+        header.fileSize != (uint64_t)info.st_size || header.fileSize < fixedSize ||
+        (header.nameLength > 0 ? header.fileSize != fixedSize : header.fileSize - fixedSize > UINT32_MAX)) {
+        printf("ERROR: Snapshot '%s' is truncated or damaged.\n", path);
+        munmap(base, info.st_size);
+        return 0;
+    }
+    if (verifyData) {
+        memset(lanes, 0, sizeof(lanes));
+        if (updateChecksum(lanes, base + headerBlock, info.st_size - headerBlock) != header.dataChecksum) {
+            printf("ERROR: Snapshot '%s' failed its checksum.\n", path);
+            munmap(base, info.st_size);
+            return 0;
+        }
+    }
+
+    if (!initStudentTable(table, header.courseCount)) {
+        munmap(base, info.st_size);
+        return 0;
+    }
+    table->tenths = header.scoreBytes == sizeof(uint16_t);
+    // The snapshot's attributes replace any given on the command line
+    memset(table->attributes, 0, sizeof(table->attributes));
+    table->attributeCount = 0;
+
+    // Columns are used in place, nothing is parsed or copied
+    n = header.recordCount;
+    floatBytes = (n * sizeof(float) + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+    scoreBytes = (n * header.scoreBytes + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+    codeBytes = (n * sizeof(uint16_t) + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+    column = base + headerBlock;
+    table->ids = (long *)column;
+    column += (n * sizeof(int64_t) + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+    names = column;
+    column += (n * nameWidth + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+    for (j = 0; j < table->courseCount; j++) {
+        table->scores[j] = column;
+        column += scoreBytes;
+    }
+    table->totals = (float *)column;
+    column += floatBytes;
+    table->averages = (float *)column;
+    column += floatBytes;
+    for (j = 0; j < (int)header.attributeCount; j++) {
+        table->attributes[j].codes = (uint16_t *)column;
+        column += codeBytes;
+    }
+    dictionary = column;
+    column += (header.dictionaryBytes + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+
+    table->capacity = (int)n;
+    table->generation = header.generation;
+    table->mapping = base;
+    table->mappingSize = info.st_size;
+
+    if (header.nameLength == 0) {
+        // The handles and the arena are used in place too; the arena is copied only when it grows
+        table->names = (NameRef *)names;
+        table->nameArena.bytes = (char *)column;
+        table->nameArena.used = table->nameArena.live = header.fileSize - fixedSize;
+    } else {
+        // Older snapshots hold fixed-width names, which are moved into an arena once
+        if ((table->names = malloc((n > 0 ? n : 1) * sizeof(NameRef))) == NULL) {
+            freeStudentTable(table);
+            return 0;
+        }
+        for (row = 0; row < n; row++) {
+            char name[LEGACY_NAME_LEN];
+
+            memcpy(name, names + row * LEGACY_NAME_LEN, LEGACY_NAME_LEN);
+            name[LEGACY_NAME_LEN - 1] = '\0';
+            if (!storeName(table, name, &table->names[row])) {
+                freeStudentTable(table);
+                return 0;
+            }
+        }
+    }
+    table->count = (int)n;
+
+    // One pass checks what is used in place without bounds checks later: each name handle must
+    // point at a whole name and folded key inside the arena, and each count of tenths, which
+    // indexes the per-score tables directly, must be a score from 0 to 100
+    if (header.nameLength == 0 || table->tenths) {
+        // Rows sharing an interned name share its handle, so each name is read only once
+        uint64_t *checked = header.nameLength == 0 ? calloc(table->nameArena.used / 64 + 1, sizeof(uint64_t)) : NULL;
+        int damaged = header.nameLength == 0 && checked == NULL;
+
+        for (row = 0; row < n && !damaged; row++) {
+            damaged = header.nameLength == 0 && !validArenaName(&table->nameArena, table->names[row], checked);
+            for (j = 0; table->tenths && j < table->courseCount; j++) {
+                damaged |= ((const uint16_t *)table->scores[j])[row] >= SCORE_BINS;
+            }
+        }
+        free(checked);
+        if (damaged) {
+            printf("ERROR: Snapshot '%s' is truncated or damaged.\n", path);
+            freeStudentTable(table);
+            return 0;
+        }
+    }
+
+    // Attribute codes are used in place too; only their dictionaries are rebuilt
+    if (!decodeAttributeDictionary(table, (const char *)dictionary, header.dictionaryBytes, header.attributeCount)) {
+        printf("ERROR: Snapshot '%s' is truncated or damaged.\n", path);
+        freeStudentTable(table);
+        return 0;
+    }
+    return 1;
+}
+
+// Function 33: Copy snapshot-backed columns to the heap so they can grow
+int detachMappedColumns(StudentTable *table, int newCapacity) {
+    StudentTable heap;
+    int j, ok;
+
+    heap = *table;
+    heap.ids = malloc(newCapacity * sizeof(long));
+    heap.names = malloc(newCapacity * sizeof(*heap.names));
+    heap.totals = malloc(newCapacity * sizeof(float));
+    heap.averages = malloc(newCapacity * sizeof(float));
+    heap.scores = calloc(table->courseCount, sizeof(void *));
+    ok = heap.ids && heap.names && heap.totals && heap.averages && heap.scores;
+    for (j = 0; ok && j < table->courseCount; j++) {
+        ok = (heap.scores[j] = malloc(newCapacity * scoreWidth(table))) != NULL;
+    }
+    for (j = 0; j < table->attributeCount; j++) {
+        heap.attributes[j].codes = ok ? malloc(newCapacity * sizeof(uint16_t)) : NULL;
+        ok = ok && heap.attributes[j].codes != NULL;
+    }
+    if (!ok) {
+        // Only the new columns are released; the table keeps its mapping
+        for (j = 0; heap.scores != NULL && j < table->courseCount; j++) {
+            free(heap.scores[j]);
+        }
+        for (j = 0; j < table->attributeCount; j++) {
+            free(heap.attributes[j].codes);
+        }
+        free(heap.scores);
+        free(heap.ids);
+        free(heap.names);
+        free(heap.totals);
+        free(heap.averages);
+        return 0;
+    }
+
+    // A mapped name arena moves to the heap as well, since the mapping is about to go
+    if (table->nameArena.capacity == 0 && table->nameArena.used > 0) {
+        if ((heap.nameArena.bytes = malloc(table->nameArena.used)) == NULL) {
+            for (j = 0; j < table->courseCount; j++) {
+                free(heap.scores[j]);
+            }
+            for (j = 0; j < table->attributeCount; j++) {
+                free(heap.attributes[j].codes);
+            }
+            free(heap.scores);
+            free(heap.ids);
+            free(heap.names);
+            free(heap.totals);
+            free(heap.averages);
+            return 0;
+        }
+        memcpy(heap.nameArena.bytes, table->nameArena.bytes, table->nameArena.used);
+        heap.nameArena.capacity = table->nameArena.used;
+    }
+
+    memcpy(heap.ids, table->ids, table->count * sizeof(long));
+    memcpy(heap.names, table->names, table->count * sizeof(*heap.names));
+    if (!insideMapping(table, table->names)) {
+        free(table->names);
+    }
+    memcpy(heap.totals, table->totals, table->count * sizeof(float));
+    memcpy(heap.averages, table->averages, table->count * sizeof(float));
+    for (j = 0; j < table->courseCount; j++) {
+        memcpy(heap.scores[j], table->scores[j], table->count * scoreWidth(table));
+    }
+    for (j = 0; j < table->attributeCount; j++) {
+        memcpy(heap.attributes[j].codes, table->attributes[j].codes, table->count * sizeof(uint16_t));
+    }
+
+    munmap(table->mapping, table->mappingSize);
+    free(table->scores);
+    heap.capacity = newCapacity;
+    heap.mapping = NULL;
+    heap.mappingSize = 0;
+    *table = heap;
+    return 1;
+}
+
+// Function 34: Row holding a student ID, or -1 when the ID is not stored
+int findStudentById(StudentTable *table, long id) {
+    IdIndex *index = &table->idIndex;
+    int slot, row;
+
+    if (index->slots == NULL && !buildIdIndex(table, table->count)) {
+        // Out of memory: fall back to a plain scan
+        for (row = 0; row < table->count; row++) {
+            if (table->ids[row] == id) return row;
+        }
+        return -1;
+    }
+
+    for (slot = idIndexHome(index, id); (row = index->slots[slot]) >= 0; slot = (slot + 1) & index->mask) {
+        if (table->ids[row] == id) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+// Function 35: (Re)build the ID index with room for minCount rows at half load
+int buildIdIndex(StudentTable *table, int minCount) {
+    IdIndex fresh;
+    int size = 16, row, slot;
+
+    while (size < minCount * 2) {
+        size *= 2;
+    }
+    if ((fresh.slots = malloc(size * sizeof(int))) == NULL) {
+        return 0;
+    }
+    memset(fresh.slots, 0xff, size * sizeof(int));
+    fresh.mask = size - 1;
+    fresh.used = 0;
+
+    for (row = 0; row < table->count; row++) {
+        slot = idIndexHome(&fresh, table->ids[row]);
+        while (fresh.slots[slot] >= 0) {
+            slot = (slot + 1) & fresh.mask;
+        }
+        fresh.slots[slot] = row;
+        fresh.used++;
+    }
+
+    freeIdIndex(&table->idIndex);
+    table->idIndex = fresh;
+    return 1;
+}
+
+// Function 36: Release the ID index
+void freeIdIndex(IdIndex *index) {
+    free(index->slots);
+    memset(index, 0, sizeof(*index));
+}
+
+// Function 37: First slot probed for an ID (Fibonacci hashing)
+int idIndexHome(const IdIndex *index, long id) {
+    return (int)(((uint64_t)id * 0x9e3779b97f4a7c15ULL) >> 32) & index->mask;
+}
+
+// Function 38: Add an appended row to the ID index
+int insertIdIndex(StudentTable *table, int row) {
+    IdIndex *index = &table->idIndex;
+    int slot;
+
+    if ((index->used + 1) * 2 > index->mask + 1) {
+        // Rebuilding rehashes every row, including the new one
+        return buildIdIndex(table, table->count);
+    }
+
+    slot = idIndexHome(index, table->ids[row]);
+    while (index->slots[slot] >= 0) {
+        slot = (slot + 1) & index->mask;
+    }
+    index->slots[slot] = row;
+    index->used++;
+    return 1;
+}
+
+// Function 39: Slot whose entry points at a row, or -1 when the index is not built
+int idIndexSlot(const StudentTable *table, int row) {
+    const IdIndex *index = &table->idIndex;
+    int slot;
+
+    if (index->slots == NULL) return -1;
+
+    for (slot = idIndexHome(index, table->ids[row]); index->slots[slot] >= 0; slot = (slot + 1) & index->mask) {
+        if (index->slots[slot] == row) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+// Function 40: Drop an ID from the index (backward-shift deletion keeps probes short)
+void removeIdIndex(StudentTable *table, long id) {
+    IdIndex *index = &table->idIndex;
+    int hole, next, home, row;
+
+    if (index->slots == NULL) return;
+
+    for (hole = idIndexHome(index, id); (row = index->slots[hole]) >= 0; hole = (hole + 1) & index->mask) {
+        if (table->ids[row] == id) break;
+    }
+    if (row < 0) return;
+
+    for (next = (hole + 1) & index->mask; (row = index->slots[next]) >= 0; next = (next + 1) & index->mask) {
+        home = idIndexHome(index, table->ids[row]);
+        // Shift the entry back unless its home lies cyclically in (hole, next]
+        if ((next > hole && (home <= hole || home > next)) ||
+            (next < hole && (home <= hole && home > next))) {
+            index->slots[hole] = row;
+            hole = next;
+        }
+    }
+    index->slots[hole] = -1;
+    index->used--;
+}
+
+// Function 41: Remove every row but keep the columns allocated
+void clearStudentRows(StudentTable *table) {
+    table->count = 0;
+    table->version++;
+    table->activeView = VIEW_NONE;
+    free(table->aggregates);
+    table->aggregates = NULL;
+    freeDistributions(table->distributions, table->courseCount + 1);
+    table->distributions = NULL;
+    if (table->idIndex.slots != NULL) {
+        memset(table->idIndex.slots, 0xff, (table->idIndex.mask + 1) * sizeof(int));
+        table->idIndex.used = 0;
+    }
+    // Names go too; a mapped arena is left in place and simply not used again
+    table->nameArena.used = table->nameArena.live = 0;
+    free(table->nameArena.internSlots);
+    table->nameArena.internSlots = NULL;
+    table->nameArena.internMask = table->nameArena.internCount = 0;
+}
+
+// Function 42: Sorted row order for a view, rebuilt only if the table changed since; rows changed
+// one at a time since the last read are merged in rather than re-sorting everything
+const int *getSortedView(StudentTable *table, ViewKind kind) {
+    SortedView *view = &table->views[kind];
+    int *rows;
+    int i, n = table->count;
+
+    if (view->rows != NULL && view->version == table->version) {
+        if (view->pending.count == 0 || mergePendingViewRows(table, kind)) {
+            return view->rows;
+        }
+        view->version = table->version - 1;     // Half merged: no longer current, so rebuild below
+    }
+
+    view->pending.count = 0;
+    if ((rows = realloc(view->rows, (n > 0 ? n : 1) * sizeof(int))) == NULL) {
+        return NULL;
+    }
+    view->rows = rows;
+    for (i = 0; i < n; i++) {
+        rows[i] = i;
+    }
+    if (!sortViewRows(table, kind, rows, n)) {
+        return NULL;
+    }
+    view->entries = n;
+    view->version = table->version;
+    return rows;
+}
+
+// Function 43: Stable LSD radix sort of rows by 8-bit key digits, skipping digits that never vary
+int radixSortRows(uint64_t *keys, int *rows, int n, int keyBytes) {
+    uint64_t *keyBuffer, *swapKeys;
+    int *rowBuffer, *swapRows, *sortedRows = rows;
+    size_t counts[256], offset, count, target;
+    int pass, shift, i;
+
+    if (n < 2) {
+        return 1;
+    }
+    keyBuffer = malloc(n * sizeof(uint64_t));
+    rowBuffer = malloc(n * sizeof(int));
+    if (keyBuffer == NULL || rowBuffer == NULL) {
+        free(keyBuffer);
+        free(rowBuffer);
+        return 0;
+    }
+
+    for (pass = 0; pass < keyBytes; pass++) {
+        shift = pass * 8;
+        memset(counts, 0, sizeof(counts));
+        for (i = 0; i < n; i++) {
+            counts[(keys[i] >> shift) & 0xff]++;
+        }
+        if (counts[(keys[0] >> shift) & 0xff] == (size_t)n) {
+            continue;       // Every key shares this digit
+        }
+
+        for (offset = 0, i = 0; i < 256; i++) {
+            count = counts[i];
+            counts[i] = offset;
+            offset += count;
+        }
+        for (i = 0; i < n; i++) {
+            target = counts[(keys[i] >> shift) & 0xff]++;
+            keyBuffer[target] = keys[i];
+            rowBuffer[target] = sortedRows[i];
+        }
+
+        swapKeys = keys; keys = keyBuffer; keyBuffer = swapKeys;
+        swapRows = sortedRows; sortedRows = rowBuffer; rowBuffer = swapRows;
+    }
+
+    // After an odd number of scattering passes the result sits in the scratch buffers
+    if (sortedRows != rows) {
+        memcpy(rows, sortedRows, n * sizeof(int));
+        free(sortedRows);
+        free(keys);
+    } else {
+        free(rowBuffer);
+        free(keyBuffer);
+    }
+    return 1;
+}
+
+// Function 44: Stable merge sort of rows by name, ignoring case (a byte compare of the folded names)
+void mergeSortRowsByName(const StudentTable *table, int *rows, int *scratch, int n) {
+    int width, lo, mid, hi, i, j, k, *swap, *source = rows, *target = scratch;
+
+    // Short runs are insertion-sorted first, then merged bottom-up
+    for (lo = 0; lo < n; lo += 16) {
+        hi = (lo + 16 < n) ? lo + 16 : n;
+        for (i = lo + 1; i < hi; i++) {
+            int row = rows[i];
+            for (j = i; j > lo && strcmp(foldedName(table, rows[j - 1]), foldedName(table, row)) > 0; j--) {
+                rows[j] = rows[j - 1];
+            }
+            rows[j] = row;
+        }
+    }
+
+    for (width = 16; width < n; width *= 2) {
+        for (lo = 0; lo < n; lo += 2 * width) {
+            mid = (lo + width < n) ? lo + width : n;
+            hi = (lo + 2 * width < n) ? lo + 2 * width : n;
+            for (i = lo, j = mid, k = lo; k < hi; k++) {
+                // Taking from the left run on ties keeps the sort stable
+                if (i < mid && (j >= hi || strcmp(foldedName(table, source[i]), foldedName(table, source[j])) <= 0)) {
+                    target[k] = source[i++];
+                } else {
+                    target[k] = source[j++];
+                }
+            }
+        }
+        swap = source; source = target; target = swap;
+    }
+
+    if (source != rows) {
+        memcpy(rows, source, n * sizeof(int));
+    }
+}
+
+// Function 45: Map a float to an unsigned key with the same ordering
+uint32_t floatSortKey(float value) {
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    if (bits == 0x80000000u) {
+        bits = 0;           // -0.0 compares equal to 0.0
+    }
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+// Function 46: Positions [first, last) in the name view matching a name or prefix, ignoring case
+int findNameRange(StudentTable *table, const char *name, int prefixOnly, int *first, int *last) {
+    const int *byName = getSortedView(table, VIEW_NAME);
+    size_t length = strlen(name);
+    char folded[MAX_NAME_LEN];
+    int lo = 0, hi = table->count, mid;
+
+    *first = *last = 0;
+    if (byName == NULL || length >= MAX_NAME_LEN) {
+        return 0;
+    }
+    foldName(name, length, folded);
+    folded[length] = '\0';
+
+    // Lower bound: first name not ordered before the query
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (strcmp(foldedName(table, byName[mid]), folded) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    *first = lo;
+
+    // Matches are contiguous in folded order, so scan until the first miss
+    for (hi = lo; hi < table->count; hi++) {
+        const char *candidate = foldedName(table, byName[hi]);
+        if (prefixOnly ? strncmp(candidate, folded, length) != 0 : strcmp(candidate, folded) != 0) {
+            break;
+        }
+    }
+    *last = hi;
+    return *last - *first;
+}
+
+// Function 47: Names within maxDistance edits of the query, closest first then in name order
+int fuzzySearchNames(StudentTable *table, const char *query, int maxDistance, NameMatch **matches) {
+    const int *byName = getSortedView(table, VIEW_NAME);
+    int dp[MAX_NAME_LEN + 1][MAX_NAME_LEN + 2];
+    char folded[MAX_NAME_LEN];
+    int queryLength = (int)strlen(query), validDepth = 0, count = 0, capacity = 0;
+    int pos, depth, j, lo, hi, mid, rowMin, cost;
+    const char *name, *previous = "";
+    NameMatch *found = NULL, *grown;
+
+    *matches = NULL;
+    if (byName == NULL || queryLength >= MAX_NAME_LEN) {
+        return 0;
+    }
+    foldName(query, queryLength, folded);
+    for (j = 0; j <= queryLength; j++) {
+        dp[0][j] = j;
+    }
+
+    // Walk the sorted names like a trie: rows for a shared prefix are reused,
+    // and a prefix that is already too far away skips every name below it
+    for (pos = 0; pos < table->count; pos++) {
+        name = foldedName(table, byName[pos]);
+        depth = foldedPrefixLength(previous, name);
+        if (depth > validDepth) depth = validDepth;
+        previous = name;
+
+        for (rowMin = 0; name[depth] != '\0'; depth++) {
+            int c = name[depth];
+            int *above = dp[depth], *row = dp[depth + 1];
+
+            row[0] = rowMin = depth + 1;
+            for (j = 1; j <= queryLength; j++) {
+                cost = above[j - 1] + (folded[j - 1] != c);
+                if (above[j] + 1 < cost) cost = above[j] + 1;
+                if (row[j - 1] + 1 < cost) cost = row[j - 1] + 1;
+                row[j] = cost;
+                if (cost < rowMin) rowMin = cost;
+            }
+            if (rowMin > maxDistance) {
+                depth++;
+                break;
+            }
+        }
+        validDepth = depth;
+
+        if (rowMin > maxDistance) {
+            // Skip to the first name that does not share this prefix
+            lo = pos + 1;
+            hi = table->count;
+            while (lo < hi) {
+                mid = lo + (hi - lo) / 2;
+                if (strncmp(foldedName(table, byName[mid]), name, depth) == 0) lo = mid + 1;
+                else hi = mid;
+            }
+            pos = lo - 1;
+            continue;
+        }
+
+        if (dp[depth][queryLength] <= maxDistance) {
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 16;
+                if ((grown = realloc(found, capacity * sizeof(NameMatch))) == NULL) {
+                    break;
+                }
+                found = grown;
+            }
+            found[count].row = byName[pos];
+            found[count].distance = dp[depth][queryLength];
+            count++;
+        }
+    }
+
+    // Stable insertion by distance keeps name order within each distance
+    for (pos = 1; pos < count; pos++) {
+        NameMatch match = found[pos];
+        for (j = pos; j > 0 && found[j - 1].distance > match.distance; j--) {
+            found[j] = found[j - 1];
+        }
+        found[j] = match;
+    }
+
+    *matches = found;
+    return count;
+}
+
+// Function 48: Length of the common prefix of two folded names
+int foldedPrefixLength(const char *a, const char *b) {
+    int i = 0;
+
+    while (a[i] != '\0' && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+// Function 49: Edit distance allowed for a fuzzy query: one typo for short names, two otherwise
+int defaultFuzzyDistance(const char *query) {
+    return strlen(query) <= 4 ? 1 : 2;
+}
+
+// Function 50: Score as a fixed-point integer (exact for every float from 1/512 up)
+int64_t scoreToFixed(float score) {
+    return roundToInt64((double)score * SCORE_FIXED_ONE);
+}
+
+// Function 51: Grade band of a score: 0 = F, 1 = D, 2 = C, 3 = B, 4 = A
+int gradeBand(float score) {
+    if (score >= 90) return 4;
+    if (score >= 80) return 3;
+    if (score >= 70) return 2;
+    if (score >= 60) return 1;
+    return 0;
+}
+
+// Function 52: Aggregate a whole score column from scratch with the selected kernel
+void computeCourseAggregate(const StudentTable *table, int course, CourseAggregate *aggregate) {
+    if (table->tenths) {
+        aggregateTenths(table->scores[course], table->count, aggregate);
+    } else {
+        aggregateColumn(table->scores[course], table->count, aggregate);
+    }
+}
+
+// Function 53: Build the running aggregates and histograms the first time they are needed
+int ensureAggregates(StudentTable *table) {
+    int j;
+
+    if (table->aggregates == NULL) {
+        if ((table->aggregates = malloc(table->courseCount * sizeof(CourseAggregate))) == NULL) {
+            return 0;
+        }
+        aggregateCourses(table, 0, table->courseCount, table->aggregates);
+        for (j = 0; j < table->courseCount; j++) {
+            if (table->aggregates[j].count != table->count) {
+                // The parallel path could not get memory for its partials
+                computeCourseAggregate(table, j, &table->aggregates[j]);
+            }
+        }
+    }
+    if (table->distributions == NULL) {
+        if ((table->distributions = calloc(table->courseCount + 1, sizeof(Distribution))) == NULL) {
+            return 0;
+        }
+        if (!buildDistributions(table, table->distributions)) {
+            free(table->distributions);
+            table->distributions = NULL;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Function 54: Fold a newly stored row into the running aggregates, O(courses)
+void addRowToAggregates(StudentTable *table, int row) {
+    int j;
+
+    if (table->aggregates == NULL) return;
+
+    for (j = 0; j < table->courseCount; j++) {
+        addScoreToAggregate(&table->aggregates[j], scoreAt(table, j, row));
+    }
+
+    if (table->distributions != NULL) {
+        for (j = 0; j < table->courseCount; j++) {
+            float score = scoreAt(table, j, row);
+            updateDistribution(&table->distributions[j], score, scoreBin(score), 1);
+        }
+        updateDistribution(&table->distributions[table->courseCount], table->totals[row], totalBin(table, row), 1);
+    }
+}
+
+// Function 55: Take a row that is about to change or disappear out of the aggregates, O(courses)
+void removeRowFromAggregates(StudentTable *table, int row) {
+    int j;
+
+    if (table->aggregates == NULL) return;
+
+    for (j = 0; j < table->courseCount; j++) {
+        CourseAggregate *course = &table->aggregates[j];
+        float score = scoreAt(table, j, row);
+        int64_t fixed = scoreToFixed(score);
+
+        course->sum -= fixed;
+        course->sumSquares -= squareToFixed(score);
+        course->bands[gradeBand(score)]--;
+        course->count--;
+
+        // Losing the last copy of an extreme needs a rescan, deferred until it is read
+        if (score == course->lowest && --course->lowestCount == 0) course->extremesStale = 1;
+        if (score == course->highest && --course->highestCount == 0) course->extremesStale = 1;
+    }
+
+    if (table->distributions != NULL) {
+        for (j = 0; j < table->courseCount; j++) {
+            float score = scoreAt(table, j, row);
+            updateDistribution(&table->distributions[j], score, scoreBin(score), -1);
+        }
+        updateDistribution(&table->distributions[table->courseCount], table->totals[row], totalBin(table, row), -1);
+    }
+}
+
+// Function 56: A course's aggregate with its extremes brought up to date
+const CourseAggregate *getCourseAggregate(StudentTable *table, int course) {
+    CourseAggregate *aggregate = &table->aggregates[course];
+
+    if (aggregate->extremesStale) {
+        // Fallback: recompute the column once instead of on every removal
+        aggregateCourses(table, course, 1, aggregate);
+    }
+    return aggregate;
+}
+
+// Function 57: Debug self-check: compare running aggregates with a full recomputation
+int verifyAggregates(StudentTable *table) {
+    CourseAggregate fresh;
+    int j, ok = 1, band;
+    long mismatches;
+
+    if (table->aggregates == NULL) {
+        return 1;
+    }
+    for (j = 0; j < table->courseCount; j++) {
+        const CourseAggregate *running = getCourseAggregate(table, j);
+
+        // The scalar kernel is the reference, so this also checks the vector kernels
+        if (table->tenths) {
+            aggregateTenths(table->scores[j], table->count, &fresh);
+        } else {
+            aggregateColumnScalar(table->scores[j], table->count, &fresh);
+        }
+        if (running->count != fresh.count || running->sum != fresh.sum ||
+            running->sumSquares != fresh.sumSquares ||
+            (fresh.count > 0 && (running->lowest != fresh.lowest || running->highest != fresh.highest ||
+                                 running->lowestCount != fresh.lowestCount ||
+                                 running->highestCount != fresh.highestCount))) {
+            ok = 0;
+        }
+        for (band = 0; band < GRADE_BANDS; band++) {
+            ok = ok && running->bands[band] == fresh.bands[band];
+        }
+        if (!ok) {
+            printf("\nSELF-CHECK FAILED: course %d aggregates differ from a full recomputation.\n", j + 1);
+            printf("  running: count %ld, total %.4f, lowest %.2f, highest %.2f\n",
+                   running->count, running->sum / SCORE_FIXED_ONE, running->lowest, running->highest);
+            printf("  fresh:   count %ld, total %.4f, lowest %.2f, highest %.2f\n",
+                   fresh.count, fresh.sum / SCORE_FIXED_ONE, fresh.lowest, fresh.highest);
+            return 0;
+        }
+    }
+    if ((mismatches = recomputeStudentTotals(table, 0)) > 0) {
+        printf("\nSELF-CHECK FAILED: %ld stored totals differ from their scores.\n", mismatches);
+        return 0;
+    }
+    if (!verifyDistributions(table) || !verifyRangeIndexes(table)) {
+        return 0;
+    }
+    printf("\nSelf-check passed: running aggregates match a full recomputation.\n");
+    return 1;
+}
+
+// Function 58: Squared score as a fixed-point integer; the square of a float is exact in a double
+int64_t squareToFixed(float score) {
+    double value = score;
+    return roundToInt64(value * value * SQUARE_FIXED_ONE);
+}
+
+// Function 59: Round a double below 2^51 to the nearest integer the same way the vector kernels do
+int64_t roundToInt64(double value) {
+    double shifted = value + ROUNDING_MAGIC;
+    int64_t bits;
+
+    memcpy(&bits, &shifted, sizeof(bits));
+    return bits - ROUNDING_MAGIC_BITS;
+}
+
+// Function 60: Reference kernel: sum, sum of squares, extremes and grade bands of a column
+void aggregateColumnScalar(const float *column, int n, CourseAggregate *aggregate) {
+    int i;
+
+    memset(aggregate, 0, sizeof(*aggregate));
+    aggregate->lowest = 100;
+    aggregate->highest = 0;
+
+    for (i = 0; i < n; i++) {
+        float score = column[i];
+
+        aggregate->sum += scoreToFixed(score);
+        aggregate->sumSquares += squareToFixed(score);
+        aggregate->bands[gradeBand(score)]++;
+        if (score < aggregate->lowest) aggregate->lowest = score;
+        if (score > aggregate->highest) aggregate->highest = score;
+    }
+    for (i = 0; i < n; i++) {
+        aggregate->lowestCount += column[i] == aggregate->lowest;
+        aggregate->highestCount += column[i] == aggregate->highest;
+    }
+    aggregate->count = n;
+}
+
+#ifdef HAVE_X86_KERNELS
+// Function 61: 4-wide kernel; grade bands come from compare masks instead of branches
+__attribute__((target("sse2")))
+void aggregateColumnSse2(const float *column, int n, CourseAggregate *aggregate) {
+    const __m128 at90 = _mm_set1_ps(90), at80 = _mm_set1_ps(80), at70 = _mm_set1_ps(70), at60 = _mm_set1_ps(60);
+    const __m128d scoreScale = _mm_set1_pd(SCORE_FIXED_ONE), squareScale = _mm_set1_pd(SQUARE_FIXED_ONE);
+    const __m128d magic = _mm_set1_pd(ROUNDING_MAGIC);
+    __m128 lowest = _mm_set1_ps(100), highest = _mm_set1_ps(0);
+    __m128i ge90 = _mm_setzero_si128(), ge80 = ge90, ge70 = ge90, ge60 = ge90;
+    __m128i sum = _mm_setzero_si128(), squares = sum, lowCount = sum, highCount = sum;
+    int64_t lanes[2], rawSum, rawSquares;
+    int32_t counts[4][4];
+    float lows[4], highs[4];
+    long above[4] = {0, 0, 0, 0};
+    int i, k, vectorEnd = n & ~3;
+
+    memset(aggregate, 0, sizeof(*aggregate));
+
+    for (i = 0; i < vectorEnd; i += 4) {
+        __m128 v = _mm_loadu_ps(column + i);
+        __m128d halves[2];
+
+        lowest = _mm_min_ps(lowest, v);
+        highest = _mm_max_ps(highest, v);
+
+        // A true compare is all ones, i.e. -1, so subtracting the mask counts it
+        ge90 = _mm_sub_epi32(ge90, _mm_castps_si128(_mm_cmpge_ps(v, at90)));
+        ge80 = _mm_sub_epi32(ge80, _mm_castps_si128(_mm_cmpge_ps(v, at80)));
+        ge70 = _mm_sub_epi32(ge70, _mm_castps_si128(_mm_cmpge_ps(v, at70)));
+        ge60 = _mm_sub_epi32(ge60, _mm_castps_si128(_mm_cmpge_ps(v, at60)));
+
+        // Raw bits of value + magic; the magic offset is removed once at the end
+        halves[0] = _mm_cvtps_pd(v);
+        halves[1] = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+        for (k = 0; k < 2; k++) {
+            sum = _mm_add_epi64(sum, _mm_castpd_si128(_mm_add_pd(_mm_mul_pd(halves[k], scoreScale), magic)));
+            squares = _mm_add_epi64(squares, _mm_castpd_si128(
+                _mm_add_pd(_mm_mul_pd(_mm_mul_pd(halves[k], halves[k]), squareScale), magic)));
+        }
+    }
+
+    _mm_storeu_ps(lows, lowest);
+    _mm_storeu_ps(highs, highest);
+    aggregate->lowest = 100;
+    aggregate->highest = 0;
+    for (k = 0; k < 4; k++) {
+        if (lows[k] < aggregate->lowest) aggregate->lowest = lows[k];
+        if (highs[k] > aggregate->highest) aggregate->highest = highs[k];
+    }
+
+    _mm_storeu_si128((__m128i *)counts[0], ge90);
+    _mm_storeu_si128((__m128i *)counts[1], ge80);
+    _mm_storeu_si128((__m128i *)counts[2], ge70);
+    _mm_storeu_si128((__m128i *)counts[3], ge60);
+    for (k = 0; k < 4; k++) {
+        above[k] = (long)counts[k][0] + counts[k][1] + counts[k][2] + counts[k][3];
+    }
+
+    _mm_storeu_si128((__m128i *)lanes, sum);
+    rawSum = (int64_t)((uint64_t)lanes[0] + (uint64_t)lanes[1] - (uint64_t)vectorEnd * ROUNDING_MAGIC_BITS);
+    _mm_storeu_si128((__m128i *)lanes, squares);
+    rawSquares = (int64_t)((uint64_t)lanes[0] + (uint64_t)lanes[1] - (uint64_t)vectorEnd * ROUNDING_MAGIC_BITS);
+    aggregate->sum = rawSum;
+    aggregate->sumSquares = rawSquares;
+
+    // Leftover scores
+    for (i = vectorEnd; i < n; i++) {
+        float score = column[i];
+        aggregate->sum += scoreToFixed(score);
+        aggregate->sumSquares += squareToFixed(score);
+        above[0] += score >= 90;
+        above[1] += score >= 80;
+        above[2] += score >= 70;
+        above[3] += score >= 60;
+        if (score < aggregate->lowest) aggregate->lowest = score;
+        if (score > aggregate->highest) aggregate->highest = score;
+    }
+
+    aggregate->bands[4] = above[0];
+    aggregate->bands[3] = above[1] - above[0];
+    aggregate->bands[2] = above[2] - above[1];
+    aggregate->bands[1] = above[3] - above[2];
+    aggregate->bands[0] = n - above[3];
+
+    // Second pass counts the rows holding each extreme
+    lowest = _mm_set1_ps(aggregate->lowest);
+    highest = _mm_set1_ps(aggregate->highest);
+    for (i = 0; i < vectorEnd; i += 4) {
+        __m128 v = _mm_loadu_ps(column + i);
+        lowCount = _mm_sub_epi32(lowCount, _mm_castps_si128(_mm_cmpeq_ps(v, lowest)));
+        highCount = _mm_sub_epi32(highCount, _mm_castps_si128(_mm_cmpeq_ps(v, highest)));
+    }
+    _mm_storeu_si128((__m128i *)counts[0], lowCount);
+    _mm_storeu_si128((__m128i *)counts[1], highCount);
+    aggregate->lowestCount = (long)counts[0][0] + counts[0][1] + counts[0][2] + counts[0][3];
+    aggregate->highestCount = (long)counts[1][0] + counts[1][1] + counts[1][2] + counts[1][3];
+    for (i = vectorEnd; i < n; i++) {
+        aggregate->lowestCount += column[i] == aggregate->lowest;
+        aggregate->highestCount += column[i] == aggregate->highest;
+    }
+    aggregate->count = n;
+}
+
+// Function 62: 8-wide AVX2 version of the column kernel
+__attribute__((target("avx2")))
+void aggregateColumnAvx2(const float *column, int n, CourseAggregate *aggregate) {
+    const __m256 at90 = _mm256_set1_ps(90), at80 = _mm256_set1_ps(80);
+    const __m256 at70 = _mm256_set1_ps(70), at60 = _mm256_set1_ps(60);
+    const __m256d scoreScale = _mm256_set1_pd(SCORE_FIXED_ONE), squareScale = _mm256_set1_pd(SQUARE_FIXED_ONE);
+    const __m256d magic = _mm256_set1_pd(ROUNDING_MAGIC);
+    __m256 lowest = _mm256_set1_ps(100), highest = _mm256_set1_ps(0);
+    __m256i ge90 = _mm256_setzero_si256(), ge80 = ge90, ge70 = ge90, ge60 = ge90;
+    __m256i sum = _mm256_setzero_si256(), squares = sum, lowCount = sum, highCount = sum;
+    int64_t lanes[4], rawSum = 0, rawSquares = 0;
+    int32_t counts[4][8];
+    float lows[8], highs[8];
+    long above[4] = {0, 0, 0, 0};
+    int i, k, vectorEnd = n & ~7;
+
+    memset(aggregate, 0, sizeof(*aggregate));
+
+    for (i = 0; i < vectorEnd; i += 8) {
+        __m256 v = _mm256_loadu_ps(column + i);
+        __m256d halves[2];
+
+        lowest = _mm256_min_ps(lowest, v);
+        highest = _mm256_max_ps(highest, v);
+
+        ge90 = _mm256_sub_epi32(ge90, _mm256_castps_si256(_mm256_cmp_ps(v, at90, _CMP_GE_OQ)));
+        ge80 = _mm256_sub_epi32(ge80, _mm256_castps_si256(_mm256_cmp_ps(v, at80, _CMP_GE_OQ)));
+        ge70 = _mm256_sub_epi32(ge70, _mm256_castps_si256(_mm256_cmp_ps(v, at70, _CMP_GE_OQ)));
+        ge60 = _mm256_sub_epi32(ge60, _mm256_castps_si256(_mm256_cmp_ps(v, at60, _CMP_GE_OQ)));
+
+        halves[0] = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+        halves[1] = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+        for (k = 0; k < 2; k++) {
+            sum = _mm256_add_epi64(sum, _mm256_castpd_si256(
+                _mm256_add_pd(_mm256_mul_pd(halves[k], scoreScale), magic)));
+            squares = _mm256_add_epi64(squares, _mm256_castpd_si256(
+                _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(halves[k], halves[k]), squareScale), magic)));
+        }
+    }
+
+    _mm256_storeu_ps(lows, lowest);
+    _mm256_storeu_ps(highs, highest);
+    aggregate->lowest = 100;
+    aggregate->highest = 0;
+    for (k = 0; k < 8; k++) {
+        if (lows[k] < aggregate->lowest) aggregate->lowest = lows[k];
+        if (highs[k] > aggregate->highest) aggregate->highest = highs[k];
+    }
+
+    _mm256_storeu_si256((__m256i *)counts[0], ge90);
+    _mm256_storeu_si256((__m256i *)counts[1], ge80);
+    _mm256_storeu_si256((__m256i *)counts[2], ge70);
+    _mm256_storeu_si256((__m256i *)counts[3], ge60);
+    for (k = 0; k < 4; k++) {
+        for (i = 0; i < 8; i++) above[k] += counts[k][i];
+    }
+
+    _mm256_storeu_si256((__m256i *)lanes, sum);
+    for (k = 0; k < 4; k++) rawSum = (int64_t)((uint64_t)rawSum + (uint64_t)lanes[k]);
+    _mm256_storeu_si256((__m256i *)lanes, squares);
+    for (k = 0; k < 4; k++) rawSquares = (int64_t)((uint64_t)rawSquares + (uint64_t)lanes[k]);
+    aggregate->sum = (int64_t)((uint64_t)rawSum - (uint64_t)vectorEnd * ROUNDING_MAGIC_BITS);
+    aggregate->sumSquares = (int64_t)((uint64_t)rawSquares - (uint64_t)vectorEnd * ROUNDING_MAGIC_BITS);
+
+    for (i = vectorEnd; i < n; i++) {
+        float score = column[i];
+        aggregate->sum += scoreToFixed(score);
+        aggregate->sumSquares += squareToFixed(score);
+        above[0] += score >= 90;
+        above[1] += score >= 80;
+        above[2] += score >= 70;
+        above[3] += score >= 60;
+        if (score < aggregate->lowest) aggregate->lowest = score;
+        if (score > aggregate->highest) aggregate->highest = score;
+    }
+
+    aggregate->bands[4] = above[0];
+    aggregate->bands[3] = above[1] - above[0];
+    aggregate->bands[2] = above[2] - above[1];
+    aggregate->bands[1] = above[3] - above[2];
+    aggregate->bands[0] = n - above[3];
+
+    lowest = _mm256_set1_ps(aggregate->lowest);
+    highest = _mm256_set1_ps(aggregate->highest);
+    for (i = 0; i < vectorEnd; i += 8) {
+        __m256 v = _mm256_loadu_ps(column + i);
+        lowCount = _mm256_sub_epi32(lowCount, _mm256_castps_si256(_mm256_cmp_ps(v, lowest, _CMP_EQ_OQ)));
+        highCount = _mm256_sub_epi32(highCount, _mm256_castps_si256(_mm256_cmp_ps(v, highest, _CMP_EQ_OQ)));
+    }
+    _mm256_storeu_si256((__m256i *)counts[0], lowCount);
+    _mm256_storeu_si256((__m256i *)counts[1], highCount);
+    for (k = 0; k < 8; k++) {
+        aggregate->lowestCount += counts[0][k];
+        aggregate->highestCount += counts[1][k];
+    }
+    for (i = vectorEnd; i < n; i++) {
+        aggregate->lowestCount += column[i] == aggregate->lowest;
+        aggregate->highestCount += column[i] == aggregate->highest;
+    }
+    aggregate->count = n;
+}
+#else
+// Function 61: Without x86 vector units the 4-wide kernel is the scalar one
+void aggregateColumnSse2(const float *column, int n, CourseAggregate *aggregate) {
+    aggregateColumnScalar(column, n, aggregate);
+}
+
+// Function 62: Without x86 vector units the 8-wide kernel is the scalar one
+void aggregateColumnAvx2(const float *column, int n, CourseAggregate *aggregate) {
+    aggregateColumnScalar(column, n, aggregate);
+}
+#endif
+
+// Function 63: Pick the widest statistics kernel this CPU supports ("auto"), or a named one
+int selectStatisticsKernel(const char *requested) {
+    int haveSse2 = 0, haveAvx2 = 0;
+
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    haveSse2 = __builtin_cpu_supports("sse2");
+    haveAvx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    if (strcmp(requested, "auto") == 0) {
+        requested = haveAvx2 ? "avx2" : haveSse2 ? "sse2" : "scalar";
+    }
+
+    if (strcmp(requested, "avx2") == 0 && haveAvx2) {
+        aggregateColumn = aggregateColumnAvx2;
+    } else if (strcmp(requested, "sse2") == 0 && haveSse2) {
+        aggregateColumn = aggregateColumnSse2;
+    } else if (strcmp(requested, "scalar") == 0) {
+        aggregateColumn = aggregateColumnScalar;
+    } else {
+        printf("ERROR: Statistics kernel '%s' is not available on this CPU.\n", requested);
+        return 0;
+    }
+    statisticsKernelName = requested;
+    return 1;
+}
+
+// Function 64: Start threadCount - 1 workers; the caller acts as the last one
+int startWorkerPool(int threadCount) {
+    int i;
+
+    memset(&workerPool, 0, sizeof(workerPool));
+    pthread_mutex_init(&workerPool.lock, NULL);
+    pthread_cond_init(&workerPool.wake, NULL);
+    pthread_cond_init(&workerPool.done, NULL);
+    workerPool.threadCount = 1;
+
+    if (threadCount > 1) {
+        if ((workerPool.threads = calloc(threadCount - 1, sizeof(pthread_t))) == NULL) {
+            return 0;
+        }
+        for (i = 0; i < threadCount - 1; i++) {
+            if (pthread_create(&workerPool.threads[i], NULL, workerMain, (void *)(intptr_t)(i + 1)) != 0) {
+                break;
+            }
+            workerPool.threadCount++;
+        }
+    }
+    return 1;
+}
+
+// Function 65: Stop and join every worker
+void stopWorkerPool(void) {
+    int i;
+
+    pthread_mutex_lock(&workerPool.lock);
+    workerPool.stopping = 1;
+    pthread_cond_broadcast(&workerPool.wake);
+    pthread_mutex_unlock(&workerPool.lock);
+
+    for (i = 0; i < workerPool.threadCount - 1; i++) {
+        pthread_join(workerPool.threads[i], NULL);
+    }
+    free(workerPool.threads);
+    workerPool.threads = NULL;
+    workerPool.threadCount = 1;
+}
+
+// Function 66: Worker loop: wait for a job, run this worker's part, report back
+void *workerMain(void *argument) {
+    int part = (int)(intptr_t)argument, begin, end;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&workerPool.lock);
+    while (1) {
+        while (!workerPool.stopping && workerPool.generation == seen) {
+            pthread_cond_wait(&workerPool.wake, &workerPool.lock);
+        }
+        if (workerPool.stopping) {
+            break;
+        }
+        seen = workerPool.generation;
+        pthread_mutex_unlock(&workerPool.lock);
+
+        partRange(workerPool.rowCount, part, workerPool.threadCount, &begin, &end);
+        workerPool.task(workerPool.context, part, begin, end);
+
+        pthread_mutex_lock(&workerPool.lock);
+        if (--workerPool.pending == 0) {
+            pthread_cond_signal(&workerPool.done);
+        }
+    }
+    pthread_mutex_unlock(&workerPool.lock);
+    return NULL;
+}
+
+// Function 67: Split rowCount rows across the pool and wait for every part
+void runParallel(RangeTask task, void *context, int rowCount) {
+    int begin, end;
+
+    if (workerPool.threadCount <= 1) {
+        task(context, 0, 0, rowCount);
+        return;
+    }
+
+    pthread_mutex_lock(&workerPool.lock);
+    workerPool.task = task;
+    workerPool.context = context;
+    workerPool.rowCount = rowCount;
+    workerPool.pending = workerPool.threadCount - 1;
+    workerPool.generation++;
+    pthread_cond_broadcast(&workerPool.wake);
+    pthread_mutex_unlock(&workerPool.lock);
+
+    partRange(rowCount, 0, workerPool.threadCount, &begin, &end);
+    task(context, 0, begin, end);
+
+    pthread_mutex_lock(&workerPool.lock);
+    while (workerPool.pending > 0) {
+        pthread_cond_wait(&workerPool.done, &workerPool.lock);
+    }
+    pthread_mutex_unlock(&workerPool.lock);
+}
+
+// Function 68: Rows [begin, end) of one part; boundaries fall on 64-row blocks
+void partRange(int rowCount, int part, int parts, int *begin, int *end) {
+    long blocks = (rowCount + 63) / 64;
+
+    *begin = (int)(blocks * part / parts * 64);
+    *end = (int)(blocks * (part + 1) / parts * 64);
+    if (*begin > rowCount) *begin = rowCount;
+    if (*end > rowCount) *end = rowCount;
+}
+
+// Function 69: One part of a parallel aggregation: every requested course over a row range
+void aggregateRangeTask(void *context, int part, int begin, int end) {
+    AggregateJob *job = context;
+    int j;
+
+    for (j = 0; j < job->courseCount; j++) {
+        CourseAggregate *partial = &job->partials[part * job->courseCount + j];
+
+        if (job->table->tenths) {
+            aggregateTenths((const uint16_t *)job->table->scores[job->firstCourse + j] + begin, end - begin, partial);
+        } else {
+            aggregateColumn((const float *)job->table->scores[job->firstCourse + j] + begin, end - begin, partial);
+        }
+    }
+}
+
+// Function 70: Aggregate several course columns, in parallel for large tables
+void aggregateCourses(const StudentTable *table, int firstCourse, int courseCount, CourseAggregate *out) {
+    AggregateJob job;
+    int part, j;
+
+    if (table->count < PARALLEL_MIN_ROWS || workerPool.threadCount <= 1 ||
+        (job.partials = malloc(workerPool.threadCount * courseCount * sizeof(CourseAggregate))) == NULL) {
+        for (j = 0; j < courseCount; j++) {
+            computeCourseAggregate(table, firstCourse + j, &out[j]);
+        }
+        return;
+    }
+
+    job.table = table;
+    job.firstCourse = firstCourse;
+    job.courseCount = courseCount;
+    runParallel(aggregateRangeTask, &job, table->count);
+
+    // Partials are merged in part order; every merged field is an integer
+    // or an extreme, so the result does not depend on the thread count
+    for (j = 0; j < courseCount; j++) {
+        out[j] = job.partials[j];
+        for (part = 1; part < workerPool.threadCount; part++) {
+            mergeCourseAggregate(&out[j], &job.partials[part * courseCount + j]);
+        }
+    }
+    free(job.partials);
+}
+
+// Function 71: Fold one partial aggregate into another
+void mergeCourseAggregate(CourseAggregate *into, const CourseAggregate *part) {
+    int band;
+
+    if (part->count == 0) {
+        return;
+    }
+    if (into->count == 0) {
+        *into = *part;
+        return;
+    }
+
+    into->count += part->count;
+    into->sum += part->sum;
+    into->sumSquares += part->sumSquares;
+    for (band = 0; band < GRADE_BANDS; band++) {
+        into->bands[band] += part->bands[band];
+    }
+
+    if (part->lowest < into->lowest) {
+        into->lowest = part->lowest;
+        into->lowestCount = part->lowestCount;
+    } else if (part->lowest == into->lowest) {
+        into->lowestCount += part->lowestCount;
+    }
+    if (part->highest > into->highest) {
+        into->highest = part->highest;
+        into->highestCount = part->highestCount;
+    } else if (part->highest == into->highest) {
+        into->highestCount += part->highestCount;
+    }
+}
+
+// Function 72: Recalculate every total and average from the score columns in parallel;
+// returns how many rows held different values
+long recomputeStudentTotals(StudentTable *table, int repair) {
+    TotalsJob job;
+    long mismatches = 0, partMismatches[MAX_THREADS];
+    int part;
+
+    job.table = table;
+    job.repair = repair;
+    job.mismatches = partMismatches;
+    memset(partMismatches, 0, sizeof(partMismatches));
+
+    if (table->count < PARALLEL_MIN_ROWS) {
+        totalsRangeTask(&job, 0, 0, table->count);
+    } else {
+        runParallel(totalsRangeTask, &job, table->count);
+    }
+
+    for (part = 0; part < workerPool.threadCount; part++) {
+        mismatches += partMismatches[part];
+    }
+    if (repair && mismatches > 0) {
+        table->version++;
+        hasUnsavedChanges = 1;
+        // The totals histogram counted the old values; rebuild it when next needed
+        freeDistributions(table->distributions, table->courseCount + 1);
+        table->distributions = NULL;
+    }
+    return mismatches;
+}
+
+// Function 73: One part of the totals recalculation, summing in course order like data entry
+void totalsRangeTask(void *context, int part, int begin, int end) {
+    TotalsJob *job = context;
+    StudentTable *table = job->table;
+    float totals[256];
+    int32_t tenths[256];
+    int block, row, j, length;
+    long mismatches = 0;
+
+    // Blocks keep the partial totals in cache while every score column is streamed
+    for (block = begin; block < end; block += 256) {
+        length = (end - block < 256) ? end - block : 256;
+        if (table->tenths) {
+            // Integer sums are exact, so only the final conversion rounds
+            memset(tenths, 0, sizeof(tenths));
+            for (j = 0; j < table->courseCount; j++) {
+                const uint16_t *column = (const uint16_t *)table->scores[j] + block;
+                for (row = 0; row < length; row++) {
+                    tenths[row] += column[row];
+                }
+            }
+            for (row = 0; row < length; row++) {
+                totals[row] = tenthsValue(tenths[row]);
+            }
+        } else {
+            memset(totals, 0, sizeof(totals));
+            for (j = 0; j < table->courseCount; j++) {
+                const float *column = (const float *)table->scores[j] + block;
+                for (row = 0; row < length; row++) {
+                    totals[row] += column[row];
+                }
+            }
+        }
+        for (row = 0; row < length; row++) {
+            float average = totals[row] / table->courseCount;
+            if (totals[row] != table->totals[block + row] || average != table->averages[block + row]) {
+                mismatches++;
+                if (job->repair) {
+                    table->totals[block + row] = totals[row];
+                    table->averages[block + row] = average;
+                }
+            }
+        }
+    }
+    job->mismatches[part] = mismatches;
+}
+
+// Function 74: Timing line printed under each report
+void printReportTiming(const struct timespec *began) {
+    printf("\n(Report computed in %.3f ms on %d thread%s, %s kernel)\n", elapsedSeconds(began) * 1e3,
+           workerPool.threadCount, workerPool.threadCount == 1 ? "" : "s", statisticsKernelName);
+}
+
+// Function 75: Value a ranking or range query uses for one row: the total, the average, or one course's score
+float rankingScore(const StudentTable *table, int course, int row) {
+    if (course == RANGE_BY_AVERAGE) return table->averages[row];
+    return course == RANK_BY_TOTAL ? table->totals[row] : scoreAt(table, course, row);
+}
+
+// Function 76: Best k rows by total or by one course, best first, without sorting everything
+int selectTopRows(StudentTable *table, int course, int k, int descending, int *out) {
+    SortedView *view;
+    ViewKind kind;
+    uint32_t *keys, key;
+    int *rows, size = 0, row, i;
+
+    if (k > table->count) k = table->count;
+    if (k <= 0) return 0;
+
+    // A cached sorted view already has the answer in its first k entries once its pending rows are in
+    if (course == RANK_BY_TOTAL) {
+        kind = descending ? VIEW_TOTAL_DESC : VIEW_TOTAL_ASC;
+        view = &table->views[kind];
+        if (view->rows != NULL && view->version == table->version && getSortedView(table, kind) != NULL) {
+            memcpy(out, view->rows, k * sizeof(int));
+            return k;
+        }
+    }
+
+    // Otherwise keep a heap of the k best seen so far with the worst at the root: O(n log k)
+    keys = malloc(k * sizeof(uint32_t));
+    rows = malloc(k * sizeof(int));
+    if (keys == NULL || rows == NULL) {
+        free(keys);
+        free(rows);
+        return -1;
+    }
+
+    for (row = 0; row < table->count; row++) {
+        key = floatSortKey(rankingScore(table, course, row));
+        if (size < k) {
+            keys[size] = key;
+            rows[size] = row;
+            size++;
+            if (size == k) {
+                for (i = k / 2 - 1; i >= 0; i--) siftDownWorst(keys, rows, k, i, descending);
+            }
+        } else if (rankedBefore(key, row, keys[0], rows[0], descending)) {
+            keys[0] = key;
+            rows[0] = row;
+            siftDownWorst(keys, rows, k, 0, descending);
+        }
+    }
+    if (size < k) {
+        for (i = size / 2 - 1; i >= 0; i--) siftDownWorst(keys, rows, size, i, descending);
+    }
+
+    // Popping the worst repeatedly fills the output from the back
+    for (i = size - 1; i >= 0; i--) {
+        out[i] = rows[0];
+        keys[0] = keys[i];
+        rows[0] = rows[i];
+        siftDownWorst(keys, rows, i, 0, descending);
+    }
+
+    free(keys);
+    free(rows);
+    return size;
+}
+
+// Function 77: Restore the heap below a slot so its worst-ranked entry is on top
+void siftDownWorst(uint32_t *keys, int *rows, int size, int at, int descending) {
+    int child, worst;
+    uint32_t key;
+    int row;
+
+    while ((child = 2 * at + 1) < size) {
+        worst = child;
+        if (child + 1 < size && rankedBefore(keys[child], rows[child], keys[child + 1], rows[child + 1], descending)) {
+            worst = child + 1;
+        }
+        if (!rankedBefore(keys[at], rows[at], keys[worst], rows[worst], descending)) {
+            break;
+        }
+        key = keys[at]; keys[at] = keys[worst]; keys[worst] = key;
+        row = rows[at]; rows[at] = rows[worst]; rows[worst] = row;
+        at = worst;
+    }
+}
+
+// Function 78: Whether entry A ranks ahead of entry B; ties go to the earlier row like the sorts
+int rankedBefore(uint32_t keyA, int rowA, uint32_t keyB, int rowB, int descending) {
+    if (keyA != keyB) {
+        return descending ? keyA > keyB : keyA < keyB;
+    }
+    return rowA < rowB;
+}
+
+// Function 79: Students with a higher and with an equal total, O(log n) when a total view is cached
+void countAroundTotal(StudentTable *table, float total, long *greater, long *equal) {
+    const SortedView *view = &table->views[VIEW_TOTAL_DESC];
+    const float *totals = table->totals;
+    long lo, hi, mid, first;
+    int row;
+
+    if (view->rows != NULL && view->version == table->version && getSortedView(table, VIEW_TOTAL_DESC) != NULL) {
+        // Lower and upper bound of the total in the descending order
+        for (lo = 0, hi = table->count; lo < hi; ) {
+            mid = lo + (hi - lo) / 2;
+            if (totals[view->rows[mid]] > total) lo = mid + 1; else hi = mid;
+        }
+        first = lo;
+        for (hi = table->count; lo < hi; ) {
+            mid = lo + (hi - lo) / 2;
+            if (totals[view->rows[mid]] >= total) lo = mid + 1; else hi = mid;
+        }
+        *greater = first;
+        *equal = lo - first;
+        return;
+    }
+
+    view = &table->views[VIEW_TOTAL_ASC];
+    if (view->rows != NULL && view->version == table->version && getSortedView(table, VIEW_TOTAL_ASC) != NULL) {
+        for (lo = 0, hi = table->count; lo < hi; ) {
+            mid = lo + (hi - lo) / 2;
+            if (totals[view->rows[mid]] < total) lo = mid + 1; else hi = mid;
+        }
+        first = lo;
+        for (hi = table->count; lo < hi; ) {
+            mid = lo + (hi - lo) / 2;
+            if (totals[view->rows[mid]] <= total) lo = mid + 1; else hi = mid;
+        }
+        *greater = table->count - lo;
+        *equal = lo - first;
+        return;
+    }
+
+    // No cached order: one branch-free pass
+    *greater = *equal = 0;
+    for (row = 0; row < table->count; row++) {
+        *greater += totals[row] > total;
+        *equal += totals[row] == total;
+    }
+}
+
+// Function 80: Show the best or worst K students by total or by one course
+void showTopStudents(StudentTable *table) {
+    int course, k, i, row, found, *rows;
+    char direction;
+    struct timespec began;
+
+    printf("\nRank by (0 = total score, 1-%d = course): ", table->courseCount);
+    if (scanf("%d", &course) != 1 || course < 0 || course > table->courseCount) {
+        printf("ERROR: Invalid choice.\n");
+        clearInputBuffer();
+        return;
+    }
+    printf("How many students: ");
+    if (scanf("%d", &k) != 1 || k <= 0) {
+        printf("ERROR: Please enter a positive number.\n");
+        clearInputBuffer();
+        return;
+    }
+    printf("Top or bottom (t/b): ");
+    if (scanf(" %c", &direction) != 1 || (direction != 't' && direction != 'T' && direction != 'b' && direction != 'B')) {
+        printf("ERROR: Please enter t or b.\n");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+
+    if (k > table->count) k = table->count;
+    if ((rows = malloc(k * sizeof(int))) == NULL) {
+        printf("\nERROR: Not enough memory.\n");
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    course = (course == 0) ? RANK_BY_TOTAL : course - 1;
+    found = selectTopRows(table, course, k, direction == 't' || direction == 'T', rows);
+    if (found < 0) {
+        printf("\nERROR: Not enough memory.\n");
+        free(rows);
+        return;
+    }
+
+    printf("\n============================================\n");
+    if (course == RANK_BY_TOTAL) {
+        printf("   %s %d STUDENTS BY TOTAL SCORE\n", (direction == 't' || direction == 'T') ? "TOP" : "BOTTOM", found);
+    } else {
+        printf("   %s %d STUDENTS IN COURSE %d\n", (direction == 't' || direction == 'T') ? "TOP" : "BOTTOM", found, course + 1);
+    }
+    printf("============================================\n");
+    printf("  #  Student ID    Student Name             Score\n");
+    for (i = 0; i < found; i++) {
+        row = rows[i];
+        printf("%3d  %-12ld  %s%*s  %8.1f\n", i + 1, table->ids[row], studentName(table, row),
+               namePadding(studentName(table, row), 20), "", rankingScore(table, course, row));
+    }
+    free(rows);
+    printReportTiming(&began);
+}
+
+// Function 81: Show a student's rank and percentile by total score
+void showStudentRank(StudentTable *table) {
+    long searchId, greater, equal;
+    int row;
+
+    printf("\nEnter Student ID: ");
+    if (scanf("%ld", &searchId) != 1) {
+        printf("ERROR: Invalid input.\n");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+
+    if ((row = findStudentById(table, searchId)) < 0) {
+        printf("\nERROR: Student with ID %ld not found.\n", searchId);
+        return;
+    }
+
+    // Competition ranking: tied students share the best rank of the tie
+    countAroundTotal(table, table->totals[row], &greater, &equal);
+    printf("\nID: %ld, Name: %s\n", table->ids[row], studentName(table, row));
+    printf("  Total Score: %.1f\n", table->totals[row]);
+    printf("  Rank: %ld of %d", greater + 1, table->count);
+    if (equal > 1) {
+        printf(" (tied with %ld other%s)", equal - 1, equal == 2 ? "" : "s");
+    }
+    // Percentile rank: share of students below, counting ties as half
+    printf("\n  Percentile: %.1f\n", 100.0 * (table->count - greater - equal + 0.5 * equal) / table->count);
+}
+
+// Function 82: Exact histogram bin of a score, -1 unless it is a multiple of 0.1 from 0 to 100
+int scoreBin(float score) {
+    int bin;
+
+    if (!(score >= 0 && score <= 100)) {
+        return -1;
+    }
+    bin = (int)(score * 10 + 0.5f);
+    // Division is correctly rounded, so this is exactly the float "87.3" parses to
+    return ((float)bin / 10 == score) ? bin : -1;
+}
+
+// Function 83: Sketch bucket of a value from its float bits: exponent, then the top mantissa bits
+int sketchBucket(float value) {
+    uint32_t bits;
+    int octave;
+
+    if (!(value >= 1.0f / (1 << -SKETCH_MIN_EXPONENT))) {
+        return -1;
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    octave = (int)(bits >> 23) - 127 - SKETCH_MIN_EXPONENT;
+    if (octave >= SKETCH_OCTAVES) {
+        return SKETCH_BUCKETS - 1;
+    }
+    return (octave << SKETCH_SUB_BITS) | (int)((bits >> (23 - SKETCH_SUB_BITS)) & ((1 << SKETCH_SUB_BITS) - 1));
+}
+
+// Function 84: Middle of a sketch bucket, the value every member of the bucket is reported as
+float sketchBucketValue(int bucket) {
+    uint32_t bits = (uint32_t)((bucket >> SKETCH_SUB_BITS) + SKETCH_MIN_EXPONENT + 127) << 23;
+    float value;
+
+    bits |= (uint32_t)(bucket & ((1 << SKETCH_SUB_BITS) - 1)) << (23 - SKETCH_SUB_BITS);
+    bits |= 1u << (22 - SKETCH_SUB_BITS);
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Function 85: Add (delta 1) or remove (delta -1) one value whose exact bin is given, -1 when it
+// has none, O(1)
+void updateDistribution(Distribution *distribution, float value, int bin, long delta) {
+    int bucket;
+
+    distribution->count += delta;
+    distribution->sum += delta * roundToInt64((double)value * DISTRIBUTION_SUM_ONE);
+    distribution->sumSquares += delta * roundToInt64((double)value * value * DISTRIBUTION_SQUARE_ONE);
+    if (distribution->bins != NULL && bin >= 0 && bin < distribution->binCount) {
+        distribution->bins[bin] += delta;
+    } else {
+        distribution->offGrid += delta;
+    }
+    if (distribution->sketch != NULL) {
+        if ((bucket = sketchBucket(value)) < 0) {
+            distribution->sketchZero += delta;
+        } else {
+            distribution->sketch[bucket] += delta;
+        }
+    }
+}
+
+// Function 86: Exact histograms of every course and of the totals, in parallel for large tables;
+// out holds courseCount + 1 zeroed entries
+int buildDistributions(const StudentTable *table, Distribution *out) {
+    DistributionJob job;
+    int fields = table->courseCount + 1, parts, part, j, ok = 1;
+
+    parts = (table->count < PARALLEL_MIN_ROWS) ? 1 : workerPool.threadCount;
+    if ((job.partials = calloc((size_t)parts * fields, sizeof(Distribution))) == NULL) {
+        return 0;
+    }
+    for (part = 0; part < parts && ok; part++) {
+        for (j = 0; j < fields && ok; j++) {
+            Distribution *partial = &job.partials[part * fields + j];
+            partial->binCount = j < table->courseCount ? SCORE_BINS : table->courseCount * (SCORE_BINS - 1) + 1;
+            ok = (partial->bins = calloc(partial->binCount, sizeof(long))) != NULL;
+        }
+    }
+
+    if (ok) {
+        job.table = table;
+        if (parts == 1) {
+            distributionRangeTask(&job, 0, 0, table->count);
+        } else {
+            runParallel(distributionRangeTask, &job, table->count);
+        }
+
+        // Part 0's arrays become the result; every other part is added in part order
+        for (j = 0; j < fields; j++) {
+            out[j] = job.partials[j];
+            job.partials[j].bins = job.partials[j].sketch = NULL;
+            for (part = 1; part < parts; part++) {
+                mergeDistribution(&out[j], &job.partials[part * fields + j]);
+            }
+        }
+    }
+
+    for (part = 0; part < parts; part++) {
+        for (j = 0; j < fields; j++) {
+            free(job.partials[part * fields + j].bins);
+            free(job.partials[part * fields + j].sketch);
+        }
+    }
+    free(job.partials);
+
+    // A field with values off the 0.1 grid needs its sketch right away
+    for (j = 0; ok && j < fields; j++) {
+        if (out[j].offGrid > 0) {
+            ok = fillSketch(&out[j], table, j);
+        }
+    }
+    if (!ok) {
+        for (j = 0; j < fields; j++) {
+            free(out[j].bins);
+            free(out[j].sketch);
+            out[j].bins = out[j].sketch = NULL;
+        }
+    }
+    return ok;
+}
+
+// Function 87: One part of the histogram build: every course column, then the totals
+void distributionRangeTask(void *context, int part, int begin, int end) {
+    DistributionJob *job = context;
+    const StudentTable *table = job->table;
+    Distribution *partials = &job->partials[part * (table->courseCount + 1)];
+    long counts[SCORE_BINS];
+    int j, row, t;
+
+    for (j = 0; j <= table->courseCount; j++) {
+        if (j < table->courseCount && table->tenths) {
+            // Each distinct score is folded in once with its count
+            countTenths((const uint16_t *)table->scores[j] + begin, end - begin, counts);
+            for (t = 0; t < SCORE_BINS; t++) {
+                if (counts[t] > 0) updateDistribution(&partials[j], tenthsValue(t), t, counts[t]);
+            }
+            continue;
+        }
+        for (row = begin; row < end; row++) {
+            if (j < table->courseCount) {
+                float score = scoreAt(table, j, row);
+                updateDistribution(&partials[j], score, scoreBin(score), 1);
+            } else {
+                updateDistribution(&partials[j], table->totals[row], totalBin(table, row), 1);
+            }
+        }
+    }
+}
+
+// Function 88: Add one partial histogram into another with the same arrays allocated
+void mergeDistribution(Distribution *into, const Distribution *part) {
+    int i;
+
+    into->count += part->count;
+    into->offGrid += part->offGrid;
+    into->sketchZero += part->sketchZero;
+    into->sum += part->sum;
+    into->sumSquares += part->sumSquares;
+    if (into->bins != NULL) {
+        for (i = 0; i < into->binCount; i++) into->bins[i] += part->bins[i];
+    }
+    if (into->sketch != NULL) {
+        for (i = 0; i < SKETCH_BUCKETS; i++) into->sketch[i] += part->sketch[i];
+    }
+}
+
+// Function 89: Release the arrays of fieldCount histograms and the array itself
+void freeDistributions(Distribution *distributions, int fieldCount) {
+    int j;
+
+    if (distributions == NULL) {
+        return;
+    }
+    for (j = 0; j < fieldCount; j++) {
+        free(distributions[j].bins);
+        free(distributions[j].sketch);
+    }
+    free(distributions);
+}
+
+// Function 90: Start the sketch of a course (or of the totals, field courseCount) from its column;
+// it is kept up to date from then on
+int fillSketch(Distribution *distribution, const StudentTable *table, int field) {
+    int row, bucket;
+
+    if ((distribution->sketch = calloc(SKETCH_BUCKETS, sizeof(long))) == NULL) {
+        return 0;
+    }
+    distribution->sketchZero = 0;
+    for (row = 0; row < table->count; row++) {
+        float value = field < table->courseCount ? scoreAt(table, field, row) : table->totals[row];
+
+        if ((bucket = sketchBucket(value)) < 0) {
+            distribution->sketchZero++;
+        } else {
+            distribution->sketch[bucket]++;
+        }
+    }
+    return 1;
+}
+
+// Function 91: A course's histogram (or the totals' for RANK_BY_TOTAL), with a sketch when it needs one
+const Distribution *getDistribution(StudentTable *table, int course) {
+    Distribution *distribution;
+
+    if (!ensureAggregates(table)) {
+        return NULL;
+    }
+    if (course == RANK_BY_TOTAL) {
+        course = table->courseCount;
+    }
+    distribution = &table->distributions[course];
+    if (!distributionIsExact(distribution) && distribution->sketch == NULL &&
+        !fillSketch(distribution, table, course)) {
+        return NULL;
+    }
+    return distribution;
+}
+
+// Function 92: Whether quantiles come from the exact bins rather than the sketch
+int distributionIsExact(const Distribution *distribution) {
+    return distribution->bins != NULL && distribution->offGrid == 0;
+}
+
+// Function 93: Value at a 0-based position in sorted order, O(bins)
+double distributionValueAtRank(const Distribution *distribution, long rank) {
+    long seen;
+    int i;
+
+    if (distributionIsExact(distribution)) {
+        for (i = 0, seen = 0; i < distribution->binCount; i++) {
+            if ((seen += distribution->bins[i]) > rank) return (float)i / 10;
+        }
+        return (float)(distribution->binCount - 1) / 10;
+    }
+    if ((seen = distribution->sketchZero) > rank) {
+        return 0;
+    }
+    for (i = 0; i < SKETCH_BUCKETS; i++) {
+        if ((seen += distribution->sketch[i]) > rank) return sketchBucketValue(i);
+    }
+    return sketchBucketValue(SKETCH_BUCKETS - 1);
+}
+
+// Function 94: Quantile with linear interpolation between the two nearest ranks
+double distributionQuantile(const Distribution *distribution, double probability) {
+    double position = (distribution->count - 1) * probability, fraction, below, above;
+    long rank = (long)position;
+
+    fraction = position - rank;
+    below = distributionValueAtRank(distribution, rank);
+    if (fraction == 0) {
+        return below;
+    }
+    above = distributionValueAtRank(distribution, rank + 1);
+    return below + fraction * (above - below);
+}
+
+// Function 95: Population standard deviation from the running sums
+double distributionStdDev(const Distribution *distribution) {
+    long double mean, variance;
+
+    if (distribution->count <= 0) {
+        return 0;
+    }
+    mean = distribution->sum / (long double)DISTRIBUTION_SUM_ONE / distribution->count;
+    variance = distribution->sumSquares / (long double)DISTRIBUTION_SQUARE_ONE / distribution->count - mean * mean;
+    return variance > 0 ? sqrt((double)variance) : 0;
+}
+
+// Function 96: Spread lines of a statistics report
+void printDistribution(const Distribution *distribution) {
+    const char *note = distributionIsExact(distribution) ? "" : " (approximate, within 0.4%)";
+
+    printf("  Std Deviation: %.2f\n", distributionStdDev(distribution));
+    printf("  Median:        %.2f%s\n", distributionQuantile(distribution, 0.5), note);
+    printf("  Percentiles:   P10 %.2f, P25 %.2f, P75 %.2f, P90 %.2f%s\n",
+           distributionQuantile(distribution, 0.10), distributionQuantile(distribution, 0.25),
+           distributionQuantile(distribution, 0.75), distributionQuantile(distribution, 0.90), note);
+}
+
+// Function 97: Debug self-check: compare the running histograms with freshly built ones
+int verifyDistributions(StudentTable *table) {
+    Distribution *fresh, check;
+    int j, i, ok = 1;
+
+    if (table->distributions == NULL) {
+        return 1;
+    }
+    if ((fresh = calloc(table->courseCount + 1, sizeof(Distribution))) == NULL ||
+        !buildDistributions(table, fresh)) {
+        free(fresh);
+        printf("\nSELF-CHECK SKIPPED: not enough memory to rebuild the histograms.\n");
+        return 1;
+    }
+
+    for (j = 0; j <= table->courseCount && ok; j++) {
+        const Distribution *running = &table->distributions[j];
+        ok = running->count == fresh[j].count && running->offGrid == fresh[j].offGrid &&
+             running->sum == fresh[j].sum && running->sumSquares == fresh[j].sumSquares;
+        for (i = 0; ok && running->bins != NULL && i < running->binCount; i++) {
+            ok = running->bins[i] == fresh[j].bins[i];
+        }
+        // Sketches are started lazily, so rebuild one from the column to compare
+        memset(&check, 0, sizeof(check));
+        if (ok && running->sketch != NULL && fresh[j].sketch == NULL) {
+            ok = fillSketch(&check, table, j);
+        }
+        for (i = 0; ok && running->sketch != NULL && i < SKETCH_BUCKETS; i++) {
+            ok = running->sketch[i] == (fresh[j].sketch != NULL ? fresh[j].sketch : check.sketch)[i];
+        }
+        free(check.sketch);
+        if (!ok) {
+            printf("\nSELF-CHECK FAILED: %s histogram differs from a full recomputation.\n",
+                   j < table->courseCount ? "a course" : "the totals");
+        }
+    }
+    freeDistributions(fresh, table->courseCount + 1);
+    return ok;
+}
+
+// Function 98: Run batch commands from a file or stdin, one per line; returns how many failed
+long runBatch(StudentTable *table, FILE *in, FILE *out, const char *snapshotPath) {
+    BatchSession session;
+    OperationTimer timer;
+    char line[BATCH_LINE_LEN];
+    long failures = 0;
+    int status;
+    size_t length;
+
+    session.table = table;
+    session.out = out;
+    session.snapshotPath = snapshotPath;
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        length = strcspn(line, "\r\n");
+        if (line[length] == '\0' && !feof(in)) {
+            // Over-long line: drop the rest of it
+            int c;
+            while ((c = fgetc(in)) != EOF && c != '\n') {}
+            fprintf(out, "error\tcommand is too long\n");
+            failures++;
+            continue;
+        }
+        line[length] = '\0';
+
+        session.rows = 0;
+        session.error[0] = '\0';
+        beginOperation(&timer);
+        status = runBatchCommand(&session, line);
+        switch (status) {
+            case BATCH_SKIP:
+                break;
+            case BATCH_QUIT:
+                return failures;
+            default:
+                writeBatchStatus(&session, status);
+                failures += status != BATCH_OK;
+        }
+        if (status != BATCH_SKIP) {
+            endOperation(&timer, batchCommandSlot(line), session.rows);
+        }
+    }
+    return failures;
+}
+
+// Function 99: Execute one batch command line
+int runBatchCommand(BatchSession *session, char *line) {
+    char words[BATCH_LINE_LEN], *args[BATCH_MAX_ARGS], *rest[BATCH_MAX_ARGS], *cursor = words;
+    size_t length = strlen(line);
+    int argCount = 0;
+
+    while (length > 0 && (line[length - 1] == ' ' || line[length - 1] == '\t')) {
+        line[--length] = '\0';
+    }
+
+    // Split a copy on blanks; rest[i] is the untouched line from word i on, for free text
+    memcpy(words, line, length + 1);
+    while (argCount < BATCH_MAX_ARGS) {
+        while (*cursor == ' ' || *cursor == '\t') cursor++;
+        if (*cursor == '\0') break;
+        rest[argCount] = line + (cursor - words);
+        args[argCount++] = cursor;
+        while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t') cursor++;
+        if (*cursor != '\0') *cursor++ = '\0';
+    }
+    if (argCount == 0 || args[0][0] == '#') {
+        return BATCH_SKIP;
+    }
+
+    if (strcmp(args[0], "quit") == 0 || strcmp(args[0], "exit") == 0) {
+        return BATCH_QUIT;
+    }
+    if (strcmp(args[0], "load") == 0 && argCount == 2) {
+        return batchLoad(session, args[1]);
+    }
+    if (strcmp(args[0], "save") == 0 && argCount <= 2) {
+        return batchSave(session, argCount == 2 ? args[1] : session->snapshotPath);
+    }
+    if (strcmp(args[0], "insert") == 0 && argCount >= 2) {
+        return batchInsert(session, rest[1]);
+    }
+    if (strcmp(args[0], "count") == 0 && argCount == 1) {
+        fprintf(session->out, "%d\t%d\n", session->table->count, session->table->courseCount);
+        session->rows++;
+        return BATCH_OK;
+    }
+
+    if (strcmp(args[0], "stats") == 0 && argCount == 2 && strcmp(args[1], "ops") == 0) {
+        return batchOperationStats(session);
+    }
+    if (strcmp(args[0], "term") == 0 && argCount >= 2) {
+        // Terms can be looked at before any roster is loaded
+        return batchTerm(session, args + 1, argCount - 1);
+    }
+
+    if (session->table->count <= 0) {
+        return batchError(session, "no data loaded");
+    }
+    if (strcmp(args[0], "sort") == 0 && argCount >= 2) {
+        return batchSort(session, args + 1, argCount - 1);
+    }
+    if (strcmp(args[0], "list") == 0 && argCount <= 2) {
+        return batchList(session, argCount == 2 ? atol(args[1]) : -1);
+    }
+    if ((strcmp(args[0], "top") == 0 || strcmp(args[0], "bottom") == 0) && argCount >= 2) {
+        return batchTop(session, args, argCount);
+    }
+    if (strcmp(args[0], "rank") == 0 && argCount == 2) {
+        return batchRank(session, args[1]);
+    }
+    if (strcmp(args[0], "find") == 0 && argCount >= 3 && strcmp(args[1], "id") == 0) {
+        return batchFindId(session, args[2]);
+    }
+    if (strcmp(args[0], "find") == 0 && argCount >= 3 && strcmp(args[1], "name") == 0) {
+        // Names may contain spaces, so take everything after "name"
+        return batchFindName(session, rest[2]);
+    }
+    if (strcmp(args[0], "stats") == 0) {
+        return batchStats(session, args + 1, argCount - 1);
+    }
+    if (strcmp(args[0], "grades") == 0 && argCount == 1) {
+        return batchGrades(session);
+    }
+    if (strcmp(args[0], "export") == 0 && argCount == 2) {
+        return batchExport(session, args[1]);
+    }
+    if (strcmp(args[0], "update") == 0 && argCount == 4) {
+        return batchUpdate(session, args + 1);
+    }
+    if (strcmp(args[0], "rename") == 0 && argCount >= 3) {
+        return batchRename(session, args[1], rest[2]);
+    }
+    if (strcmp(args[0], "delete") == 0 && argCount == 2) {
+        return batchDelete(session, args[1]);
+    }
+    if (strcmp(args[0], "where") == 0 && argCount >= 2) {
+        return batchWhere(session, args + 1, argCount - 1);
+    }
+    if (strcmp(args[0], "group") == 0 && argCount >= 2) {
+        return batchGroup(session, args + 1, argCount - 1);
+    }
+    return batchError(session, "unknown command or wrong arguments: %s", args[0]);
+}
+
+// Function 100: Record why a batch command failed
+int batchError(BatchSession *session, const char *format, ...) {
+    va_list arguments;
+
+    va_start(arguments, format);
+    vsnprintf(session->error, sizeof(session->error), format, arguments);
+    va_end(arguments);
+    return BATCH_FAILED;
+}
+
+// Function 101: One tab-separated record: id, name, every score, total, average
+void writeBatchRecord(BatchSession *session, int row) {
+    const StudentTable *table = session->table;
+    int j;
+
+    fprintf(session->out, "%ld\t%s", table->ids[row], studentName(table, row));
+    for (j = 0; j < table->courseCount; j++) {
+        fprintf(session->out, "\t%g", scoreAt(table, j, row));
+    }
+    fprintf(session->out, "\t%g\t%g\n", table->totals[row], table->averages[row]);
+    session->rows++;
+}
+
+// Function 102: load PATH: replace the table with a snapshot or a CSV file; prints records, courses, rejects
+// and, when rows were rejected, the PATH.rejects report that lists them as --import does
+int batchLoad(BatchSession *session, const char *path) {
+    StudentTable loaded;
+    ImportSummary summary;
+    char magic[8], rejectPath[1024];
+    FILE *file;
+    int isSnapshot;
+
+    if ((file = fopen(path, "rb")) == NULL) {
+        return batchError(session, "cannot open '%s'", path);
+    }
+    isSnapshot = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                 memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+
+    memset(&summary, 0, sizeof(summary));
+    if (isSnapshot) {
+        if (!loadSnapshot(&loaded, path, 0)) {
+            return batchError(session, "cannot load snapshot '%s'", path);
+        }
+    } else {
+        snprintf(rejectPath, sizeof(rejectPath), "%s.rejects", path);
+        if (!initStudentTable(&loaded, 0) || !importStudentsCsv(&loaded, path, rejectPath, &summary)) {
+            freeStudentTable(&loaded);
+            return batchError(session, "cannot import '%s'", path);
+        }
+    }
+
+    freeStudentTable(session->table);
+    *session->table = loaded;
+    hasDataBeenEntered = loaded.count > 0;
+    hasUnsavedChanges = !isSnapshot;
+
+    // The journal only describes changes to the previous table, so start it over from this one
+    if (journal.fd >= 0) {
+        if (!checkpointTable(session->table, journal.snapshotPath)) {
+            return batchError(session, "cannot checkpoint '%s'", journal.snapshotPath);
+        }
+        hasUnsavedChanges = 0;
+    }
+    if (summary.rejected > 0) {
+        fprintf(session->out, "%d\t%d\t%ld\t%s\n", loaded.count, loaded.courseCount, summary.rejected, rejectPath);
+    } else {
+        fprintf(session->out, "%d\t%d\t%ld\n", loaded.count, loaded.courseCount, summary.rejected);
+    }
+    session->rows++;
+    return BATCH_OK;
+}
+
+// Function 103: save [PATH]: write a snapshot
+int batchSave(BatchSession *session, const char *path) {
+    if (path == NULL) {
+        return batchError(session, "no snapshot path (snapshots are disabled)");
+    }
+    if (!checkpointTable(session->table, path)) {
+        return batchError(session, "cannot save '%s'", path);
+    }
+    hasUnsavedChanges = 0;
+    return BATCH_OK;
+}
+
+// Function 104: sort total [asc|desc] | id | name, then [LIMIT]: set the listing order and list it
+int batchSort(BatchSession *session, char **args, int argCount) {
+    ViewKind kind;
+    int used = 1;
+
+    if (strcmp(args[0], "total") == 0) {
+        kind = VIEW_TOTAL_DESC;
+        if (argCount >= 2 && (strcmp(args[1], "asc") == 0 || strcmp(args[1], "desc") == 0)) {
+            kind = strcmp(args[1], "asc") == 0 ? VIEW_TOTAL_ASC : VIEW_TOTAL_DESC;
+            used = 2;
+        }
+    } else if (strcmp(args[0], "id") == 0) {
+        kind = VIEW_ID;
+    } else if (strcmp(args[0], "name") == 0) {
+        kind = VIEW_NAME;
+    } else {
+        return batchError(session, "sort by total, id or name");
+    }
+    if (argCount > used + 1) {
+        return batchError(session, "too many arguments to sort");
+    }
+
+    if (getSortedView(session->table, kind) == NULL) {
+        return batchError(session, "not enough memory to sort");
+    }
+    session->table->activeView = kind;
+    return batchList(session, argCount == used + 1 ? atol(args[used]) : -1);
+}
+
+// Function 105: list [LIMIT]: records in the current listing order
+int batchList(BatchSession *session, long limit) {
+    StudentTable *table = session->table;
+    const int *order = listingOrder(table);
+    long i;
+
+    if (limit < 0 || limit > table->count) {
+        limit = table->count;
+    }
+    for (i = 0; i < limit; i++) {
+        writeBatchRecord(session, order ? order[i] : (int)i);
+    }
+    return BATCH_OK;
+}
+
+// Function 106: top|bottom K [total | course N]: best or worst K by total or one course
+int batchTop(BatchSession *session, char **args, int argCount) {
+    StudentTable *table = session->table;
+    int k = atoi(args[1]), course = RANK_BY_TOTAL, found, i, *rows;
+
+    if (k <= 0) {
+        return batchError(session, "K must be a positive number");
+    }
+    if (argCount == 4 && strcmp(args[2], "course") == 0) {
+        course = atoi(args[3]) - 1;
+        if (course < 0 || course >= table->courseCount) {
+            return batchError(session, "course must be between 1 and %d", table->courseCount);
+        }
+    } else if (!(argCount == 2 || (argCount == 3 && strcmp(args[2], "total") == 0))) {
+        return batchError(session, "usage: %s K [total | course N]", args[0]);
+    }
+
+    if (k > table->count) k = table->count;
+    if ((rows = malloc(k * sizeof(int))) == NULL ||
+        (found = selectTopRows(table, course, k, args[0][0] == 't', rows)) < 0) {
+        free(rows);
+        return batchError(session, "not enough memory");
+    }
+    for (i = 0; i < found; i++) {
+        writeBatchRecord(session, rows[i]);
+    }
+    free(rows);
+    return BATCH_OK;
+}
+
+// Function 107: rank ID: id, rank, students, students tied, percentile
+int batchRank(BatchSession *session, const char *idText) {
+    StudentTable *table = session->table;
+    long greater, equal;
+    int row;
+
+    if ((row = findStudentById(table, atol(idText))) < 0) {
+        return BATCH_OK;
+    }
+    countAroundTotal(table, table->totals[row], &greater, &equal);
+    fprintf(session->out, "%ld\t%ld\t%d\t%ld\t%.2f\n", table->ids[row], greater + 1, table->count, equal,
+            100.0 * (table->count - greater - equal + 0.5 * equal) / table->count);
+    session->rows++;
+    return BATCH_OK;
+}
+
+// Function 108: find id ID: the matching record, if any
+int batchFindId(BatchSession *session, const char *idText) {
+    int row = findStudentById(session->table, atol(idText));
+
+    if (row >= 0) {
+        writeBatchRecord(session, row);
+    }
+    return BATCH_OK;
+}
+
+// Function 109: find name NAME | PREFIX* | ~NAME: matching records in name order
+int batchFindName(BatchSession *session, char *query) {
+    StudentTable *table = session->table;
+    const int *byName;
+    NameMatch *matches = NULL;
+    int i, first, last, found;
+    size_t length = strlen(query);
+
+    if ((byName = getSortedView(table, VIEW_NAME)) == NULL) {
+        return batchError(session, "not enough memory to search");
+    }
+    if (query[0] == SEARCH_FUZZY_MARK) {
+        found = fuzzySearchNames(table, query + 1, defaultFuzzyDistance(query + 1), &matches);
+        for (i = 0; i < found; i++) {
+            writeBatchRecord(session, matches[i].row);
+        }
+        free(matches);
+        return BATCH_OK;
+    }
+    if (length > 0 && query[length - 1] == SEARCH_PREFIX_MARK) {
+        query[length - 1] = '\0';
+        findNameRange(table, query, 1, &first, &last);
+    } else {
+        findNameRange(table, query, 0, &first, &last);
+    }
+    for (i = first; i < last; i++) {
+        writeBatchRecord(session, byName[i]);
+    }
+    return BATCH_OK;
+}
+
+// Function 110: stats [course N | total]: one line per field with count, mean, spread and quantiles
+int batchStats(BatchSession *session, char **args, int argCount) {
+    StudentTable *table = session->table;
+    int first = 0, last = table->courseCount, j;
+
+    if (argCount == 2 && strcmp(args[0], "course") == 0) {
+        first = atoi(args[1]) - 1;
+        if (first < 0 || first >= table->courseCount) {
+            return batchError(session, "course must be between 1 and %d", table->courseCount);
+        }
+        last = first;
+    } else if (argCount == 1 && strcmp(args[0], "total") == 0) {
+        first = table->courseCount;
+    } else if (argCount != 0) {
+        return batchError(session, "usage: stats [course N | total]");
+    }
+    if (!ensureAggregates(table)) {
+        return batchError(session, "not enough memory");
+    }
+
+    for (j = first; j <= last; j++) {
+        const Distribution *distribution = getDistribution(table, j < table->courseCount ? j : RANK_BY_TOTAL);
+        static const double probabilities[5] = {0.10, 0.25, 0.5, 0.75, 0.90};
+        double lowest, highest, quantiles[5];
+        int q;
+
+        if (distribution == NULL) {
+            return batchError(session, "not enough memory");
+        }
+        if (j < table->courseCount) {
+            const CourseAggregate *course = getCourseAggregate(table, j);
+            lowest = course->lowest;
+            highest = course->highest;
+            fprintf(session->out, "%d", j + 1);
+        } else if (distributionIsExact(distribution)) {
+            lowest = distributionQuantile(distribution, 0);
+            highest = distributionQuantile(distribution, 1);
+            fprintf(session->out, "total");
+        } else {
+            // Off-grid scores leave only a sketch, so read the extremes from the totals themselves
+            int row;
+            lowest = highest = table->totals[0];
+            for (row = 1; row < table->count; row++) {
+                if (table->totals[row] < lowest) lowest = table->totals[row];
+                if (table->totals[row] > highest) highest = table->totals[row];
+            }
+            fprintf(session->out, "total");
+        }
+        // Sketch quantiles can stray past the exact extremes by a step; keep them in between
+        for (q = 0; q < 5; q++) {
+            quantiles[q] = distributionQuantile(distribution, probabilities[q]);
+            if (quantiles[q] < lowest) quantiles[q] = lowest;
+            if (quantiles[q] > highest) quantiles[q] = highest;
+        }
+        fprintf(session->out, "\t%ld\t%g\t%g\t%g\t%g\t%g\t%g\t%g\t%g\t%g\t%s\n", distribution->count,
+                (double)(distribution->sum / DISTRIBUTION_SUM_ONE / distribution->count),
+                distributionStdDev(distribution), lowest, quantiles[0], quantiles[1], quantiles[2],
+                quantiles[3], quantiles[4], highest,
+                distributionIsExact(distribution) ? "exact" : "approximate");
+        session->rows++;
+    }
+    return BATCH_OK;
+}
+
+// Function 111: grades: one line per course with the A, B, C, D and F counts
+int batchGrades(BatchSession *session) {
+    StudentTable *table = session->table;
+    int j;
+
+    if (!ensureAggregates(table)) {
+        return batchError(session, "not enough memory");
+    }
+    for (j = 0; j < table->courseCount; j++) {
+        const long *bands = table->aggregates[j].bands;
+        fprintf(session->out, "%d\t%ld\t%ld\t%ld\t%ld\t%ld\n", j + 1, bands[4], bands[3], bands[2], bands[1], bands[0]);
+        session->rows++;
+    }
+    return BATCH_OK;
+}
+
+// Function 112: export PATH: write the records as CSV in the current listing order
+int batchExport(BatchSession *session, const char *path) {
+    long written = exportStudentsCsv(session->table, path);
+
+    if (written < 0) {
+        return batchError(session, "cannot write '%s'", path);
+    }
+    fprintf(session->out, "%ld\n", written);
+    session->rows++;
+    return BATCH_OK;
+}
+
+// Function 113: Write the table as CSV that --import reads back unchanged; returns rows written
+long exportStudentsCsv(StudentTable *table, const char *path) {
+    const int *order = listingOrder(table);
+    FILE *file;
+    int i, j, row;
+
+    if ((file = fopen(path, "w")) == NULL) {
+        return -1;
+    }
+    fprintf(file, "id,name");
+    for (j = 0; j < table->attributeCount; j++) {
+        fprintf(file, ",%s", table->attributes[j].name);
+    }
+    for (j = 0; j < table->courseCount; j++) {
+        fprintf(file, ",course%d", j + 1);
+    }
+    fputc('\n', file);
+
+    for (i = 0; i < table->count; i++) {
+        row = order ? order[i] : i;
+        fprintf(file, "%ld,%s", table->ids[row], studentName(table, row));
+        for (j = 0; j < table->attributeCount; j++) {
+            fprintf(file, ",%s", attributeValue(table, j, row));
+        }
+        for (j = 0; j < table->courseCount; j++) {
+            writeScoreField(file, scoreAt(table, j, row));
+        }
+        fputc('\n', file);
+    }
+    if (fclose(file) != 0) {
+        return -1;
+    }
+    return table->count;
+}
+
+// Function 114: Parse --columns: a comma list of id, name, total, average and course numbers
+int parseColumnList(const char *list, ListingOptions *options) {
+    const char *word = list, *comma;
+    char name[16];
+    size_t length;
+    int course;
+
+    memset(options->show, 0, sizeof(options->show));
+    options->selected = 1;
+    while (*word != '\0') {
+        comma = strchr(word, ',');
+        length = comma ? (size_t)(comma - word) : strlen(word);
+        if (length == 0 || length >= sizeof(name)) {
+            return 0;
+        }
+        memcpy(name, word, length);
+        name[length] = '\0';
+
+        if (strcmp(name, "id") == 0) {
+            options->show[COLUMN_ID] = 1;
+        } else if (strcmp(name, "name") == 0) {
+            options->show[COLUMN_NAME] = 1;
+        } else if (strcmp(name, "total") == 0) {
+            options->show[COLUMN_TOTAL] = 1;
+        } else if (strcmp(name, "average") == 0) {
+            options->show[COLUMN_AVERAGE] = 1;
+        } else if ((course = atoi(name)) >= 1 && course <= MAX_COURSES) {
+            options->show[course - 1] = 1;
+        } else {
+            return 0;
+        }
+        word += length + (comma != NULL);
+    }
+    return 1;
+}
+
+// Function 115: Whether a listing includes a column (a course index or COLUMN_*)
+int showListingColumn(const ListingOptions *options, int column) {
+    return !options->selected || options->show[column];
+}
+
+// Function 116: Format one listing row without printf: "%-12ld  %-20s", "  %8.1f" per course,
+// then "  %9.1f  %8.2f"
+char *renderStudentRow(const StudentTable *table, const ListingOptions *options, int row, char *out) {
+    char id[24];
+    int j, length = 0;
+    unsigned long value;
+
+    if (showListingColumn(options, COLUMN_ID)) {
+        // IDs are never negative
+        value = (unsigned long)table->ids[row];
+        do {
+            id[sizeof(id) - 1 - length++] = (char)('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        out = formatLeft(out, id + sizeof(id) - length, length, 12);
+        *out++ = ' ';
+        *out++ = ' ';
+    }
+    if (showListingColumn(options, COLUMN_NAME)) {
+        out = formatLeft(out, studentName(table, row), table->names[row].length, 20);
+    }
+    for (j = 0; j < table->courseCount; j++) {
+        if (showListingColumn(options, j)) {
+            out = formatFixed(out, scoreAt(table, j, row), 1, 10);
+        }
+    }
+    if (showListingColumn(options, COLUMN_TOTAL)) {
+        out = formatFixed(out, table->totals[row], 1, 11);
+    }
+    if (showListingColumn(options, COLUMN_AVERAGE)) {
+        out = formatFixed(out, table->averages[row], 2, 10);
+    }
+    *out++ = '\n';
+    return out;
+}
+
+// Function 117: Right-align a float with 1 or 2 decimals, rounded exactly like printf("%*.*f")
+char *formatFixed(char *out, float value, int decimals, int width) {
+    char digits[32];
+    int length = 0, negative = value < 0 || (value == 0 && signbit(value));
+    double scaled = fabs((double)value) * (decimals == 1 ? 10 : 100);
+    int64_t units;
+
+    if (!(scaled < 1e15)) {
+        // Out of range for the fast path (or not a number)
+        return out + snprintf(out, RENDER_ROW_MAX, "%*.*f", width, decimals, value);
+    }
+
+    // A float times 10 or 100 is exact in a double, so round-half-even here matches printf
+    units = roundToInt64(scaled);
+    do {
+        digits[sizeof(digits) - 1 - length++] = (char)('0' + units % 10);
+        units /= 10;
+        if (length == decimals) {
+            digits[sizeof(digits) - 1 - length++] = '.';
+            if (units == 0) digits[sizeof(digits) - 1 - length++] = '0';
+        }
+    } while (units != 0 || length <= decimals);
+    if (negative) {
+        digits[sizeof(digits) - 1 - length++] = '-';
+    }
+
+    while (width-- > length) {
+        *out++ = ' ';
+    }
+    memcpy(out, digits + sizeof(digits) - length, length);
+    return out + length;
+}
+
+// Function 118: Copy text and pad it with spaces to width, like printf("%-*s")
+char *formatLeft(char *out, const char *text, size_t length, int width) {
+    int shown = displayWidth(text, length);
+
+    memcpy(out, text, length);
+    out += length;
+    while (shown++ < width) {
+        *out++ = ' ';
+    }
+    return out;
+}
+
+// Function 119: Read one student's ID, name and scores from the keyboard
+void promptStudentRecord(StudentTable *table, Student *student) {
+    int j, courseCount = table->courseCount;
+
+    // Input student ID with validation
+    while (1) {
+        printf("Student ID (4 digits, 1000-9999): ");
+        if (scanf("%ld", &student->id) != 1) {
+            printf("ERROR: Invalid input. Please enter numbers only.\n");
+            clearInputBuffer();
+            continue;
+        }
+        clearInputBuffer();
+
+        // Validate ID range
+        if (student->id < MIN_STUDENT_ID || student->id > maxStudentId) {
+            if (maxStudentId == MAX_STUDENT_ID) {
+                printf("ERROR: ID must be 4 digits (1000-9999).\n");
+            } else {
+                printf("ERROR: ID must be between %d and %ld.\n", MIN_STUDENT_ID, maxStudentId);
+            }
+            continue;
+        }
+
+        // Check for duplicate IDs
+        if (findStudentById(table, student->id) >= 0) {
+            printf("ERROR: This ID already exists. Please enter a unique ID.\n");
+            continue;
+        }
+        break;
+    }
+
+    promptStudentName(student->name);
+    promptAttributeValues(table, student);
+
+    // Input scores for each course
+    printf("Enter scores for %d courses:\n", courseCount);
+    student->total = 0;
+
+    for (j = 0; j < courseCount; j++) {
+        promptScore(table, j, &student->scores[j]);
+        student->total += student->scores[j];
+    }
+
+    // Calculate average
+    student->average = (courseCount > 0) ? student->total / courseCount : 0;
+}
+
+// Function 120: Read a valid student name from the keyboard
+void promptStudentName(char *name) {
+    while (1) {
+        printf("Student Name (letters and spaces only): ");
+        fgets(name, MAX_NAME_LEN, stdin);
+
+        // Remove newline character
+        name[strcspn(name, "\n")] = '\0';
+
+        // Validate name
+        if (strlen(name) == 0) {
+            printf("ERROR: Name cannot be empty.\n");
+            continue;
+        }
+
+        if (strlen(name) >= MAX_NAME_LEN) {
+            printf("ERROR: Name is too long. Maximum %d bytes.\n", MAX_NAME_LEN - 1);
+            clearInputBuffer();
+            continue;
+        }
+
+        if (!isValidStudentName(name)) {
+            printf("ERROR: Invalid name. Use letters and spaces only.\n");
+            continue;
+        }
+        break;
+    }
+}
+
+// Function 121: Read a score between 0 and 100 for one course from the keyboard
+void promptScore(const StudentTable *table, int course, float *score) {
+    while (1) {
+        printf("  Course %d (0-100): ", course + 1);
+        if (scanf("%f", score) != 1) {
+            printf("    ERROR: Invalid input. Enter a number.\n");
+            clearInputBuffer();
+            continue;
+        }
+        clearInputBuffer();
+
+        if (*score < 0 || *score > 100) {
+            printf("    ERROR: Score must be between 0 and 100.\n");
+            continue;
+        }
+        if (table->tenths && scoreBin(*score) < 0) {
+            printf("    ERROR: Scores are kept in tenths; use at most one decimal.\n");
+            continue;
+        }
+        break;
+    }
+}
+
+// Function 122: Add one record whose ID is not in use yet; cached views queue the row, not re-sort
+int insertStudent(StudentTable *table, const Student *student) {
+    int current = currentViews(table);
+    uint64_t currentRanges = currentRangeIndexes(table);
+
+    if (!appendStudent(table, student)) {
+        return 0;
+    }
+    refreshViews(table, current, VIEW_MASK_ALL, table->count - 1);
+    refreshRangeIndexes(table, currentRanges, ~0ULL, table->count - 1);
+    hasDataBeenEntered = 1;
+    hasUnsavedChanges = 1;
+    journalInsert(table, table->count - 1);
+    maybeCompactJournal(table);
+    return 1;
+}
+
+// Function 123: Change one score and the row's total and average, O(courses) plus queueing the
+// row for the cached views and range indexes it moves in
+void updateStudentScore(StudentTable *table, int row, int course, float score) {
+    int current = currentViews(table);
+    uint64_t currentRanges = currentRangeIndexes(table), affected;
+    float total = 0;
+    int j;
+
+    // Take the old values out of the aggregates first
+    removeRowFromAggregates(table, row);
+    affected = (1ULL << course) | (1ULL << rangeSlot(table, RANK_BY_TOTAL)) | (1ULL << rangeSlot(table, RANGE_BY_AVERAGE));
+
+    // Summed in course order so the total matches data entry and import exactly
+    setScore(table, course, row, score);
+    if (table->tenths) {
+        total = tenthsTotal(table, row);
+    } else {
+        for (j = 0; j < table->courseCount; j++) {
+            total += scoreAt(table, j, row);
+        }
+    }
+    table->totals[row] = total;
+    table->averages[row] = total / table->courseCount;
+
+    table->version++;
+    refreshViews(table, current, VIEW_MASK_TOTALS, row);
+    refreshRangeIndexes(table, currentRanges, affected, row);
+    addRowToAggregates(table, row);
+    hasUnsavedChanges = 1;
+    journalUpdate(table->ids[row], course, score);
+    maybeCompactJournal(table);
+}
+
+// Function 124: Give a student a new (already validated) name
+void renameStudent(StudentTable *table, int row, const char *name) {
+    int current = currentViews(table);
+    NameRef ref;
+
+    if (!storeName(table, name, &ref)) {
+        printf("ERROR: Out of memory while renaming student %ld.\n", table->ids[row]);
+        return;
+    }
+    releaseName(table, table->names[row]);
+    table->names[row] = ref;
+    table->version++;
+    refreshViews(table, current, 1 << VIEW_NAME, row);
+    hasUnsavedChanges = 1;
+    journalRename(table->ids[row], studentName(table, row));
+    compactNameArena(table, 0);
+    maybeCompactJournal(table);
+}
+
+// Function 125: Delete a row by moving the last row into its place, so columns stay contiguous
+void deleteStudent(StudentTable *table, int row) {
+    int current = currentViews(table), last = table->count - 1, slot, j;
+    uint64_t currentRanges = currentRangeIndexes(table);
+    long id = table->ids[row];
+
+    removeRowFromAggregates(table, row);
+    removeIdIndex(table, table->ids[row]);
+    releaseName(table, table->names[row]);
+
+    if (last != row) {
+        // Look the moved row up before its number changes
+        slot = idIndexSlot(table, last);
+        table->ids[row] = table->ids[last];
+        table->names[row] = table->names[last];
+        for (j = 0; j < table->courseCount; j++) {
+            setScore(table, j, row, scoreAt(table, j, last));
+        }
+        table->totals[row] = table->totals[last];
+        table->averages[row] = table->averages[last];
+        for (j = 0; j < table->attributeCount; j++) {
+            table->attributes[j].codes[row] = table->attributes[j].codes[last];
+        }
+        if (slot >= 0) {
+            table->idIndex.slots[slot] = row;
+        }
+    }
+
+    table->count--;
+    table->version++;
+    // Both row numbers are queued: the entry of the last row goes, and the moved row is re-placed by
+    // its new row number, which decides ties
+    refreshViews(table, current, VIEW_MASK_ALL, row);
+    refreshRangeIndexes(table, currentRanges, ~0ULL, row);
+    if (last != row) {
+        refreshViews(table, current, VIEW_MASK_ALL, last);
+        refreshRangeIndexes(table, currentRanges, ~0ULL, last);
+    }
+    hasDataBeenEntered = table->count > 0;
+    hasUnsavedChanges = 1;
+    journalDelete(id);
+    compactNameArena(table, 0);
+    maybeCompactJournal(table);
+}
+
+// Function 126: Bit mask of the views that are up to date with the table
+int currentViews(const StudentTable *table) {
+    int kind, mask = 0;
+
+    for (kind = 0; kind < VIEW_COUNT; kind++) {
+        if (table->views[kind].rows != NULL && table->views[kind].version == table->version) {
+            mask |= 1 << kind;
+        }
+    }
+    return mask;
+}
+
+// Function 127: After a one-row change, queue the row for the affected views to re-place on their
+// next read, and mark every view that was current before the change as current again
+void refreshViews(StudentTable *table, int current, int affected, int row) {
+    int kind;
+
+    for (kind = 0; kind < VIEW_COUNT; kind++) {
+        if (!(current & (1 << kind))) {
+            continue;
+        }
+        if ((affected & (1 << kind)) && !queuePendingRow(&table->views[kind].pending, row, table->count)) {
+            continue;       // Too many changes or out of memory: the view is rebuilt when next used
+        }
+        table->views[kind].version = table->version;
+    }
+}
+
+// Function 128: Whether row a sorts before row b in a view; ties go to the lower row like the stable sorts
+int viewRowBefore(const StudentTable *table, ViewKind kind, int a, int b) {
+    uint32_t keyA, keyB;
+    int order = 0;
+
+    switch (kind) {
+        case VIEW_TOTAL_DESC:
+        case VIEW_TOTAL_ASC:
+            keyA = floatSortKey(table->totals[a]);
+            keyB = floatSortKey(table->totals[b]);
+            order = (keyA > keyB) - (keyA < keyB);
+            if (kind == VIEW_TOTAL_DESC) order = -order;
+            break;
+        case VIEW_ID:
+            order = (table->ids[a] > table->ids[b]) - (table->ids[a] < table->ids[b]);
+            break;
+        case VIEW_NAME:
+            order = strcmp(foldedName(table, a), foldedName(table, b));
+            break;
+        default:
+            break;
+    }
+    return order != 0 ? order < 0 : a < b;
+}
+
+// Function 129: First position among n view entries that does not sort before row (binary search)
+int viewPosition(const StudentTable *table, ViewKind kind, int row, int n) {
+    const int *rows = table->views[kind].rows;
+    int lo = 0, hi = n, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (viewRowBefore(table, kind, rows[mid], row)) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+// Function 130: Merge a view's pending rows: one pass drops their old entries, the changed rows
+// alone are sorted, and each is placed from the back by binary search, so every entry moves at most
+// once per read however many changes came before it. That pass is O(n) even for one change (about
+// 10 ms at 3 million rows), so only the first read after a run of writes pays more than its result;
+// the server pays it on the writer thread in prepareForReaders, never on a reader
+int mergePendingViewRows(StudentTable *table, ViewKind kind) {
+    SortedView *view = &table->views[kind];
+    uint64_t *changed;
+    int *rows, *fresh, n = table->count, kept = 0, count, end, position, row, i;
+
+    if ((count = settlePendingRows(&view->pending, n, &changed)) < 0) {
+        return 0;
+    }
+    for (i = 0; i < view->entries; i++) {
+        row = view->rows[i];
+        if (row < n && !(changed[row / 64] & (1ULL << (row % 64)))) {
+            view->rows[kept++] = row;
+        }
+    }
+    free(changed);
+    view->entries = kept;
+
+    fresh = view->pending.rows;
+    if ((rows = realloc(view->rows, (n > 0 ? n : 1) * sizeof(int))) == NULL ||
+        !sortViewRows(table, kind, fresh, count)) {
+        if (rows != NULL) view->rows = rows;
+        return 0;
+    }
+    view->rows = rows;
+    // The i-th changed row has i changed rows and every kept entry before its position ahead of it
+    for (end = kept, i = count - 1; i >= 0; i--) {
+        position = viewPosition(table, kind, fresh[i], end);
+        memmove(rows + position + i + 1, rows + position, (end - position) * sizeof(int));
+        rows[position + i] = fresh[i];
+        end = position;
+    }
+    view->entries = n;
+    return 1;
+}
+
+// Function 131: Note a changed row for a cache to merge on its next read; 0 once more rows wait
+// than the roster holds, when a rebuild is as cheap, or when memory runs out
+int queuePendingRow(PendingRows *pending, int row, int limit) {
+    int *rows, capacity;
+
+    if (pending->count > limit) {
+        return 0;
+    }
+    if (pending->count == pending->capacity) {
+        capacity = pending->capacity > 0 ? pending->capacity * 2 : 64;
+        if ((rows = realloc(pending->rows, capacity * sizeof(int))) == NULL) {
+            return 0;
+        }
+        pending->rows = rows;
+        pending->capacity = capacity;
+    }
+    pending->rows[pending->count++] = row;
+    return 1;
+}
+
+// Function 132: Add one student without re-entering the roster
+void addOneStudent(StudentTable *table) {
+    Student student;
+
+    printf("\n============================================\n");
+    printf("              ADD ONE STUDENT\n");
+    printf("============================================\n");
+    clearInputBuffer();
+    promptStudentRecord(table, &student);
+    if (!insertStudent(table, &student)) {
+        printf("\nERROR: Not enough memory.\n");
+        return;
+    }
+    printf("\nSUCCESS: Student %ld has been added.\n", student.id);
+}
+
+// Function 133: Ask for a student ID and return its row, or -1 after an error message
+int promptExistingStudent(StudentTable *table) {
+    long searchId;
+    int row;
+
+    printf("\nEnter Student ID: ");
+    if (scanf("%ld", &searchId) != 1) {
+        printf("ERROR: Invalid input.\n");
+        clearInputBuffer();
+        return -1;
+    }
+    clearInputBuffer();
+
+    if ((row = findStudentById(table, searchId)) < 0) {
+        printf("\nERROR: Student with ID %ld not found.\n", searchId);
+    }
+    return row;
+}
+
+// Function 134: Correct one score of one student
+void editStudentScore(StudentTable *table) {
+    int row, course;
+    float score;
+
+    if ((row = promptExistingStudent(table)) < 0) {
+        return;
+    }
+    printf("Course to change (1-%d): ", table->courseCount);
+    if (scanf("%d", &course) != 1 || course < 1 || course > table->courseCount) {
+        printf("ERROR: Invalid course.\n");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+    promptScore(table, course - 1, &score);
+
+    updateStudentScore(table, row, course - 1, score);
+    printStudentRecord(table, row);
+}
+
+// Function 135: Change one student's name
+void editStudentName(StudentTable *table) {
+    char name[MAX_NAME_LEN];
+    int row;
+
+    if ((row = promptExistingStudent(table)) < 0) {
+        return;
+    }
+    promptStudentName(name);
+    renameStudent(table, row, name);
+    printStudentRecord(table, row);
+}
+
+// Function 136: Delete one student after confirmation
+void removeStudent(StudentTable *table) {
+    char confirm;
+    long id;
+    int row;
+
+    if ((row = promptExistingStudent(table)) < 0) {
+        return;
+    }
+    id = table->ids[row];
+    printf("Delete student %ld (%s)? (y/n): ", id, studentName(table, row));
+    if (scanf(" %c", &confirm) != 1 || (confirm != 'y' && confirm != 'Y')) {
+        printf("Delete cancelled.\n");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+    deleteStudent(table, row);
+    printf("\nSUCCESS: Student %ld has been deleted.\n", id);
+}
+
+// Function 137: insert ID,NAME,SCORE1,...: add a record given in the --import CSV format
+int batchInsert(BatchSession *session, char *record) {
+    StudentTable *table = session->table;
+    Student student;
+    const char *reason;
+
+    if (table->courseCount <= 0) {
+        return batchError(session, "no data loaded");
+    }
+    if (!parseStudentCsvLine(record, record + strlen(record), table, &student, &reason)) {
+        return batchError(session, "%s", reason);
+    }
+    if (findStudentById(table, student.id) >= 0) {
+        return batchError(session, "duplicate ID");
+    }
+    if (!insertStudent(table, &student)) {
+        return batchError(session, "not enough memory");
+    }
+    writeBatchRecord(session, table->count - 1);
+    return BATCH_OK;
+}
+
+// Function 138: update ID COURSE SCORE: change one score
+int batchUpdate(BatchSession *session, char **args) {
+    StudentTable *table = session->table;
+    int row = findStudentById(table, atol(args[0])), course = atoi(args[1]);
+    float score;
+
+    if (row < 0) {
+        return batchError(session, "student %s not found", args[0]);
+    }
+    if (course < 1 || course > table->courseCount) {
+        return batchError(session, "course must be between 1 and %d", table->courseCount);
+    }
+    if (!parseScoreField(args[2], args[2] + strlen(args[2]), &score) || score < 0 || score > 100) {
+        return batchError(session, "score must be between 0 and 100");
+    }
+    if (table->tenths && scoreBin(score) < 0) {
+        return batchError(session, "score must have at most one decimal");
+    }
+    updateStudentScore(table, row, course - 1, score);
+    writeBatchRecord(session, row);
+    return BATCH_OK;
+}
+
+// Function 139: rename ID NAME: change one name
+int batchRename(BatchSession *session, const char *idText, const char *name) {
+    int row = findStudentById(session->table, atol(idText));
+
+    if (row < 0) {
+        return batchError(session, "student %s not found", idText);
+    }
+    if (strlen(name) >= MAX_NAME_LEN || !isValidStudentName(name)) {
+        return batchError(session, "invalid name");
+    }
+    renameStudent(session->table, row, name);
+    writeBatchRecord(session, row);
+    return BATCH_OK;
+}
+
+// Function 140: delete ID: remove one record
+int batchDelete(BatchSession *session, const char *idText) {
+    int row = findStudentById(session->table, atol(idText));
+
+    if (row < 0) {
+        return batchError(session, "student %s not found", idText);
+    }
+    deleteStudent(session->table, row);
+    return BATCH_OK;
+}
+
+// Function 141: Start journaling changes to <snapshot>.journal, replaying what an earlier run left;
+// returns the number of changes replayed, or -1 if the journal cannot be used
+long openJournal(StudentTable *table, const char *snapshotPath, int replay) {
+    off_t validEnd = 0;
+    long replayed = 0, fromOld = 0;
+    int fd = -1;
+
+    journal.snapshotPath = snapshotPath;
+    snprintf(journal.path, sizeof(journal.path), "%s.journal", snapshotPath);
+    snprintf(journal.oldPath, sizeof(journal.oldPath), "%s.journal.old", snapshotPath);
+
+    // A compaction interrupted before its snapshot landed leaves the previous journal behind
+    if (replay) {
+        if ((fromOld = replayJournal(table, journal.oldPath, table->generation, NULL)) < 0) {
+            return -1;
+        }
+        if ((replayed = replayJournal(table, journal.path, table->generation, &validEnd)) < 0) {
+            return -1;
+        }
+        // An older-format journal is kept as the old one until a snapshot holds its changes
+        if (replayed > 0 && validEnd == 0 && fromOld == 0 && rename(journal.path, journal.oldPath) == 0) {
+            fromOld = replayed;
+            replayed = 0;
+        }
+    }
+
+    // Keep appending to a journal that follows this snapshot; otherwise start a fresh one
+    if (replay && validEnd > 0 && (fd = open(journal.path, O_WRONLY | O_APPEND)) >= 0) {
+        if (ftruncate(fd, validEnd) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd < 0) {
+        validEnd = sizeof(JournalHeader);
+        if ((fd = createJournal(journal.path, table->generation)) < 0) {
+            return -1;
+        }
+    }
+
+    journal.fd = fd;
+    journal.generation = table->generation;
+    journal.fileSize = validEnd;
+    journal.appended = journal.synced = 0;
+    pthread_mutex_init(&journal.lock, NULL);
+    pthread_cond_init(&journal.wake, NULL);
+    pthread_cond_init(&journal.durable, NULL);
+    if (pthread_create(&journal.flusher, NULL, journalFlusherMain, NULL) != 0) {
+        close(journal.fd);
+        journal.fd = -1;
+        return -1;
+    }
+
+    // Changes from the old journal must reach a snapshot before the next compaction reuses its name
+    if (fromOld > 0) {
+        checkpointTable(table, snapshotPath);
+    } else {
+        remove(journal.oldPath);
+    }
+    return fromOld + replayed;
+}
+
+// Function 142: Flush and stop the journal (after any background compaction finishes)
+void closeJournal(void) {
+    if (journal.fd < 0) {
+        return;
+    }
+    finishCompaction();
+    journalSync();
+
+    pthread_mutex_lock(&journal.lock);
+    journal.stopping = 1;
+    pthread_cond_signal(&journal.wake);
+    pthread_mutex_unlock(&journal.lock);
+    pthread_join(journal.flusher, NULL);
+
+    close(journal.fd);
+    journal.fd = -1;
+    free(journal.pending);
+    free(journal.writing);
+    journal.pending = journal.writing = NULL;
+    journal.pendingCapacity = journal.writingCapacity = journal.pendingUsed = 0;
+}
+
+// Function 143: Create an empty journal for a snapshot generation (atomically) and open it for appending
+int createJournal(const char *path, uint64_t generation) {
+    JournalHeader header;
+    char tempPath[1040];
+    int fd;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.headerSize = sizeof(header);
+    header.generation = generation;
+
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    if ((fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644)) < 0) {
+        printf("ERROR: Cannot create journal '%s'.\n", tempPath);
+        return -1;
+    }
+    if (!writeAll(fd, &header, sizeof(header)) || fsync(fd) != 0 || rename(tempPath, path) != 0) {
+        printf("ERROR: Cannot create journal '%s'.\n", path);
+        close(fd);
+        remove(tempPath);
+        return -1;
+    }
+    syncParentDirectory(path);
+    return fd;
+}
+
+// Function 144: Apply every intact record of a journal that follows the table's snapshot;
+// returns how many were applied, -1 on an unreadable journal
+long replayJournal(StudentTable *table, const char *path, uint64_t minGeneration, off_t *validEnd) {
+    JournalHeader header;
+    unsigned char payload[JOURNAL_MAX_RECORD];
+    uint32_t frame[2];
+    long applied = 0;
+    int status;
+    FILE *file;
+
+    if ((file = fopen(path, "rb")) == NULL) {
+        return 0;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version < 1 || header.version > JOURNAL_VERSION || header.headerSize != sizeof(header)) {
+        printf("ERROR: '%s' is not a valid journal.\n", path);
+        fclose(file);
+        return -1;
+    }
+    if (header.generation < minGeneration) {
+        // Written before the snapshot was taken, so already part of it
+        fclose(file);
+        return 0;
+    }
+    // Older journals are replayed but never appended to; version 1 holds fixed 20-byte names,
+    // attributes arrive with version 3, and the score layout with version 4
+    if (header.version != JOURNAL_VERSION) {
+        validEnd = NULL;
+    }
+    if (validEnd != NULL) {
+        *validEnd = sizeof(header);
+    }
+
+    // A torn or damaged record marks the end of what reached the disk
+    while (fread(frame, sizeof(frame), 1, file) == 1 && frame[0] > 0 && frame[0] <= sizeof(payload) &&
+           fread(payload, frame[0], 1, file) == 1 && journalChecksum(payload, frame[0]) == frame[1]) {
+        if ((status = applyJournalRecord(table, payload, frame[0], header.version)) < 0) {
+            // An intact record that cannot be applied as written must not be dropped or altered
+            printf("ERROR: Journal '%s' holds a score that does not fit the table's layout.\n", path);
+            fclose(file);
+            return -1;
+        }
+        if (status == 0) {
+            break;
+        }
+        applied++;
+        if (validEnd != NULL) {
+            *validEnd += sizeof(frame) + frame[0];
+        }
+    }
+    fclose(file);
+    return applied;
+}
+
+// Function 145: Redo one journaled change; 0 if the record is malformed, -1 if it holds a score
+// the table's layout cannot keep exactly
+int applyJournalRecord(StudentTable *table, const unsigned char *payload, uint32_t size, uint32_t version) {
+    Student student;
+    int64_t id;
+    float score;
+    int row, j, same, legacyNames = version == 1;
+    size_t length = 0, nameBytes = 0, at;
+
+    if (payload[0] == JOURNAL_RESET) {
+        char names[MAX_ATTRIBUTES][ATTRIBUTE_NAME_LEN];
+        // Before version 4 the layout was not recorded, and every table kept floats
+        size_t shape = version >= 4 ? 3 : 2;
+        int tenths = version >= 4 && size > 2 ? payload[2] : 0;
+        int attributeCount = size > shape ? payload[shape] : 0;
+
+        if (size < shape || payload[1] < 1 || payload[1] > MAX_COURSES || tenths > 1 ||
+            attributeCount > MAX_ATTRIBUTES) {
+            return 0;
+        }
+        // Attribute names follow as a count, then a length byte and the bytes of each
+        for (j = 0, at = shape + 1; j < attributeCount; j++) {
+            if (at >= size || payload[at] == 0 || payload[at] >= ATTRIBUTE_NAME_LEN || at + 1 + payload[at] > size) {
+                return 0;
+            }
+            memcpy(names[j], payload + at + 1, payload[at]);
+            names[j][payload[at]] = '\0';
+            at += 1 + payload[at];
+        }
+        if (size != (attributeCount > 0 ? at : shape)) return 0;
+
+        same = payload[1] == table->courseCount && tenths == table->tenths && attributeCount == table->attributeCount;
+        for (j = 0; same && j < attributeCount; j++) {
+            same = strcmp(names[j], table->attributes[j].name) == 0;
+        }
+        if (!same) {
+            freeStudentTable(table);
+            if (!initStudentTable(table, payload[1])) return 0;
+            table->tenths = tenths;
+            memset(table->attributes, 0, sizeof(table->attributes));
+            table->attributeCount = attributeCount;
+            for (j = 0; j < attributeCount; j++) {
+                memcpy(table->attributes[j].name, names[j], ATTRIBUTE_NAME_LEN);
+            }
+        }
+        clearStudentRows(table);
+        return 1;
+    }
+    if (size < 9 || table->courseCount <= 0) {
+        return 0;
+    }
+    memcpy(&id, payload + 1, sizeof(id));
+    row = findStudentById(table, id);
+
+    // Names follow the ID: a length byte and the bytes, or a fixed 20-byte field in version 1
+    if (payload[0] == JOURNAL_INSERT || payload[0] == JOURNAL_RENAME) {
+        if (legacyNames) {
+            if (size < 9 + LEGACY_NAME_LEN) return 0;
+            length = strnlen((const char *)payload + 9, LEGACY_NAME_LEN - 1);
+            nameBytes = LEGACY_NAME_LEN;
+            memcpy(student.name, payload + 9, length);
+        } else {
+            if (size < 10 || payload[9] >= MAX_NAME_LEN || size < 10 + (size_t)payload[9]) return 0;
+            length = payload[9];
+            nameBytes = 1 + length;
+            memcpy(student.name, payload + 10, length);
+        }
+        student.name[length] = '\0';
+    }
+
+    switch (payload[0]) {
+        case JOURNAL_INSERT:
+            // Attribute values follow the scores, each a length byte and the bytes
+            at = 9 + nameBytes + table->courseCount * sizeof(float);
+            for (j = 0; j < table->attributeCount; j++) {
+                if (at >= size || payload[at] >= ATTRIBUTE_VALUE_LEN || at + 1 + payload[at] > size) return 0;
+                memcpy(student.attributes[j], payload + at + 1, payload[at]);
+                student.attributes[j][payload[at]] = '\0';
+                at += 1 + payload[at];
+            }
+            if (size != at) return 0;
+            if (row >= 0) return 1;
+            student.id = id;
+            memcpy(student.scores, payload + 9 + nameBytes, table->courseCount * sizeof(float));
+            student.total = 0;
+            for (j = 0; j < table->courseCount; j++) {
+                if (table->tenths && scoreBin(student.scores[j]) < 0) return -1;
+                student.total += student.scores[j];
+            }
+            student.average = student.total / table->courseCount;
+            return insertStudent(table, &student);
+        case JOURNAL_UPDATE:
+            if (size != 9 + 1 + sizeof(float) || payload[9] >= table->courseCount) return 0;
+            memcpy(&score, payload + 10, sizeof(score));
+            if (table->tenths && scoreBin(score) < 0) return -1;
+            if (row >= 0) updateStudentScore(table, row, payload[9], score);
+            return 1;
+        case JOURNAL_RENAME:
+            if (size != 9 + nameBytes) return 0;
+            if (row >= 0) renameStudent(table, row, student.name);
+            return 1;
+        case JOURNAL_DELETE:
+            if (size != 9) return 0;
+            if (row >= 0) deleteStudent(table, row);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Function 146: Queue one record for the group-commit thread; it is on disk within a few
+// milliseconds, or once journalSync returns
+int journalAppend(const unsigned char *payload, uint32_t size) {
+    uint32_t frame[2];
+    size_t needed;
+    char *grown;
+    int wasEmpty;
+
+    if (journal.fd < 0) {
+        return 1;
+    }
+    frame[0] = size;
+    frame[1] = journalChecksum(payload, size);
+
+    pthread_mutex_lock(&journal.lock);
+    if (journal.failed) {
+        pthread_mutex_unlock(&journal.lock);
+        return 0;
+    }
+    needed = journal.pendingUsed + sizeof(frame) + size;
+    if (needed > journal.pendingCapacity) {
+        size_t capacity = journal.pendingCapacity > 0 ? journal.pendingCapacity * 2 : JOURNAL_FLUSH_BYTES;
+        while (capacity < needed) capacity *= 2;
+        if ((grown = realloc(journal.pending, capacity)) == NULL) {
+            pthread_mutex_unlock(&journal.lock);
+            return 0;
+        }
+        journal.pending = grown;
+        journal.pendingCapacity = capacity;
+    }
+
+    wasEmpty = journal.pendingUsed == 0;
+    memcpy(journal.pending + journal.pendingUsed, frame, sizeof(frame));
+    memcpy(journal.pending + journal.pendingUsed + sizeof(frame), payload, size);
+    journal.pendingUsed = needed;
+    journal.appended += sizeof(frame) + size;
+    journal.fileSize += sizeof(frame) + size;
+    if (wasEmpty || journal.pendingUsed >= JOURNAL_FLUSH_BYTES) {
+        pthread_cond_signal(&journal.wake);
+    }
+    pthread_mutex_unlock(&journal.lock);
+    return 1;
+}
+
+// Function 147: Wait until every queued record is on disk; 0 if the journal has failed
+int journalSync(void) {
+    int ok;
+
+    if (journal.fd < 0) {
+        return 1;
+    }
+    pthread_mutex_lock(&journal.lock);
+    journal.syncWaiters++;
+    pthread_cond_signal(&journal.wake);
+    while (journal.synced < journal.appended && !journal.failed) {
+        pthread_cond_wait(&journal.durable, &journal.lock);
+    }
+    journal.syncWaiters--;
+    ok = !journal.failed;
+    pthread_mutex_unlock(&journal.lock);
+    return ok;
+}
+
+// Function 148: Group-commit thread: gather records for a moment, then write and fsync them together
+void *journalFlusherMain(void *argument) {
+    struct timespec deadline;
+    uint64_t target;
+    size_t size, capacity;
+    char *swap;
+    int fd, ok;
+
+    (void)argument;
+    pthread_mutex_lock(&journal.lock);
+    while (1) {
+        while (!journal.stopping && journal.pendingUsed == 0) {
+            pthread_cond_wait(&journal.wake, &journal.lock);
+        }
+        if (journal.pendingUsed == 0) {
+            break;
+        }
+
+        // Unless someone is already waiting, let more records join this fsync
+        if (!journal.stopping && journal.syncWaiters == 0 && journal.pendingUsed < JOURNAL_FLUSH_BYTES) {
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += JOURNAL_COMMIT_DELAY_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&journal.wake, &journal.lock, &deadline);
+        }
+
+        swap = journal.writing; journal.writing = journal.pending; journal.pending = swap;
+        capacity = journal.writingCapacity;
+        journal.writingCapacity = journal.pendingCapacity;
+        journal.pendingCapacity = capacity;
+        size = journal.pendingUsed;
+        journal.pendingUsed = 0;
+        target = journal.appended;
+        fd = journal.fd;
+        pthread_mutex_unlock(&journal.lock);
+
+        ok = writeAll(fd, journal.writing, size) && fdatasync(fd) == 0;
+
+        pthread_mutex_lock(&journal.lock);
+        if (!ok && !journal.failed) {
+            journal.failed = 1;
+            fprintf(stderr, "ERROR: Writing the journal failed; later changes are not protected.\n");
+        }
+        journal.synced = target;
+        pthread_cond_broadcast(&journal.durable);
+    }
+    pthread_mutex_unlock(&journal.lock);
+    return NULL;
+}
+
+// Function 149: Journal a new row (its total and average are recomputed on replay); the name
+// and attribute values are stored as a length byte and their bytes
+void journalInsert(const StudentTable *table, int row) {
+    unsigned char payload[JOURNAL_MAX_RECORD];
+    size_t length = table->names[row].length, at;
+    int j;
+
+    if (journal.shapePending) {
+        journalReset(table);
+    }
+    payload[0] = JOURNAL_INSERT;
+    memcpy(payload + 1, &table->ids[row], sizeof(int64_t));
+    payload[9] = (unsigned char)length;
+    memcpy(payload + 10, studentName(table, row), length);
+    for (j = 0; j < table->courseCount; j++) {
+        float score = scoreAt(table, j, row);
+        memcpy(payload + 10 + length + j * sizeof(float), &score, sizeof(float));
+    }
+    at = 10 + length + table->courseCount * sizeof(float);
+    for (j = 0; j < table->attributeCount; j++) {
+        const char *value = attributeValue(table, j, row);
+
+        payload[at] = (unsigned char)strlen(value);
+        memcpy(payload + at + 1, value, payload[at]);
+        at += 1 + payload[at];
+    }
+    journalAppend(payload, at);
+}
+
+// Function 150: Journal a score change
+void journalUpdate(int64_t id, int course, float score) {
+    unsigned char payload[10 + sizeof(float)];
+
+    payload[0] = JOURNAL_UPDATE;
+    memcpy(payload + 1, &id, sizeof(id));
+    payload[9] = (unsigned char)course;
+    memcpy(payload + 10, &score, sizeof(score));
+    journalAppend(payload, sizeof(payload));
+}
+
+// Function 151: Journal a rename
+void journalRename(int64_t id, const char *name) {
+    unsigned char payload[10 + MAX_NAME_LEN];
+    size_t length = strnlen(name, MAX_NAME_LEN - 1);
+
+    payload[0] = JOURNAL_RENAME;
+    memcpy(payload + 1, &id, sizeof(id));
+    payload[9] = (unsigned char)length;
+    memcpy(payload + 10, name, length);
+    journalAppend(payload, 10 + length);
+}
+
+// Function 152: Journal a delete
+void journalDelete(int64_t id) {
+    unsigned char payload[9];
+
+    payload[0] = JOURNAL_DELETE;
+    memcpy(payload + 1, &id, sizeof(id));
+    journalAppend(payload, sizeof(payload));
+}
+
+// Function 153: Journal that every row was dropped (data re-entry starts over), with the
+// table's shape and score layout so replay rebuilds the same columns
+void journalReset(const StudentTable *table) {
+    unsigned char payload[4 + MAX_ATTRIBUTES * ATTRIBUTE_NAME_LEN];
+    size_t size = 3, length;
+    int a;
+
+    journal.shapePending = 0;
+    payload[0] = JOURNAL_RESET;
+    payload[1] = (unsigned char)table->courseCount;
+    payload[2] = (unsigned char)table->tenths;
+    if (table->attributeCount > 0) {
+        payload[size++] = (unsigned char)table->attributeCount;
+        for (a = 0; a < table->attributeCount; a++) {
+            length = strlen(table->attributes[a].name);
+            payload[size++] = (unsigned char)length;
+            memcpy(payload + size, table->attributes[a].name, length);
+            size += length;
+        }
+    }
+    journalAppend(payload, size);
+}
+
+// Function 154: FNV-1a checksum of one journal record
+uint32_t journalChecksum(const unsigned char *data, uint32_t size) {
+    uint32_t hash = 2166136261u;
+    uint32_t i;
+
+    for (i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Function 155: Save a snapshot; when it is the journal's snapshot, the journal starts over empty
+int checkpointTable(StudentTable *table, const char *path) {
+    int fd, old;
+
+    if (journal.fd < 0 || strcmp(path, journal.snapshotPath) != 0) {
+        return saveSnapshot(table, path);
+    }
+    finishCompaction();
+    journalSync();
+
+    table->generation = nextGeneration(table);
+    if (!saveSnapshot(table, path)) {
+        return 0;
+    }
+    syncParentDirectory(path);
+
+    // Everything journaled so far is in the snapshot; its generation makes the old journal obsolete
+    if ((fd = createJournal(journal.path, table->generation)) < 0) {
+        // Records appended to the old journal would be skipped on recovery
+        pthread_mutex_lock(&journal.lock);
+        journal.failed = 1;
+        pthread_mutex_unlock(&journal.lock);
+        return 1;
+    }
+    pthread_mutex_lock(&journal.lock);
+    old = journal.fd;
+    journal.fd = fd;
+    journal.generation = table->generation;
+    journal.fileSize = sizeof(JournalHeader);
+    pthread_mutex_unlock(&journal.lock);
+    close(old);
+    remove(journal.oldPath);
+    journal.compactionFailed = 0;
+    return 1;
+}
+
+// Function 156: Generation for the next snapshot: newer than both the table and the open journal
+uint64_t nextGeneration(const StudentTable *table) {
+    return (table->generation > journal.generation ? table->generation : journal.generation) + 1;
+}
+
+// Function 157: After a change, hand the journal to a background snapshot once it is too long
+void maybeCompactJournal(StudentTable *table) {
+    int state;
+    int fd, old;
+
+    if (journal.fd < 0) {
+        return;
+    }
+    pthread_mutex_lock(&journal.lock);
+    state = journal.compacting;
+    pthread_mutex_unlock(&journal.lock);
+    if (state == 2) {
+        finishCompaction();
+    }
+    if (state == 1 || journal.compactionFailed || journal.fileSize < journal.limit) {
+        return;
+    }
+
+    // Copy the rows now; writing them out happens on the compactor thread
+    journalSync();
+    if (!copyStudentTable(table, &journal.image)) {
+        return;
+    }
+    table->generation = journal.image.generation = nextGeneration(table);
+
+    // Changes from here on go to a new journal that follows the coming snapshot
+    if (rename(journal.path, journal.oldPath) != 0) {
+        freeStudentTable(&journal.image);
+        return;
+    }
+    if ((fd = createJournal(journal.path, table->generation)) < 0) {
+        rename(journal.oldPath, journal.path);
+        freeStudentTable(&journal.image);
+        journal.compactionFailed = 1;
+        return;
+    }
+    pthread_mutex_lock(&journal.lock);
+    old = journal.fd;
+    journal.fd = fd;
+    journal.generation = table->generation;
+    journal.fileSize = sizeof(JournalHeader);
+    journal.compacting = 1;
+    pthread_mutex_unlock(&journal.lock);
+    close(old);
+
+    if (pthread_create(&journal.compactor, NULL, compactorMain, NULL) != 0) {
+        // No thread to spare: write the snapshot now
+        compactorMain(NULL);
+        freeStudentTable(&journal.image);
+        journal.compacting = 0;
+    }
+}
+
+// Function 158: Compactor thread: write the copied rows as the new snapshot, then drop the old journal
+void *compactorMain(void *argument) {
+    int ok = saveSnapshot(&journal.image, journal.snapshotPath);
+
+    (void)argument;
+    if (ok) {
+        syncParentDirectory(journal.snapshotPath);
+        remove(journal.oldPath);
+    }
+    pthread_mutex_lock(&journal.lock);
+    journal.compacting = 2;
+    journal.compactionFailed = !ok;
+    pthread_mutex_unlock(&journal.lock);
+    return NULL;
+}
+
+// Function 159: Wait for a background compaction and release its copy of the table
+void finishCompaction(void) {
+    int state;
+
+    pthread_mutex_lock(&journal.lock);
+    state = journal.compacting;
+    pthread_mutex_unlock(&journal.lock);
+    if (state == 0) {
+        return;
+    }
+    pthread_join(journal.compactor, NULL);
+    freeStudentTable(&journal.image);
+    journal.compacting = 0;
+}
+
+// Function 160: Heap copy of a table's rows (no indexes, views or aggregates)
+int copyStudentTable(const StudentTable *source, StudentTable *copy) {
+    int j, n = source->count;
+
+    if (!initStudentTable(copy, source->courseCount)) {
+        return 0;
+    }
+    copy->tenths = source->tenths;
+    if (!copyAttributeDictionaries(source, copy) || !reserveStudentRows(copy, n)) {
+        freeStudentTable(copy);
+        return 0;
+    }
+    if (n > 0) {
+        memcpy(copy->ids, source->ids, n * sizeof(long));
+        memcpy(copy->names, source->names, n * sizeof(*copy->names));
+        if ((copy->nameArena.bytes = malloc(source->nameArena.used > 0 ? source->nameArena.used : 1)) == NULL) {
+            freeStudentTable(copy);
+            return 0;
+        }
+        memcpy(copy->nameArena.bytes, source->nameArena.bytes, source->nameArena.used);
+        copy->nameArena.used = copy->nameArena.capacity = source->nameArena.used;
+        copy->nameArena.live = source->nameArena.live;
+        for (j = 0; j < source->courseCount; j++) {
+            memcpy(copy->scores[j], source->scores[j], n * scoreWidth(source));
+        }
+        memcpy(copy->totals, source->totals, n * sizeof(float));
+        memcpy(copy->averages, source->averages, n * sizeof(float));
+        for (j = 0; j < source->attributeCount; j++) {
+            memcpy(copy->attributes[j].codes, source->attributes[j].codes, n * sizeof(uint16_t));
+        }
+    }
+    copy->count = n;
+    copy->generation = source->generation;
+    return 1;
+}
+
+// Function 161: write() all of a buffer, retrying short writes
+int writeAll(int fd, const void *data, size_t size) {
+    const char *bytes = data;
+    ssize_t written;
+
+    while (size > 0) {
+        if ((written = write(fd, bytes, size)) < 0) {
+            return 0;
+        }
+        bytes += written;
+        size -= written;
+    }
+    return 1;
+}
+
+// Function 162: fsync the directory holding a file so a rename or create in it is durable
+void syncParentDirectory(const char *path) {
+    char directory[1024];
+    const char *slash = strrchr(path, '/');
+    int fd;
+
+    if (slash == NULL) {
+        strcpy(directory, ".");
+    } else {
+        snprintf(directory, sizeof(directory), "%.*s", (int)(slash - path > 0 ? slash - path : 1), path);
+    }
+    if ((fd = open(directory, O_RDONLY)) >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+// Function 163: Next number from a seeded generator (splitmix64), so generated data is reproducible
+uint64_t nextRandom(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Function 164: Uniform random number in [0, 1)
+double randomUnit(uint64_t *state) {
+    return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Function 165: Random "First Last" name; common names come up far more often than rare ones
+void randomStudentName(uint64_t *state, char *name) {
+    static const char *firstNames[] = {
+        "James", "Mary", "Wei", "Fatima", "Olga", "Juan", "Aiko", "Liam", "Priya", "Noah",
+        "Emma", "Mohammed", "Sofia", "Ivan", "Chen", "Amara", "Lucas", "Mia", "Arjun", "Hana",
+        "Mateo", "Zara", "Oliver", "Yuki", "Elena", "Kwame", "Ingrid", "Omar", "Chloe", "Santiago",
+        "Anna-Maria", "Jean Paul", "Nguyen", "Leila", "Bjorn", "Ana", "Tomasz", "Grace", "Ravi", "Eva"
+    };
+    static const char *lastNames[] = {
+        "Smith", "Wang", "Garcia", "Kim", "Ivanova", "Okafor", "Muller", "Rossi", "Tanaka", "Patel",
+        "Silva", "Johnson", "Nguyen", "Cohen", "Kowalski", "Haddad", "Jensen", "Brown", "Lopez", "Sato",
+        "Dubois", "Li", "Martinez", "Novak", "Petrov", "Ali", "Andersson", "Murphy", "Singh", "Costa",
+        "Van Dyke", "Smith-Jones", "Fernandez", "Yilmaz", "Schmidt", "Chen", "Moreau", "Kaur", "Hughes", "Zhang"
+    };
+    int firstCount = sizeof(firstNames) / sizeof(firstNames[0]);
+    int lastCount = sizeof(lastNames) / sizeof(lastNames[0]);
+    double u = randomUnit(state), v = randomUnit(state);
+
+    // Squaring skews the pick toward the front of each list
+    snprintf(name, MAX_NAME_LEN, "%s %s", firstNames[(int)(u * u * firstCount)], lastNames[(int)(v * v * lastCount)]);
+}
+
+// Function 166: Random score around a course's mean, in half points from 0 to 100
+float randomScore(uint64_t *state, double mean, double spread) {
+    double u = randomUnit(state), v = randomUnit(state);
+    double score = mean + spread * sqrt(-2.0 * log(1.0 - u)) * cos(2.0 * M_PI * v);   // Box-Muller
+
+    if (score < 0) score = 0;
+    if (score > 100) score = 100;
+    return (float)(floor(score * 2 + 0.5) / 2);
+}
+
+// Function 167: Write a reproducible roster of studentCount rows to a CSV file in the import format;
+// with sectionCount > 0 each student is also put in one of that many sections
+int generateRoster(const char *path, long studentCount, int courseCount, int sectionCount, uint64_t seed) {
+    double means[MAX_COURSES], spreads[MAX_COURSES];
+    char name[MAX_NAME_LEN];
+    uint64_t state = seed;
+    long *ids, i, k, swap;
+    FILE *file;
+    int j, sectionWidth = 2;
+
+    if (studentCount < 1 || courseCount < 1 || courseCount > MAX_COURSES) {
+        printf("ERROR: Need at least 1 student and between 1 and %d courses.\n", MAX_COURSES);
+        return 0;
+    }
+    if (sectionCount < 0 || sectionCount >= MAX_ATTRIBUTE_VALUES) {
+        printf("ERROR: Sections must be between 1 and %d.\n", MAX_ATTRIBUTE_VALUES - 1);
+        return 0;
+    }
+    // Section names are zero-padded (S01 ... S50) so they sort in number order
+    for (k = 100; k <= sectionCount; k *= 10) {
+        sectionWidth++;
+    }
+    if ((ids = malloc(studentCount * sizeof(long))) == NULL) {
+        printf("ERROR: Not enough memory for %ld students.\n", studentCount);
+        return 0;
+    }
+    if ((file = fopen(path, "w")) == NULL) {
+        printf("ERROR: Cannot write '%s'.\n", path);
+        free(ids);
+        return 0;
+    }
+    setvbuf(file, NULL, _IOFBF, IMPORT_BUFFER_SIZE);
+
+    // Consecutive IDs in shuffled order, so sorting by ID has real work to do
+    for (i = 0; i < studentCount; i++) {
+        ids[i] = MIN_STUDENT_ID + i;
+    }
+    for (i = studentCount - 1; i > 0; i--) {
+        k = (long)(nextRandom(&state) % (uint64_t)(i + 1));
+        swap = ids[i]; ids[i] = ids[k]; ids[k] = swap;
+    }
+
+    // Some courses are harder than others
+    for (j = 0; j < courseCount; j++) {
+        means[j] = 55 + randomUnit(&state) * 25;
+        spreads[j] = 8 + randomUnit(&state) * 8;
+    }
+
+    fprintf(file, "id,name%s", sectionCount > 0 ? ",section" : "");
+    for (j = 0; j < courseCount; j++) {
+        fprintf(file, ",course%d", j + 1);
+    }
+    fputc('\n', file);
+    for (i = 0; i < studentCount; i++) {
+        randomStudentName(&state, name);
+        fprintf(file, "%ld,%s", ids[i], name);
+        if (sectionCount > 0) {
+            fprintf(file, ",S%0*d", sectionWidth, (int)(nextRandom(&state) % (uint64_t)sectionCount) + 1);
+        }
+        for (j = 0; j < courseCount; j++) {
+            fprintf(file, ",%g", randomScore(&state, means[j], spreads[j]));
+        }
+        fputc('\n', file);
+    }
+    free(ids);
+
+    if (fclose(file) != 0) {
+        printf("ERROR: Failed to write '%s'.\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+// Function 168: Send stdout to /dev/null while a report is timed; returns the descriptor to restore
+int silenceStdout(void) {
+    int saved, null;
+
+    fflush(stdout);
+    if ((saved = dup(STDOUT_FILENO)) < 0 || (null = open("/dev/null", O_WRONLY)) < 0) {
+        return saved;
+    }
+    dup2(null, STDOUT_FILENO);
+    close(null);
+    return saved;
+}
+
+// Function 169: Undo silenceStdout
+void restoreStdout(int saved) {
+    fflush(stdout);
+    if (saved >= 0) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+}
+
+// Function 170: Drop cached views, aggregates and histograms so the next report starts cold
+void dropDerivedData(StudentTable *table) {
+    table->version++;
+    table->activeView = VIEW_NONE;
+    free(table->aggregates);
+    table->aggregates = NULL;
+    freeDistributions(table->distributions, table->courseCount + 1);
+    table->distributions = NULL;
+}
+
+// Function 171: Time one run of a menu operation from a cold start, in seconds
+double timeBenchOperation(StudentTable *table, BenchOperation operation) {
+    struct timespec began;
+    int saved;
+
+    dropDerivedData(table);
+    saved = silenceStdout();
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    switch (operation) {
+        case BENCH_SORT_TOTAL_DESC: sortByTotalScore(table, 1); break;
+        case BENCH_SORT_TOTAL_ASC:  sortByTotalScore(table, 0); break;
+        case BENCH_SORT_ID:         sortByStudentId(table); break;
+        case BENCH_SORT_NAME:       sortByStudentName(table); break;
+        case BENCH_COURSE_STATS:    showCourseStatistics(table); break;
+        case BENCH_STUDENT_STATS:   showStudentStatistics(table); break;
+        case BENCH_GRADE_STATS:     showGradeStatistics(table); break;
+        case BENCH_DISPLAY:         displayAllStudents(table); break;
+        default: break;
+    }
+    fflush(stdout);
+    restoreStdout(saved);
+    return elapsedSeconds(&began);
+}
+
+// Function 172: Sort the samples and write one result line to the console and the results file
+void reportBenchmark(FILE *out, long records, const char *operation, double *samples, int count,
+                     double itemsPerSample) {
+    double sum = 0, mean, p50, p90, p99, perSecond;
+    int i;
+
+    qsort(samples, count, sizeof(double), compareDoubles);
+    for (i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    mean = sum / count * 1e3;
+    p50 = samples[(int)((count - 1) * 0.50 + 0.5)] * 1e3;
+    p90 = samples[(int)((count - 1) * 0.90 + 0.5)] * 1e3;
+    p99 = samples[(int)((count - 1) * 0.99 + 0.5)] * 1e3;
+    perSecond = sum > 0 ? itemsPerSample * count / sum : 0.0;
+
+    printf("%10ld  %-16s %6d %11.4f %11.4f %11.4f %11.4f %11.4f %14.0f\n", records, operation, count,
+           mean, p50, p90, p99, samples[count - 1] * 1e3, perSecond);
+    fprintf(out, "%ld\t%s\t%d\t%.6f\t%.6f\t%.6f\t%.6f\t%.6f\t%.0f\n", records, operation, count,
+            mean, p50, p90, p99, samples[count - 1] * 1e3, perSecond);
+}
+
+// Function 173: Generate rosters of each size and time every menu operation on them
+int runBenchmarks(const char *sizes, int courseCount, uint64_t seed, const char *outputPath) {
+    static const char *operationNames[BENCH_OPERATION_COUNT] = {
+        "ingest", "sort_total_desc", "sort_total_asc", "sort_id", "sort_name", "search_id", "search_name",
+        "course_stats", "student_stats", "grade_stats", "display"
+    };
+    char dataPath[1040];
+    double *samples;
+    const char *cursor = sizes;
+    char *end;
+    FILE *out;
+    int ok = 1;
+
+    if ((out = fopen(outputPath, "w")) == NULL) {
+        printf("ERROR: Cannot write '%s'.\n", outputPath);
+        return 0;
+    }
+    if ((samples = malloc(BENCH_LOOKUPS * sizeof(double))) == NULL) {
+        fclose(out);
+        return 0;
+    }
+    snprintf(dataPath, sizeof(dataPath), "%s.data.csv", outputPath);
+
+    fprintf(out, "# courses=%d seed=%llu threads=%d kernel=%s\n", courseCount, (unsigned long long)seed,
+            workerPool.threadCount, statisticsKernelName);
+    fprintf(out, "records\toperation\tsamples\tmean_ms\tp50_ms\tp90_ms\tp99_ms\tmax_ms\tper_second\n");
+    printf("\n%10s  %-16s %6s %11s %11s %11s %11s %11s %14s\n", "records", "operation", "runs",
+           "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms", "per second");
+
+    while (ok && *cursor != '\0') {
+        long records = strtol(cursor, &end, 10), lookups;
+        int reps, rep, op, found, first, last;
+        StudentTable table;
+        ImportSummary summary;
+        uint64_t state = seed;
+
+        if (end == cursor || records < 1 || records > INT_MAX - MIN_STUDENT_ID) {
+            printf("ERROR: Bad size list '%s'.\n", sizes);
+            ok = 0;
+            break;
+        }
+        cursor = *end == ',' ? end + 1 : end;
+
+        // Roughly the same number of rows is processed at every size
+        reps = (int)(BENCH_ROW_BUDGET / records);
+        if (reps < BENCH_MIN_REPS) reps = BENCH_MIN_REPS;
+        if (reps > BENCH_MAX_REPS) reps = BENCH_MAX_REPS;
+
+        if (!generateRoster(dataPath, records, courseCount, 0, seed)) {
+            ok = 0;
+            break;
+        }
+        if (maxStudentId < MIN_STUDENT_ID + records - 1) {
+            maxStudentId = MIN_STUDENT_ID + records - 1;
+        }
+
+        // Ingest: parse and validate the CSV into a fresh table; the last one is kept
+        memset(&table, 0, sizeof(table));
+        for (rep = 0; rep < reps && ok; rep++) {
+            freeStudentTable(&table);
+            ok = initStudentTable(&table, 0) && importStudentsCsv(&table, dataPath, NULL, &summary) &&
+                 summary.imported == records;
+            samples[rep] = summary.seconds;
+        }
+        remove(dataPath);
+        if (!ok) {
+            printf("ERROR: Generated roster did not import cleanly.\n");
+            freeStudentTable(&table);
+            break;
+        }
+        reportBenchmark(out, records, operationNames[BENCH_INGEST], samples, reps, records);
+
+        for (op = BENCH_SORT_TOTAL_DESC; op < BENCH_OPERATION_COUNT; op++) {
+            if (op == BENCH_SEARCH_ID || op == BENCH_SEARCH_NAME) {
+                // Searches are timed one lookup at a time against warm indexes
+                lookups = BENCH_LOOKUPS;
+                findStudentById(&table, table.ids[0]);
+                getSortedView(&table, VIEW_NAME);
+                for (rep = 0; rep < lookups; rep++) {
+                    int row = (int)(nextRandom(&state) % (uint64_t)table.count);
+                    struct timespec began;
+
+                    clock_gettime(CLOCK_MONOTONIC, &began);
+                    if (op == BENCH_SEARCH_ID) {
+                        found = findStudentById(&table, table.ids[row]) == row;
+                    } else {
+                        found = findNameRange(&table, studentName(&table, row), 0, &first, &last);
+                    }
+                    samples[rep] = elapsedSeconds(&began);
+                    if (!found) {
+                        printf("ERROR: Benchmark lookup missed row %d.\n", row);
+                    }
+                }
+                reportBenchmark(out, records, operationNames[op], samples, lookups, 1);
+                continue;
+            }
+            for (rep = 0; rep < reps; rep++) {
+                samples[rep] = timeBenchOperation(&table, (BenchOperation)op);
+            }
+            reportBenchmark(out, records, operationNames[op], samples, reps, records);
+        }
+        freeStudentTable(&table);
+        fflush(out);
+    }
+
+    free(samples);
+    if (fclose(out) != 0) {
+        ok = 0;
+    }
+    if (ok) {
+        printf("\nResults written to '%s'.\n", outputPath);
+    }
+    return ok;
+}
+
+// Function 174: qsort comparison for doubles, ascending
+int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+// Function 175: Turn on operation statistics; stdout is routed through a counter of bytes written
+void enableOperationStats(void) {
+    cookie_io_functions_t io = {NULL, countOutputBytes, NULL, NULL};
+    FILE *counted;
+
+    if (statsEnabled) {
+        return;
+    }
+    statsEnabled = 1;
+    fflush(stdout);
+    if ((counted = fopencookie(NULL, "w", io)) != NULL) {
+        // Keep prompts appearing before input is read, as on a terminal
+        setvbuf(counted, NULL, isatty(STDOUT_FILENO) ? _IOLBF : _IOFBF, BUFSIZ);
+        stdout = counted;
+    }
+}
+
+// Function 176: Write callback of the counting stdout stream
+ssize_t countOutputBytes(void *cookie, const char *data, size_t size) {
+    (void)cookie;
+    if (!writeAll(STDOUT_FILENO, data, size)) {
+        return -1;
+    }
+    outputBytes += size;
+    return size;
+}
+
+// Function 177: Start timing an operation (nothing happens while statistics are off)
+void beginOperation(OperationTimer *timer) {
+    if (!statsEnabled) {
+        return;
+    }
+    fflush(stdout);
+    timer->bytes = outputBytes;
+    clock_gettime(CLOCK_MONOTONIC, &timer->began);
+}
+
+// Function 178: Finish timing an operation and charge it to a statistics slot
+void endOperation(const OperationTimer *timer, int slot, long records) {
+    if (!statsEnabled) {
+        return;
+    }
+    fflush(stdout);
+    recordOperation(slot, elapsedSeconds(&timer->began), records, outputBytes - timer->bytes);
+}
+
+// Function 179: Add one call to a statistics slot
+void recordOperation(int slot, double seconds, long records, uint64_t bytes) {
+    OperationStats *stats = &operationStats[slot];
+    uint64_t nanos = seconds > 0 ? (uint64_t)(seconds * 1e9) : 0;
+
+    pthread_mutex_lock(&statsLock);
+    stats->calls++;
+    stats->nanos += nanos;
+    stats->records += records > 0 ? records : 0;
+    stats->bytes += bytes;
+    stats->latency[latencyBucket(nanos)]++;
+    pthread_mutex_unlock(&statsLock);
+}
+
+// Function 180: Histogram bucket of a duration: 2^LATENCY_SUB_BITS buckets per power of two
+int latencyBucket(uint64_t nanos) {
+    int exponent;
+
+    if (nanos < (1u << LATENCY_SUB_BITS)) {
+        return (int)nanos;
+    }
+    exponent = 63 - __builtin_clzll(nanos);
+    return ((exponent - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) +
+           (int)((nanos >> (exponent - LATENCY_SUB_BITS)) & ((1u << LATENCY_SUB_BITS) - 1));
+}
+
+// Function 181: Middle of a latency bucket, in nanoseconds
+double latencyBucketValue(int bucket) {
+    int shift;
+
+    if (bucket < (1 << LATENCY_SUB_BITS)) {
+        return bucket;
+    }
+    shift = (bucket >> LATENCY_SUB_BITS) - 1;
+    return ((double)((1 << LATENCY_SUB_BITS) + (bucket & ((1 << LATENCY_SUB_BITS) - 1))) + 0.5) * ldexp(1.0, shift);
+}
+
+// Function 182: Latency below which a fraction of a slot's calls finished, in nanoseconds
+double latencyPercentile(const OperationStats *stats, double fraction) {
+    uint64_t wanted = (uint64_t)ceil(stats->calls * fraction), seen = 0;
+    int bucket;
+
+    if (wanted < 1) wanted = 1;
+    for (bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += stats->latency[bucket];
+        if (seen >= wanted) {
+            return latencyBucketValue(bucket);
+        }
+    }
+    return 0;
+}
+
+// Function 183: Name shown for a statistics slot
+const char *operationName(int slot) {
+    static const char *menuNames[MENU_MAX_CHOICE + 1] = {
+        "exit", "help", "enter data", "course stats", "student stats", "sort high-low", "sort low-high",
+        "sort by id", "sort by name", "search id", "search name", "grades", "list all", "save snapshot",
+        "top/bottom", "rank", "add student", "update score", "rename student", "delete student", "op stats",
+        "range query", "group report", "term history"
+    };
+
+    if (slot <= MENU_MAX_CHOICE) {
+        return menuNames[slot];
+    }
+    if (slot == STAT_INGEST) {
+        return "csv ingest";
+    }
+    return batchCommandNames[slot - STAT_BATCH_FIRST];
+}
+
+// Function 184: Statistics slot of a batch command line, by its first word
+int batchCommandSlot(const char *line) {
+    size_t length;
+    int i;
+
+    while (*line == ' ' || *line == '\t') line++;
+    length = strcspn(line, " \t");
+    for (i = 0; i < BATCH_COMMAND_COUNT - 1; i++) {
+        if (strlen(batchCommandNames[i]) == length && strncmp(line, batchCommandNames[i], length) == 0) {
+            break;
+        }
+    }
+    return STAT_BATCH_FIRST + i;
+}
+
+// Function 185: Every slot that has been used: calls, time, p50/p99 latency, records and bytes;
+// returns the number of lines written
+int writeOperationStats(FILE *out, int tabSeparated) {
+    int slot, lines = 0;
+
+    if (!tabSeparated) {
+        fprintf(out, "\n%-16s %8s %12s %10s %10s %12s %14s\n", "operation", "calls", "total ms", "p50 ms",
+                "p99 ms", "records", "bytes");
+    }
+    for (slot = 0; slot < STAT_SLOTS; slot++) {
+        const OperationStats *stats = &operationStats[slot];
+
+        if (stats->calls == 0) {
+            continue;
+        }
+        fprintf(out, tabSeparated ? "%s\t%llu\t%.3f\t%.3f\t%.3f\t%llu\t%llu\n"
+                                  : "%-16s %8llu %12.3f %10.3f %10.3f %12llu %14llu\n",
+                operationName(slot), (unsigned long long)stats->calls, stats->nanos / 1e6,
+                latencyPercentile(stats, 0.5) / 1e6, latencyPercentile(stats, 0.99) / 1e6,
+                (unsigned long long)stats->records, (unsigned long long)stats->bytes);
+        lines++;
+    }
+    return lines;
+}
+
+// Function 186: Menu option 20: show the statistics collected so far
+void showOperationStats(void) {
+    if (!statsEnabled) {
+        printf("\nERROR: Statistics are off. Start with --stats or set %s=1.\n", STATS_ENV);
+        return;
+    }
+    printf("\n============================================\n");
+    printf("           OPERATION STATISTICS\n");
+    printf("============================================\n");
+    writeOperationStats(stdout, 0);
+}
+
+// Function 187: stats ops: one line per operation used so far
+int batchOperationStats(BatchSession *session) {
+    if (!statsEnabled) {
+        return batchError(session, "statistics are off (start with --stats or set %s=1)", STATS_ENV);
+    }
+    session->rows += writeOperationStats(session->out, 1);
+    return BATCH_OK;
+}
+
+// Function 188: Rows a menu option covers, for the statistics
+long menuRecordsTouched(const StudentTable *table, int choice, int studentCount) {
+    switch (choice) {
+        case 2:
+            return studentCount;
+        case 9: case 10: case 16: case 17: case 18: case 19:
+            return 1;
+        case 3: case 4: case 5: case 6: case 7: case 8: case 11: case 12: case 13: case 14: case 15: case 22:
+            return table->count;
+        default:
+            return 0;
+    }
+}
+
+// Function 189: A row's name
+const char *studentName(const StudentTable *table, int row) {
+    return table->nameArena.bytes + table->names[row].offset;
+}
+
+// Function 190: A row's case-folded name; plain byte order on these is case-insensitive name order
+const char *foldedName(const StudentTable *table, int row) {
+    return table->nameArena.bytes + table->names[row].offset + table->names[row].length + 1;
+}
+
+// Function 191: Copy a name and its folded key into the arena, or find an identical name already there
+int storeName(StudentTable *table, const char *name, NameRef *ref) {
+    NameArena *arena = &table->nameArena;
+    size_t length = strlen(name), needed = 2 * length + 2, capacity;
+    uint32_t slot = 0;
+    char *grown;
+
+    if (internNames) {
+        if (arena->internSlots == NULL || 2 * (arena->internCount + 1) > arena->internMask + 1) {
+            if (!growNameIntern(table, arena->internSlots == NULL)) return 0;
+        }
+        for (slot = nameHash(name, length) & arena->internMask; arena->internSlots[slot] != 0;
+             slot = (slot + 1) & arena->internMask) {
+            if (strcmp(arena->bytes + arena->internSlots[slot] - 1, name) == 0) {
+                ref->offset = arena->internSlots[slot] - 1;
+                ref->length = (uint32_t)length;
+                arena->live += needed;
+                return 1;
+            }
+        }
+    }
+
+    // Bump allocation; a mapped arena is copied to the heap the first time it grows
+    if (arena->used + needed > arena->capacity) {
+        capacity = arena->capacity > 0 ? arena->capacity : 4096;
+        while (capacity < arena->used + needed) capacity *= 2;
+        if (capacity > (size_t)UINT32_MAX + 1) {
+            capacity = (size_t)UINT32_MAX + 1;
+            if (arena->used + needed > capacity) return 0;
+        }
+        if (arena->capacity > 0) {
+            if ((grown = realloc(arena->bytes, capacity)) == NULL) return 0;
+        } else {
+            if ((grown = malloc(capacity)) == NULL) return 0;
+            if (arena->used > 0) memcpy(grown, arena->bytes, arena->used);
+        }
+        arena->bytes = grown;
+        arena->capacity = capacity;
+    }
+
+    ref->offset = (uint32_t)arena->used;
+    ref->length = (uint32_t)length;
+    memcpy(arena->bytes + arena->used, name, length + 1);
+    foldName(name, length, arena->bytes + arena->used + length + 1);
+    arena->bytes[arena->used + needed - 1] = '\0';
+    arena->used += needed;
+    arena->live += needed;
+    if (internNames) {
+        arena->internSlots[slot] = ref->offset + 1;
+        arena->internCount++;
+    }
+    return 1;
+}
+
+// Function 192: Forget a row's name; its bytes stay in the arena until the next compaction
+void releaseName(StudentTable *table, NameRef ref) {
+    size_t needed = 2 * (size_t)ref.length + 2;
+
+    table->nameArena.live = table->nameArena.live > needed ? table->nameArena.live - needed : 0;
+}
+
+// Function 193: Double the intern table, or create it (seeded with the names rows already use, if asked)
+int growNameIntern(StudentTable *table, int seedFromRows) {
+    NameArena *arena = &table->nameArena;
+    uint32_t *old = arena->internSlots, oldSize = old ? arena->internMask + 1 : 0, size, i, slot, offset;
+    int row;
+
+    size = oldSize > 0 ? oldSize * 2 : 1024;
+    while (size < 2 * (uint32_t)table->count) size *= 2;
+    if ((arena->internSlots = calloc(size, sizeof(uint32_t))) == NULL) {
+        arena->internSlots = old;
+        return 0;
+    }
+    arena->internMask = size - 1;
+    arena->internCount = 0;
+
+    for (i = 0; i < (old != NULL ? oldSize : seedFromRows ? (uint32_t)table->count : 0); i++) {
+        if (old != NULL) {
+            if (old[i] == 0) continue;
+            offset = old[i] - 1;
+        } else {
+            row = (int)i;
+            offset = table->names[row].offset;
+        }
+        for (slot = nameHash(arena->bytes + offset, strlen(arena->bytes + offset)) & arena->internMask;
+             arena->internSlots[slot] != 0 && strcmp(arena->bytes + arena->internSlots[slot] - 1, arena->bytes + offset) != 0;
+             slot = (slot + 1) & arena->internMask) {}
+        if (arena->internSlots[slot] == 0) {
+            arena->internSlots[slot] = offset + 1;
+            arena->internCount++;
+        }
+    }
+    free(old);
+    return 1;
+}
+
+// Function 194: FNV-1a hash of a name
+uint32_t nameHash(const char *name, size_t length) {
+    uint32_t hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Function 195: Rewrite the arena with only the names rows still use, once renames and deletes
+// have left more dead bytes than live ones
+int compactNameArena(StudentTable *table, int force) {
+    NameArena old = table->nameArena, *arena = &table->nameArena;
+    size_t needed = 0;
+    int row;
+
+    if (!force && old.used <= 2 * old.live + NAME_ARENA_SLACK) {
+        return 1;
+    }
+
+    // Allocate everything first (enough even if no name is shared) so storing cannot fail halfway
+    for (row = 0; row < table->count; row++) {
+        needed += 2 * (size_t)table->names[row].length + 2;
+    }
+    memset(arena, 0, sizeof(*arena));
+    arena->capacity = needed > 0 ? needed : 1;
+    if ((arena->bytes = malloc(arena->capacity)) == NULL ||
+        (internNames && !growNameIntern(table, 0))) {
+        free(arena->bytes);
+        *arena = old;
+        return 0;
+    }
+    for (row = 0; row < table->count; row++) {
+        storeName(table, old.bytes + table->names[row].offset, &table->names[row]);
+    }
+
+    if (old.capacity > 0) {
+        free(old.bytes);
+    }
+    free(old.internSlots);
+    return 1;
+}
+
+// Function 196: Fold case for sorting and searching: ASCII plus the two-byte Latin, Greek and
+// Cyrillic letters; every folded letter keeps its encoded length
+void foldName(const char *name, size_t length, char *out) {
+    const unsigned char *in = (const unsigned char *)name;
+    unsigned int c, codePoint;
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        c = in[i];
+        if (c >= 'A' && c <= 'Z') {
+            out[i] = (char)(c + ('a' - 'A'));
+        } else if (c >= 0xC2 && c <= 0xDF && i + 1 < length && (in[i + 1] & 0xC0) == 0x80) {
+            codePoint = ((c & 0x1F) << 6) | (in[i + 1] & 0x3F);
+            if ((codePoint >= 0xC0 && codePoint <= 0xDE && codePoint != 0xD7) ||
+                (codePoint >= 0x391 && codePoint <= 0x3AB && codePoint != 0x3A2) ||
+                (codePoint >= 0x410 && codePoint <= 0x42F)) {
+                codePoint += 0x20;
+            } else if (codePoint >= 0x400 && codePoint <= 0x40F) {
+                codePoint += 0x50;
+            } else if (((codePoint >= 0x100 && codePoint <= 0x137) || (codePoint >= 0x14A && codePoint <= 0x177)) &&
+                       codePoint % 2 == 0) {
+                codePoint++;
+            } else if (((codePoint >= 0x139 && codePoint <= 0x148) || (codePoint >= 0x179 && codePoint <= 0x17E)) &&
+                       codePoint % 2 == 1) {
+                codePoint++;
+            } else if (codePoint == 0x178) {
+                codePoint = 0xFF;
+            }
+            out[i] = (char)(0xC0 | (codePoint >> 6));
+            out[i + 1] = (char)(0x80 | (codePoint & 0x3F));
+            i++;
+        } else {
+            out[i] = (char)c;
+        }
+    }
+}
+
+// Function 197: Bytes in a well-formed UTF-8 character starting at text (0 if malformed or a control)
+int utf8SequenceLength(const unsigned char *text) {
+    unsigned int c = text[0], codePoint;
+    int length, i;
+
+    if (c < 0x80) return 1;
+    if (c >= 0xC2 && c <= 0xDF) { length = 2; codePoint = c & 0x1F; }
+    else if (c >= 0xE0 && c <= 0xEF) { length = 3; codePoint = c & 0x0F; }
+    else if (c >= 0xF0 && c <= 0xF4) { length = 4; codePoint = c & 0x07; }
+    else return 0;
+
+    for (i = 1; i < length; i++) {
+        if ((text[i] & 0xC0) != 0x80) return 0;
+        codePoint = (codePoint << 6) | (text[i] & 0x3F);
+    }
+    // Overlong forms, surrogates, values past U+10FFFF and C1 controls are rejected
+    if ((length == 3 && codePoint < 0x800) || (length == 4 && (codePoint < 0x10000 || codePoint > 0x10FFFF)) ||
+        (codePoint >= 0xD800 && codePoint <= 0xDFFF) || codePoint < 0xA0) {
+        return 0;
+    }
+    return length;
+}
+
+// Function 198: Characters (not bytes) in the first length bytes of UTF-8 text
+int displayWidth(const char *text, size_t length) {
+    int width = 0;
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        if (((unsigned char)text[i] & 0xC0) != 0x80) width++;
+    }
+    return width;
+}
+
+// Function 199: Spaces that pad a name to a column width on screen
+int namePadding(const char *name, int width) {
+    int shown = displayWidth(name, strlen(name));
+
+    return shown < width ? width - shown : 0;
+}
+
+// Function 200: Whether a pointer lies inside the table's snapshot mapping; its end counts, since
+// the columns of an empty snapshot start there
+int insideMapping(const StudentTable *table, const void *pointer) {
+    const char *base = table->mapping;
+
+    return base != NULL && (const char *)pointer >= base && (const char *)pointer <= base + table->mappingSize;
+}
+
+// Function 201: Serve query commands on a Unix socket until SIGINT or SIGTERM; reads run side by side,
+// writes are applied in batches by one writer thread
+int runServer(StudentTable *table, const char *socketPath, const char *snapshotPath) {
+    struct sockaddr_un address;
+    struct sigaction action;
+    struct pollfd waiting;
+    pthread_rwlockattr_t attributes;
+    pthread_t client;
+    int fd;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "ERROR: Socket path '%s' is too long.\n", socketPath);
+        return 0;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    // A socket file left by a server that did not shut down cleanly is replaced
+    unlink(socketPath);
+    if ((server.listenFd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+        bind(server.listenFd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(server.listenFd, SERVER_BACKLOG) != 0) {
+        fprintf(stderr, "ERROR: Cannot listen on '%s'.\n", socketPath);
+        if (server.listenFd >= 0) close(server.listenFd);
+        return 0;
+    }
+
+    server.table = table;
+    server.snapshotPath = snapshotPath;
+    // Writers are preferred so a steady stream of readers cannot hold a batch back forever
+    pthread_rwlockattr_init(&attributes);
+    pthread_rwlockattr_setkind_np(&attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&server.lock, &attributes);
+    pthread_rwlockattr_destroy(&attributes);
+    pthread_mutex_init(&server.queueLock, NULL);
+    pthread_cond_init(&server.queued, NULL);
+    pthread_cond_init(&server.applied, NULL);
+    server.exclusiveReads = !prepareForReaders(table);
+    if (pthread_create(&server.writer, NULL, serverWriterMain, NULL) != 0) {
+        fprintf(stderr, "ERROR: Cannot start the writer thread.\n");
+        close(server.listenFd);
+        unlink(socketPath);
+        return 0;
+    }
+
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handleServerSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    // A client that hangs up mid-reply is noticed by the failed write instead
+    signal(SIGPIPE, SIG_IGN);
+    fprintf(stderr, "Serving %d records on '%s'.\n", table->count, socketPath);
+
+    waiting.fd = server.listenFd;
+    waiting.events = POLLIN;
+    while (!serverStopping) {
+        if (poll(&waiting, 1, SERVER_POLL_MS) <= 0) {
+            continue;
+        }
+        if ((fd = accept(server.listenFd, NULL, NULL)) < 0) {
+            continue;
+        }
+        if (pthread_create(&client, NULL, serverClientMain, (void *)(intptr_t)fd) != 0) {
+            close(fd);
+            continue;
+        }
+        pthread_detach(client);
+    }
+
+    // Let queued writes finish, then hold the lock so no reader is left mid-command
+    close(server.listenFd);
+    unlink(socketPath);
+    pthread_mutex_lock(&server.queueLock);
+    server.stopping = 1;
+    pthread_cond_broadcast(&server.queued);
+    pthread_mutex_unlock(&server.queueLock);
+    pthread_join(server.writer, NULL);
+    pthread_rwlock_wrlock(&server.lock);
+
+    fprintf(stderr, "Served %ld reads and %ld writes in %ld write batches.\n", __atomic_load_n(&server.reads, __ATOMIC_RELAXED),
+            server.writes, server.batches);
+    if (hasUnsavedChanges && snapshotPath != NULL && checkpointTable(table, snapshotPath)) {
+        hasUnsavedChanges = 0;
+    }
+    return 1;
+}
+
+// Function 202: SIGINT/SIGTERM handler for the server
+void handleServerSignal(int signalNumber) {
+    (void)signalNumber;
+    serverStopping = 1;
+}
+
+// Function 203: One client connection: batch commands in, batch results out
+void *serverClientMain(void *argument) {
+    int fd = (int)(intptr_t)argument, status, kind;
+    BatchSession session;
+    struct timespec began;
+    char line[BATCH_LINE_LEN], *reply = NULL;
+    size_t length, replySize = 0;
+    FILE *in = fdopen(fd, "r");
+
+    session.table = server.table;
+    session.snapshotPath = server.snapshotPath;
+    // Results are gathered in memory so no lock is held while a slow client reads them
+    session.out = open_memstream(&reply, &replySize);
+    if (in == NULL || session.out == NULL) {
+        if (session.out != NULL) fclose(session.out);
+        if (in != NULL) fclose(in); else close(fd);
+        free(reply);
+        return NULL;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        length = strcspn(line, "\r\n");
+        session.rows = 0;
+        session.error[0] = '\0';
+        clock_gettime(CLOCK_MONOTONIC, &began);
+
+        if (line[length] == '\0' && !feof(in)) {
+            int c;
+            while ((c = fgetc(in)) != EOF && c != '\n') {}
+            status = batchError(&session, "command is too long");
+        } else {
+            line[length] = '\0';
+            kind = serverCommandKind(line);
+            if (kind == SERVER_READ) {
+                pthread_rwlock_rdlock(&server.lock);
+                if (server.exclusiveReads) {
+                    // Caches could not be built up front, so a reader may have to build them
+                    pthread_rwlock_unlock(&server.lock);
+                    pthread_rwlock_wrlock(&server.lock);
+                }
+                status = runBatchCommand(&session, line);
+                __atomic_add_fetch(&server.reads, 1, __ATOMIC_RELAXED);
+                pthread_rwlock_unlock(&server.lock);
+            } else if (kind == SERVER_WRITE) {
+                status = submitServerWrite(&session, line);
+            } else {
+                status = batchError(&session, "'%.*s' is not available in server mode",
+                                    (int)strcspn(line, " \t"), line);
+            }
+        }
+        if (status == BATCH_SKIP) {
+            continue;
+        }
+        if (status == BATCH_QUIT) {
+            break;
+        }
+        writeBatchStatus(&session, status);
+        fflush(session.out);
+        if (!writeAll(fd, reply, replySize)) {
+            break;
+        }
+        if (statsEnabled) {
+            recordOperation(batchCommandSlot(line), elapsedSeconds(&began), session.rows, replySize);
+        }
+        rewind(session.out);
+    }
+
+    fclose(session.out);
+    free(reply);
+    fclose(in);
+    return NULL;
+}
+
+// Function 204: Whether a command only reads the table, changes it, or is not served
+int serverCommandKind(const char *line) {
+    static const char *writes[] = {"insert", "update", "rename", "delete", "save"};
+    static const char *refused[] = {"load", "export", "sort", "list"};
+    size_t length;
+    int i;
+
+    while (*line == ' ' || *line == '\t') line++;
+    length = strcspn(line, " \t");
+    for (i = 0; i < (int)(sizeof(writes) / sizeof(writes[0])); i++) {
+        if (length == strlen(writes[i]) && strncmp(line, writes[i], length) == 0) return SERVER_WRITE;
+    }
+    // load replaces the whole table, and sort, list and export follow a listing order shared by all clients
+    for (i = 0; i < (int)(sizeof(refused) / sizeof(refused[0])); i++) {
+        if (length == strlen(refused[i]) && strncmp(line, refused[i], length) == 0) return SERVER_REFUSED;
+    }
+    return SERVER_READ;
+}
+
+// Function 205: Hand a write to the writer thread and wait until its batch is applied and durable
+int submitServerWrite(BatchSession *session, char *line) {
+    ServerWrite request = {session, line, BATCH_FAILED, 0, NULL};
+
+    pthread_mutex_lock(&server.queueLock);
+    if (server.stopping) {
+        pthread_mutex_unlock(&server.queueLock);
+        return batchError(session, "server is shutting down");
+    }
+    if (server.tail != NULL) {
+        server.tail->next = &request;
+    } else {
+        server.head = &request;
+    }
+    server.tail = &request;
+    pthread_cond_signal(&server.queued);
+    while (!request.done) {
+        pthread_cond_wait(&server.applied, &server.queueLock);
+    }
+    pthread_mutex_unlock(&server.queueLock);
+    return request.status;
+}
+
+// Function 206: Writer thread: apply every queued write under one exclusive lock, then commit them together
+void *serverWriterMain(void *argument) {
+    ServerWrite *batch, *request;
+    int durable;
+    long count;
+
+    (void)argument;
+    pthread_mutex_lock(&server.queueLock);
+    while (1) {
+        while (server.head == NULL && !server.stopping) {
+            pthread_cond_wait(&server.queued, &server.queueLock);
+        }
+        if (server.head == NULL) {
+            break;
+        }
+        batch = server.head;
+        server.head = server.tail = NULL;
+        pthread_mutex_unlock(&server.queueLock);
+
+        // Readers see either none or all of a batch
+        pthread_rwlock_wrlock(&server.lock);
+        for (request = batch, count = 0; request != NULL; request = request->next, count++) {
+            request->status = runBatchCommand(request->session, request->line);
+        }
+        server.exclusiveReads = !prepareForReaders(server.table);
+        pthread_rwlock_unlock(&server.lock);
+        durable = journalSync();
+
+        pthread_mutex_lock(&server.queueLock);
+        server.batches++;
+        server.writes += count;
+        for (request = batch; request != NULL; request = request->next) {
+            if (!durable && request->status == BATCH_OK) {
+                request->status = batchError(request->session, "change applied but not journaled");
+            }
+            request->done = 1;
+        }
+        pthread_cond_broadcast(&server.applied);
+    }
+    pthread_mutex_unlock(&server.queueLock);
+    return NULL;
+}
+
+// Function 207: Build every cache a query may look at, so concurrent readers only ever read the table
+int prepareForReaders(StudentTable *table) {
+    int kind, j;
+
+    if (table->count <= 0) {
+        return 1;
+    }
+    for (kind = 0; kind < VIEW_COUNT; kind++) {
+        if (getSortedView(table, kind) == NULL) return 0;
+    }
+    if (table->idIndex.slots == NULL && !buildIdIndex(table, table->count)) {
+        return 0;
+    }
+    for (j = 0; j < table->courseCount + 2; j++) {
+        if (getRangeIndex(table, j) == NULL) return 0;
+    }
+    for (j = 0; j < table->courseCount; j++) {
+        if (getDistribution(table, j) == NULL) return 0;
+    }
+    return getDistribution(table, RANK_BY_TOTAL) != NULL;
+}
+
+// Function 208: The ok or error line that ends every batch command's results
+void writeBatchStatus(BatchSession *session, int status) {
+    if (status == BATCH_OK) {
+        fprintf(session->out, "ok\t%ld\n", session->rows);
+    } else {
+        fprintf(session->out, "error\t%s\n", session->error);
+    }
+}
+
+// Function 209: Connect to a server's socket; returns the descriptor or -1
+int connectServer(const char *socketPath) {
+    struct sockaddr_un address;
+    int fd;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path) || (fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        return -1;
+    }
+    strcpy(address.sun_path, socketPath);
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Function 210: Send batch commands to a server and copy its results out; returns how many failed
+long runClient(const char *socketPath, FILE *in, FILE *out) {
+    char line[BATCH_LINE_LEN];
+    long failures = 0;
+    size_t length;
+    int fd, status;
+    FILE *replies;
+
+    if ((fd = connectServer(socketPath)) < 0 || (replies = fdopen(fd, "r")) == NULL) {
+        fprintf(stderr, "ERROR: Cannot connect to '%s'.\n", socketPath);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), in) != NULL) {
+        length = strcspn(line, "\r\n");
+        line[length] = '\0';
+        // The server sends nothing back for blank lines and comments
+        if (line[strspn(line, " \t")] == '\0' || line[strspn(line, " \t")] == '#') {
+            continue;
+        }
+        line[length] = '\n';
+        if (!writeAll(fd, line, length + 1)) {
+            break;
+        }
+        line[length] = '\0';
+        if (strcmp(line, "quit") == 0 || strcmp(line, "exit") == 0) {
+            break;
+        }
+        if ((status = readServerReply(replies, out)) < 0) {
+            fprintf(stderr, "ERROR: The server closed the connection.\n");
+            failures++;
+            break;
+        }
+        failures += status == BATCH_FAILED;
+    }
+    fclose(replies);
+    return failures;
+}
+
+// Function 211: Copy one command's result lines (out may be NULL); BATCH_OK, BATCH_FAILED or -1 if cut off
+int readServerReply(FILE *replies, FILE *out) {
+    char line[BATCH_LINE_LEN * 4];
+
+    while (fgets(line, sizeof(line), replies) != NULL) {
+        if (out != NULL) {
+            fputs(line, out);
+        }
+        if (strncmp(line, "ok\t", 3) == 0) {
+            return BATCH_OK;
+        }
+        if (strncmp(line, "error\t", 6) == 0) {
+            return BATCH_FAILED;
+        }
+    }
+    return -1;
+}
+
+// Function 212: Drive a server from many connections at once and report queries per second and latency
+int runLoadGenerator(const char *socketPath, int clientCount, double seconds, int writePercent, uint64_t seed) {
+    LoadClient *clients;
+    OperationStats reads, writes;
+    char line[BATCH_LINE_LEN];
+    long studentCount = 0, errors = 0;
+    int courseCount = 0, fd, i, b, started = 0;
+    FILE *replies;
+
+    // The roster size decides which IDs and courses to ask about
+    if ((fd = connectServer(socketPath)) < 0 || (replies = fdopen(fd, "r")) == NULL) {
+        fprintf(stderr, "ERROR: Cannot connect to '%s'.\n", socketPath);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    if (!writeAll(fd, "count\n", 6) || fgets(line, sizeof(line), replies) == NULL ||
+        sscanf(line, "%ld\t%d", &studentCount, &courseCount) != 2 || courseCount <= 0 || studentCount <= 0) {
+        fprintf(stderr, "ERROR: The server has no data to query.\n");
+        fclose(replies);
+        return 0;
+    }
+    fclose(replies);
+
+    if ((clients = calloc(clientCount, sizeof(LoadClient))) == NULL) {
+        fprintf(stderr, "ERROR: Not enough memory.\n");
+        return 0;
+    }
+    for (i = 0; i < clientCount; i++) {
+        clients[i].socketPath = socketPath;
+        clients[i].seconds = seconds;
+        clients[i].writePercent = writePercent;
+        clients[i].seed = seed + i;
+        clients[i].studentCount = studentCount;
+        clients[i].courseCount = courseCount;
+        if (pthread_create(&clients[i].thread, NULL, loadClientMain, &clients[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+
+    memset(&reads, 0, sizeof(reads));
+    memset(&writes, 0, sizeof(writes));
+    for (i = 0; i < started; i++) {
+        pthread_join(clients[i].thread, NULL);
+        reads.calls += clients[i].reads.calls;
+        reads.nanos += clients[i].reads.nanos;
+        writes.calls += clients[i].writes.calls;
+        writes.nanos += clients[i].writes.nanos;
+        for (b = 0; b < LATENCY_BUCKETS; b++) {
+            reads.latency[b] += clients[i].reads.latency[b];
+            writes.latency[b] += clients[i].writes.latency[b];
+        }
+        errors += clients[i].errors;
+    }
+
+    printf("\n%d clients for %.1f s against '%s' (%ld students, %d%% writes)\n", started, seconds, socketPath,
+           studentCount, writePercent);
+    printf("%-8s %12s %12s %10s %10s\n", "kind", "queries", "per second", "p50 ms", "p99 ms");
+    printf("%-8s %12llu %12.0f %10.3f %10.3f\n", "reads", (unsigned long long)reads.calls, reads.calls / seconds,
+           latencyPercentile(&reads, 0.50) / 1e6, latencyPercentile(&reads, 0.99) / 1e6);
+    if (writes.calls > 0) {
+        printf("%-8s %12llu %12.0f %10.3f %10.3f\n", "writes", (unsigned long long)writes.calls,
+               writes.calls / seconds, latencyPercentile(&writes, 0.50) / 1e6, latencyPercentile(&writes, 0.99) / 1e6);
+    }
+    printf("%-8s %12llu %12.0f\n", "total", (unsigned long long)(reads.calls + writes.calls),
+           (reads.calls + writes.calls) / seconds);
+    if (errors > 0) {
+        printf("%ld commands failed.\n", errors);
+    }
+    free(clients);
+    return started == clientCount && errors == 0;
+}
+
+// Function 213: One load-generator connection: a mix of lookups, top-K, statistics and score updates
+void *loadClientMain(void *argument) {
+    LoadClient *client = argument;
+    struct timespec began, now;
+    char command[BATCH_LINE_LEN], name[MAX_NAME_LEN];
+    uint64_t state = client->seed, nanos;
+    OperationStats *stats;
+    long id;
+    int fd, pick, course, status, isWrite;
+    FILE *replies;
+
+    if ((fd = connectServer(client->socketPath)) < 0 || (replies = fdopen(fd, "r")) == NULL) {
+        if (fd >= 0) close(fd);
+        client->errors++;
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    while (elapsedSeconds(&began) < client->seconds) {
+        id = MIN_STUDENT_ID + (long)(nextRandom(&state) % (uint64_t)client->studentCount);
+        course = 1 + (int)(nextRandom(&state) % (uint64_t)client->courseCount);
+        pick = (int)(nextRandom(&state) % 100);
+        isWrite = pick < client->writePercent;
+        if (isWrite) {
+            snprintf(command, sizeof(command), "update %ld %d %.1f\n", id, course,
+                     (double)(nextRandom(&state) % 1001) / 10);
+        } else if ((pick = (int)(nextRandom(&state) % 100)) < 40) {
+            snprintf(command, sizeof(command), "find id %ld\n", id);
+        } else if (pick < 60) {
+            randomStudentName(&state, name);
+            snprintf(command, sizeof(command), "find name %s\n", name);
+        } else if (pick < 75) {
+            snprintf(command, sizeof(command), "top 10 course %d\n", course);
+        } else if (pick < 85) {
+            snprintf(command, sizeof(command), "rank %ld\n", id);
+        } else if (pick < 95) {
+            snprintf(command, sizeof(command), "stats course %d\n", course);
+        } else {
+            snprintf(command, sizeof(command), "grades\n");
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (!writeAll(fd, command, strlen(command)) || (status = readServerReply(replies, NULL)) < 0) {
+            client->errors++;
+            break;
+        }
+        nanos = (uint64_t)(elapsedSeconds(&now) * 1e9);
+        stats = isWrite ? &client->writes : &client->reads;
+        stats->calls++;
+        stats->nanos += nanos;
+        stats->latency[latencyBucket(nanos)]++;
+        client->errors += status != BATCH_OK;
+    }
+    fclose(replies);
+    return NULL;
+}
+
+// Function 214: Bytes one stored score takes: a float, or a uint16_t count of tenths
+size_t scoreWidth(const StudentTable *table) {
+    return table->tenths ? sizeof(uint16_t) : sizeof(float);
+}
+
+// Function 215: One stored score as a float, whichever way the table keeps it
+float scoreAt(const StudentTable *table, int course, int row) {
+    if (table->tenths) {
+        return tenthsValue(((const uint16_t *)table->scores[course])[row]);
+    }
+    return ((const float *)table->scores[course])[row];
+}
+
+// Function 216: Store one score in the table's layout
+void setScore(StudentTable *table, int course, int row, float score) {
+    int tenths;
+
+    if (!table->tenths) {
+        ((float *)table->scores[course])[row] = score;
+        return;
+    }
+    // Entry points only accept one decimal; anything else (an old float-mode journal) is rounded
+    if ((tenths = scoreBin(score)) < 0) {
+        tenths = (score > 0) ? (score < 100 ? (int)lrintf(score * 10) : SCORE_BINS - 1) : 0;
+    }
+    ((uint16_t *)table->scores[course])[row] = (uint16_t)tenths;
+}
+
+// Function 217: Score of a count of tenths; the division is correctly rounded, so this is
+// exactly the float that "87.3" parses to and printing matches float storage
+float tenthsValue(int tenths) {
+    return (float)tenths / 10;
+}
+
+// Function 218: Total of one row of a tenths table, summed as integers so it never drifts
+float tenthsTotal(const StudentTable *table, int row) {
+    int sum = 0, j;
+
+    for (j = 0; j < table->courseCount; j++) {
+        sum += ((const uint16_t *)table->scores[j])[row];
+    }
+    return tenthsValue(sum);
+}
+
+// Function 219: Count how often each score occurs in a tenths column; four count arrays
+// keep runs of equal scores from waiting on one counter
+void countTenths(const uint16_t *column, int n, long *counts) {
+    uint32_t lanes[4][SCORE_BINS];
+    int i, t, vectorEnd = n & ~3;
+
+    memset(lanes, 0, sizeof(lanes));
+    for (i = 0; i < vectorEnd; i += 4) {
+        lanes[0][column[i]]++;
+        lanes[1][column[i + 1]]++;
+        lanes[2][column[i + 2]]++;
+        lanes[3][column[i + 3]]++;
+    }
+    for (; i < n; i++) {
+        lanes[0][column[i]]++;
+    }
+    for (t = 0; t < SCORE_BINS; t++) {
+        counts[t] = (long)lanes[0][t] + lanes[1][t] + lanes[2][t] + lanes[3][t];
+    }
+}
+
+// Function 220: Aggregate a tenths column from its score counts; each distinct score is
+// converted once and weighted by its count, so the sums equal the float kernels' exactly
+void aggregateTenths(const uint16_t *column, int n, CourseAggregate *aggregate) {
+    long counts[SCORE_BINS];
+    int t;
+
+    countTenths(column, n, counts);
+    memset(aggregate, 0, sizeof(*aggregate));
+    aggregate->lowest = 100;
+    aggregate->highest = 0;
+
+    for (t = 0; t < SCORE_BINS; t++) {
+        float score = tenthsValue(t);
+
+        if (counts[t] == 0) continue;
+        aggregate->sum += counts[t] * scoreToFixed(score);
+        aggregate->sumSquares += counts[t] * squareToFixed(score);
+        aggregate->bands[gradeBand(score)] += counts[t];
+        if (aggregate->count == 0) {
+            aggregate->lowest = score;
+            aggregate->lowestCount = counts[t];
+        }
+        aggregate->highest = score;
+        aggregate->highestCount = counts[t];
+        aggregate->count += counts[t];
+    }
+}
+
+// Function 221: Slot of a field's range index: courses first, then the total and the average
+int rangeSlot(const StudentTable *table, int field) {
+    if (field == RANK_BY_TOTAL) return table->courseCount;
+    if (field == RANGE_BY_AVERAGE) return table->courseCount + 1;
+    return field;
+}
+
+// Function 222: Sort key of a row's value in one range index slot
+uint32_t rangeKey(const StudentTable *table, int slot, int row) {
+    if (slot == table->courseCount + 1) {
+        return floatSortKey(table->averages[row]);
+    }
+    return floatSortKey(rankingScore(table, slot < table->courseCount ? slot : RANK_BY_TOTAL, row));
+}
+
+// Function 223: A range index kept in value order, rebuilt only if the table changed since; rows
+// changed one at a time since the last read are merged in
+const RangeIndex *getRangeIndex(StudentTable *table, int slot) {
+    RangeIndex *index;
+    uint64_t *keys;
+    uint32_t *sortedKeys;
+    int *rows, i, n = table->count, ok;
+
+    if (table->ranges == NULL &&
+        (table->ranges = calloc(table->courseCount + 2, sizeof(RangeIndex))) == NULL) {
+        return NULL;
+    }
+    index = &table->ranges[slot];
+    if (index->rows != NULL && index->version == table->version) {
+        if (index->pending.count == 0 || mergePendingRangeRows(table, slot)) {
+            return index;
+        }
+        index->version = table->version - 1;    // Half merged: no longer current, so rebuild below
+    }
+
+    index->pending.count = 0;
+    if ((rows = realloc(index->rows, (n > 0 ? n : 1) * sizeof(int))) == NULL) {
+        return NULL;
+    }
+    index->rows = rows;
+    if ((sortedKeys = realloc(index->keys, (n > 0 ? n : 1) * sizeof(uint32_t))) == NULL) {
+        return NULL;
+    }
+    index->keys = sortedKeys;
+    if ((keys = malloc((n > 0 ? n : 1) * sizeof(uint64_t))) == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < n; i++) {
+        rows[i] = i;
+        keys[i] = rangeKey(table, slot, i);
+    }
+    // The radix sort is stable, so equal values stay in row order
+    ok = radixSortRows(keys, rows, n, 4);
+    free(keys);
+    if (!ok) {
+        return NULL;
+    }
+    for (i = 0; i < n; i++) {
+        sortedKeys[i] = rangeKey(table, slot, rows[i]);
+    }
+    index->entries = n;
+    index->version = table->version;
+    return index;
+}
+
+// Function 224: Bit mask of the range index slots that are up to date with the table
+uint64_t currentRangeIndexes(const StudentTable *table) {
+    uint64_t mask = 0;
+    int slot;
+
+    for (slot = 0; table->ranges != NULL && slot < table->courseCount + 2; slot++) {
+        if (table->ranges[slot].rows != NULL && table->ranges[slot].version == table->version) {
+            mask |= 1ULL << slot;
+        }
+    }
+    return mask;
+}
+
+// Function 225: After a one-row change, queue the row for the affected range indexes to re-place on
+// their next read, and mark every index that was current before the change as current again
+void refreshRangeIndexes(StudentTable *table, uint64_t current, uint64_t affected, int row) {
+    int slot;
+
+    for (slot = 0; slot < table->courseCount + 2; slot++) {
+        if (!(current & (1ULL << slot))) {
+            continue;
+        }
+        if ((affected & (1ULL << slot)) && !queuePendingRow(&table->ranges[slot].pending, row, table->count)) {
+            continue;       // Too many changes or out of memory: the index is rebuilt when next used
+        }
+        table->ranges[slot].version = table->version;
+    }
+}
+
+// Function 226: First of n entries that does not sort before (key, row) (binary search)
+int rangeEntryPosition(const RangeIndex *index, uint32_t key, int row, int n) {
+    int lo = 0, hi = n, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (index->keys[mid] < key || (index->keys[mid] == key && index->rows[mid] < row)) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+// Function 227: Merge a range index's pending rows the way views merge theirs, moving each key
+// with its row
+int mergePendingRangeRows(StudentTable *table, int slot) {
+    RangeIndex *index = &table->ranges[slot];
+    uint64_t *changed, *sortKeys;
+    uint32_t *keys, key;
+    int *rows, *fresh, n = table->count, kept = 0, count, end, position, row, i, ok;
+
+    if ((count = settlePendingRows(&index->pending, n, &changed)) < 0) {
+        return 0;
+    }
+    for (i = 0; i < index->entries; i++) {
+        row = index->rows[i];
+        if (row < n && !(changed[row / 64] & (1ULL << (row % 64)))) {
+            index->keys[kept] = index->keys[i];
+            index->rows[kept++] = row;
+        }
+    }
+    free(changed);
+    index->entries = kept;
+
+    if ((rows = realloc(index->rows, (n > 0 ? n : 1) * sizeof(int))) == NULL) {
+        return 0;
+    }
+    index->rows = rows;
+    if ((keys = realloc(index->keys, (n > 0 ? n : 1) * sizeof(uint32_t))) == NULL) {
+        return 0;
+    }
+    index->keys = keys;
+    fresh = index->pending.rows;
+    if ((sortKeys = malloc((count > 0 ? count : 1) * sizeof(uint64_t))) == NULL) {
+        return 0;
+    }
+    for (i = 0; i < count; i++) {
+        sortKeys[i] = rangeKey(table, slot, fresh[i]);
+    }
+    ok = radixSortRows(sortKeys, fresh, count, 4);
+    free(sortKeys);
+    if (!ok) {
+        return 0;
+    }
+    for (end = kept, i = count - 1; i >= 0; i--) {
+        key = rangeKey(table, slot, fresh[i]);
+        position = rangeEntryPosition(index, key, fresh[i], end);
+        memmove(rows + position + i + 1, rows + position, (end - position) * sizeof(int));
+        memmove(keys + position + i + 1, keys + position, (end - position) * sizeof(uint32_t));
+        rows[position + i] = fresh[i];
+        keys[position + i] = key;
+        end = position;
+    }
+    index->entries = n;
+    return 1;
+}
+
+// Function 228: Turn a pending list into its distinct rows below n in ascending order, plus a bitmap
+// of those rows; returns how many, or -1 when memory runs out. The list is empty afterwards, though
+// its rows stay readable until the next change
+int settlePendingRows(PendingRows *pending, int n, uint64_t **changed) {
+    uint64_t *bits, word;
+    int words = (n + 63) / 64, count = 0, row, i;
+
+    if ((bits = calloc(words > 0 ? words : 1, sizeof(uint64_t))) == NULL) {
+        return -1;
+    }
+    for (i = 0; i < pending->count; i++) {
+        row = pending->rows[i];
+        if (row < n) bits[row / 64] |= 1ULL << (row % 64);
+    }
+    // Reading the bitmap back a word at a time yields each row once, lowest first
+    for (i = 0; i < words; i++) {
+        for (word = bits[i]; word != 0; word &= word - 1) {
+            pending->rows[count++] = i * 64 + __builtin_ctzll(word);
+        }
+    }
+    pending->count = 0;
+    *changed = bits;
+    return count;
+}
+
+// Function 229: Entries [first, last) of a range index whose keys lie in [lowKey, highKey]
+void findRangeEntries(const RangeIndex *index, int n, uint32_t lowKey, uint32_t highKey, int *first, int *last) {
+    *first = rangeEntryPosition(index, lowKey, INT_MIN, n);
+    *last = highKey == UINT32_MAX ? n : rangeEntryPosition(index, highKey + 1, INT_MIN, n);
+    if (*last < *first) *last = *first;
+}
+
+// Function 230: Parse "FIELD OP VALUE [and FIELD OP VALUE]..." where FIELD is a course number, total,
+// average or any (any course) and OP is <, <=, =, >= or >; conditions on one field are merged
+int parseRangeQuery(const StudentTable *table, char **words, int wordCount, RangeQuery *query, const char **reason) {
+    RangeCondition *condition;
+    uint32_t key, low, high;
+    float value;
+    char *stop;
+    int i, c, field;
+
+    query->count = 0;
+    if (wordCount < 3 || (wordCount + 1) % 4 != 0) {
+        *reason = "expected FIELD OP VALUE, more joined with 'and'";
+        return 0;
+    }
+    for (i = 0; i < wordCount; i += 4) {
+        if (i > 0 && strcmp(words[i - 1], "and") != 0) {
+            *reason = "conditions must be joined with 'and'";
+            return 0;
+        }
+        if (strcmp(words[i], "total") == 0) {
+            field = RANK_BY_TOTAL;
+        } else if (strcmp(words[i], "average") == 0) {
+            field = RANGE_BY_AVERAGE;
+        } else if (strcmp(words[i], "any") == 0) {
+            field = RANGE_ANY_COURSE;
+        } else if ((field = atoi(words[i]) - 1) < 0 || field >= table->courseCount) {
+            *reason = "field must be total, average, any or a course number";
+            return 0;
+        }
+        value = strtof(words[i + 2], &stop);
+        if (stop == words[i + 2] || *stop != '\0' || !isfinite(value)) {
+            *reason = "invalid value";
+            return 0;
+        }
+
+        // Every operator becomes an inclusive key interval; low > high matches nothing
+        key = floatSortKey(value);
+        low = 0;
+        high = UINT32_MAX;
+        if (strcmp(words[i + 1], "<") == 0) {
+            if (key == 0) low = 1, high = 0; else high = key - 1;
+        } else if (strcmp(words[i + 1], "<=") == 0) {
+            high = key;
+        } else if (strcmp(words[i + 1], "=") == 0) {
+            low = high = key;
+        } else if (strcmp(words[i + 1], ">=") == 0) {
+            low = key;
+        } else if (strcmp(words[i + 1], ">") == 0) {
+            if (key == UINT32_MAX) low = 1, high = 0; else low = key + 1;
+        } else {
+            *reason = "operator must be <, <=, =, >= or >";
+            return 0;
+        }
+
+        for (c = 0; c < query->count && query->conditions[c].field != field; c++) {}
+        if (c == query->count) {
+            if (query->count == MAX_RANGE_CONDITIONS) {
+                *reason = "too many conditions";
+                return 0;
+            }
+            query->conditions[c].field = field;
+            query->conditions[c].lowKey = 0;
+            query->conditions[c].highKey = UINT32_MAX;
+            query->count++;
+        }
+        condition = &query->conditions[c];
+        if (low > condition->lowKey) condition->lowKey = low;
+        if (high < condition->highKey) condition->highKey = high;
+    }
+    return 1;
+}
+
+// Function 231: Whether a row meets one condition, read straight from its columns
+int rowMatchesCondition(const StudentTable *table, const RangeCondition *condition, int row) {
+    uint32_t key;
+    int j;
+
+    if (condition->field == RANGE_ANY_COURSE) {
+        for (j = 0; j < table->courseCount; j++) {
+            key = rangeKey(table, j, row);
+            if (key >= condition->lowKey && key <= condition->highKey) return 1;
+        }
+        return 0;
+    }
+    key = rangeKey(table, rangeSlot(table, condition->field), row);
+    return key >= condition->lowKey && key <= condition->highKey;
+}
+
+// Function 232: Rows meeting every condition of a query, ordered by ID; returns how many, or -1
+// when memory runs out. Only the condition with the fewest index entries is walked and the others
+// are checked on its rows, so the work follows the smallest range rather than the roster
+long runRangeQuery(StudentTable *table, const RangeQuery *query, int **matches) {
+    const RangeIndex *index;
+    const RangeCondition *condition;
+    long sizes[MAX_RANGE_CONDITIONS], found = 0;
+    uint64_t *seen = NULL, *keys;
+    int c, slot, firstSlot, lastSlot, first, last, i, row, driver = 0, *rows;
+
+    *matches = NULL;
+    for (c = 0; c < query->count; c++) {
+        condition = &query->conditions[c];
+        firstSlot = condition->field == RANGE_ANY_COURSE ? 0 : rangeSlot(table, condition->field);
+        lastSlot = condition->field == RANGE_ANY_COURSE ? table->courseCount : firstSlot + 1;
+        sizes[c] = 0;
+        for (slot = firstSlot; slot < lastSlot && condition->lowKey <= condition->highKey; slot++) {
+            if ((index = getRangeIndex(table, slot)) == NULL) {
+                return -1;
+            }
+            findRangeEntries(index, table->count, condition->lowKey, condition->highKey, &first, &last);
+            sizes[c] += last - first;
+        }
+        if (sizes[c] < sizes[driver]) driver = c;
+    }
+
+    if ((rows = malloc((sizes[driver] > 0 ? sizes[driver] : 1) * sizeof(int))) == NULL) {
+        return -1;
+    }
+    condition = &query->conditions[driver];
+    firstSlot = condition->field == RANGE_ANY_COURSE ? 0 : rangeSlot(table, condition->field);
+    lastSlot = condition->field == RANGE_ANY_COURSE ? table->courseCount : firstSlot + 1;
+    // A row can be in the range of several courses; a bitmap of rows already taken drops repeats
+    if (lastSlot - firstSlot > 1 && sizes[driver] > 0 &&
+        (seen = calloc((table->count + 63) / 64, sizeof(uint64_t))) == NULL) {
+        free(rows);
+        return -1;
+    }
+    for (slot = firstSlot; slot < lastSlot && sizes[driver] > 0; slot++) {
+        index = &table->ranges[slot];
+        findRangeEntries(index, table->count, condition->lowKey, condition->highKey, &first, &last);
+        for (i = first; i < last; i++) {
+            row = index->rows[i];
+            if (seen != NULL) {
+                if (seen[row / 64] & (1ULL << (row % 64))) continue;
+                seen[row / 64] |= 1ULL << (row % 64);
+            }
+            for (c = 0; c < query->count && (c == driver || rowMatchesCondition(table, &query->conditions[c], row)); c++) {}
+            if (c == query->count) {
+                rows[found++] = row;
+            }
+        }
+    }
+    free(seen);
+
+    if (found > 1) {
+        if ((keys = malloc(found * sizeof(uint64_t))) == NULL) {
+            free(rows);
+            return -1;
+        }
+        for (i = 0; i < found; i++) {
+            keys[i] = (uint64_t)table->ids[rows[i]] ^ 0x8000000000000000ULL;
+        }
+        if (!radixSortRows(keys, rows, (int)found, 8)) {
+            free(keys);
+            free(rows);
+            return -1;
+        }
+        free(keys);
+    }
+    *matches = rows;
+    return found;
+}
+
+// Function 233: where FIELD OP VALUE [and ...]: every record meeting all the conditions, by ID
+int batchWhere(BatchSession *session, char **args, int argCount) {
+    RangeQuery query;
+    const char *reason;
+    long found, i;
+    int *rows;
+
+    if (!parseRangeQuery(session->table, args, argCount, &query, &reason)) {
+        return batchError(session, "%s", reason);
+    }
+    if ((found = runRangeQuery(session->table, &query, &rows)) < 0) {
+        return batchError(session, "not enough memory to search");
+    }
+    for (i = 0; i < found; i++) {
+        writeBatchRecord(session, rows[i]);
+    }
+    free(rows);
+    return BATCH_OK;
+}
+
+// Function 234: Find students by score ranges, e.g. "total >= 300 and total <= 350" or "any >= 90"
+void showRangeQuery(StudentTable *table) {
+    char line[BATCH_LINE_LEN], *words[BATCH_MAX_ARGS], *cursor = line, *buffer, *out;
+    const char *reason;
+    RangeQuery query;
+    int wordCount = 0, *rows;
+    long found, i;
+
+    printf("\nConditions joined with 'and', on total, average, any or a course number (1-%d),\n",
+           table->courseCount);
+    printf("e.g. total >= 300 and total <= 350, 4 < 60, any >= 90: ");
+    clearInputBuffer();
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        return;
+    }
+    while (wordCount < BATCH_MAX_ARGS) {
+        while (*cursor == ' ' || *cursor == '\t' || *cursor == '\n') cursor++;
+        if (*cursor == '\0') break;
+        words[wordCount++] = cursor;
+        while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t' && *cursor != '\n') cursor++;
+        if (*cursor != '\0') *cursor++ = '\0';
+    }
+    if (!parseRangeQuery(table, words, wordCount, &query, &reason)) {
+        printf("\nERROR: %s.\n", reason);
+        return;
+    }
+    if ((found = runRangeQuery(table, &query, &rows)) < 0 || (buffer = malloc(RENDER_BUFFER_SIZE)) == NULL) {
+        if (found >= 0) free(rows);
+        printf("\nERROR: Not enough memory.\n");
+        return;
+    }
+
+    printf("\n");
+    printListingHeader(table, &listingOptions);
+    out = buffer;
+    for (i = 0; i < found; i++) {
+        out = renderStudentRow(table, &listingOptions, rows[i], out);
+        if (out - buffer > RENDER_BUFFER_SIZE - RENDER_ROW_MAX) {
+            fwrite(buffer, 1, out - buffer, stdout);
+            out = buffer;
+        }
+    }
+    fwrite(buffer, 1, out - buffer, stdout);
+    printf("Matching Students: %ld of %d\n", found, table->count);
+    free(buffer);
+    free(rows);
+}
+
+// Function 235: Column titles and rules of a student listing
+void printListingHeader(const StudentTable *table, const ListingOptions *options) {
+    int j;
+
+    if (showListingColumn(options, COLUMN_ID)) printf("Student ID    ");
+    if (showListingColumn(options, COLUMN_NAME)) printf("Student Name         ");
+    for (j = 0; j < table->courseCount; j++) {
+        if (showListingColumn(options, j)) printf("Course %-2d  ", j + 1);
+    }
+    if (showListingColumn(options, COLUMN_TOTAL)) printf("   Total  ");
+    if (showListingColumn(options, COLUMN_AVERAGE)) printf("   Average");
+    printf("\n");
+
+    if (showListingColumn(options, COLUMN_ID)) printf("------------  ");
+    if (showListingColumn(options, COLUMN_NAME)) printf("-------------------- ");
+    for (j = 0; j < table->courseCount; j++) {
+        if (showListingColumn(options, j)) printf("---------- ");
+    }
+    if (showListingColumn(options, COLUMN_TOTAL)) printf("  ---------");
+    if (showListingColumn(options, COLUMN_AVERAGE)) printf("  ---------");
+    printf("\n");
+}
+
+// Function 236: Debug self-check: every current range index, once its pending rows are merged,
+// holds each row once, in value order
+int verifyRangeIndexes(StudentTable *table) {
+    const RangeIndex *index;
+    int slot, i, row;
+
+    for (slot = 0; table->ranges != NULL && slot < table->courseCount + 2; slot++) {
+        index = &table->ranges[slot];
+        if (index->rows == NULL || index->version != table->version || (index = getRangeIndex(table, slot)) == NULL) {
+            continue;
+        }
+        // Strictly increasing (key, row) pairs whose keys match their rows cannot repeat a row
+        for (i = 0; i < table->count; i++) {
+            row = index->rows[i];
+            if (row < 0 || row >= table->count || index->keys[i] != rangeKey(table, slot, row) ||
+                (i > 0 && (index->keys[i] < index->keys[i - 1] ||
+                           (index->keys[i] == index->keys[i - 1] && row <= index->rows[i - 1])))) {
+                printf("\nSELF-CHECK FAILED: range index %d is out of order at entry %d.\n", slot, i);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Function 237: Fold one score into a course aggregate
+void addScoreToAggregate(CourseAggregate *course, float score) {
+    course->sum += scoreToFixed(score);
+    course->sumSquares += squareToFixed(score);
+    course->bands[gradeBand(score)]++;
+
+    if (course->count == 0 || score < course->lowest) {
+        course->lowest = score;
+        course->lowestCount = 1;
+    } else if (score == course->lowest) {
+        course->lowestCount++;
+    }
+    if (course->count == 0 || score > course->highest) {
+        course->highest = score;
+        course->highestCount = 1;
+    } else if (score == course->highest) {
+        course->highestCount++;
+    }
+    course->count++;
+}
+
+// Function 238: Statistics lines of one course in the course report
+void printCourseSummary(int course, const CourseAggregate *aggregate, const Distribution *distribution) {
+    double total = aggregate->sum / SCORE_FIXED_ONE;
+
+    printf("\nCourse %d:\n", course + 1);
+    printf("  Average Score: %.2f\n", total / aggregate->count);
+    printf("  Highest Score: %.2f\n", aggregate->highest);
+    printf("  Lowest Score:  %.2f\n", aggregate->lowest);
+    printf("  Total Score:   %.2f\n", total);
+    printDistribution(distribution);
+}
+
+// Function 239: Write one score as an export field: shortest form that reads back exactly
+void writeScoreField(FILE *file, float score) {
+    char field[32];
+
+    snprintf(field, sizeof(field), "%g", score);
+    if (strtof(field, NULL) != score) {
+        snprintf(field, sizeof(field), "%.9g", score);
+    }
+    fprintf(file, ",%s", field);
+}
+
+// Function 240: Parse a memory size: bytes with an optional K, M or G suffix; -1 if malformed
+long parseMemorySize(const char *text) {
+    char *stop;
+    long value = strtol(text, &stop, 10);
+    int shift = 0;
+
+    if (stop == text || value <= 0) {
+        return -1;
+    }
+    switch (toupper((unsigned char)*stop)) {
+        case 'K': shift = 10; stop++; break;
+        case 'M': shift = 20; stop++; break;
+        case 'G': shift = 30; stop++; break;
+        default: break;
+    }
+    if (*stop != '\0' || value > (LONG_MAX >> shift)) {
+        return -1;
+    }
+    return value << shift;
+}
+
+// Function 241: Next line of a CSV file without its line ending: 1, 0 at the end of the file,
+// or -1 for a line longer than the buffer (its bytes are skipped)
+int readCsvLine(CsvLineReader *reader, char **line, char **end) {
+    char *start, *stop, *newline;
+    size_t got;
+
+    for (;;) {
+        start = reader->buffer + reader->start;
+        stop = reader->buffer + reader->used;
+        newline = memchr(start, '\n', stop - start);
+        if (newline != NULL || (reader->atEof && start < stop)) {
+            reader->start = (newline != NULL ? newline + 1 : stop) - reader->buffer;
+            if (newline == NULL) newline = stop;      // Last line without a trailing newline
+            if (newline > start && newline[-1] == '\r') newline--;
+            *line = start;
+            *end = newline;
+            reader->lines++;
+            if (reader->skipping) {
+                reader->skipping = 0;
+                return -1;
+            }
+            return 1;
+        }
+        if (reader->atEof) {
+            return 0;
+        }
+
+        // Keep the unfinished line and read more behind it
+        reader->used = stop - start;
+        memmove(reader->buffer, start, reader->used);
+        reader->start = 0;
+        if (reader->used == IMPORT_BUFFER_SIZE) {
+            reader->skipping = 1;                     // Drop the head of an over-long line
+            reader->used = 0;
+        }
+        got = fread(reader->buffer + reader->used, 1, IMPORT_BUFFER_SIZE - reader->used, reader->file);
+        reader->bytes += got;
+        reader->used += got;
+        reader->atEof = (got == 0);
+    }
+}
+
+// Function 242: Lay out a parsed student as a run record at out; returns its size
+size_t makeRunRecord(const ExternalJob *job, const Student *student, uint64_t sequence, RunRecord *out) {
+    size_t nameLength = runRecordTextLength(job, student), scoreBytes = job->courseCount * sizeof(float);
+    char *name = (char *)(out + 1) + scoreBytes, *text;
+    int a;
+
+    switch (job->order) {
+        case VIEW_TOTAL_DESC: out->key = ~floatSortKey(student->total); break;
+        case VIEW_TOTAL_ASC: out->key = floatSortKey(student->total); break;
+        case VIEW_ID: out->key = (uint64_t)student->id; break;
+        default: out->key = 0; break;
+    }
+    out->sequence = sequence;
+    out->id = student->id;
+    out->nameLength = (uint32_t)nameLength;
+    out->foldedLength = job->order == VIEW_NAME ? (uint32_t)strlen(student->name) : 0;
+    memcpy(out + 1, student->scores, scoreBytes);
+    // Attribute values ride along after the name, already joined as they are written out
+    text = stpcpy(name, student->name);
+    for (a = 0; a < job->attributeCount; a++) {
+        *text++ = ',';
+        text = stpcpy(text, student->attributes[a]);
+    }
+    foldName(student->name, out->foldedLength, name + nameLength);
+    out->size = (uint32_t)runRecordSize(job->courseCount, nameLength, out->foldedLength);
+    return out->size;
+}
+
+// Function 243: Bytes a run record takes, rounded up so the next record stays aligned
+size_t runRecordSize(int courseCount, size_t nameLength, size_t foldedLength) {
+    size_t size = sizeof(RunRecord) + courseCount * sizeof(float) + nameLength + foldedLength;
+    return (size + 7) & ~(size_t)7;
+}
+
+// Function 244: Order of two run records: key, then folded name, then input position like the stable sorts
+int compareRunRecords(const RunRecord *a, const RunRecord *b, int courseCount) {
+    const char *foldedA, *foldedB;
+    uint32_t common;
+    int order;
+
+    if (a->key != b->key) {
+        return a->key < b->key ? -1 : 1;
+    }
+    if (a->foldedLength > 0 || b->foldedLength > 0) {
+        foldedA = (const char *)(a + 1) + courseCount * sizeof(float) + a->nameLength;
+        foldedB = (const char *)(b + 1) + courseCount * sizeof(float) + b->nameLength;
+        common = a->foldedLength < b->foldedLength ? a->foldedLength : b->foldedLength;
+        if ((order = memcmp(foldedA, foldedB, common)) != 0) {
+            return order;
+        }
+        if (a->foldedLength != b->foldedLength) {
+            return a->foldedLength < b->foldedLength ? -1 : 1;
+        }
+    }
+    return (a->sequence > b->sequence) - (a->sequence < b->sequence);
+}
+
+// Function 245: qsort comparator for pointers to run records of the current job
+int compareRunPointers(const void *a, const void *b) {
+    return compareRunRecords(*(RunRecord *const *)a, *(RunRecord *const *)b, externalCourseCount);
+}
+
+// Function 246: Write a record to the sorted CSV output, or unchanged to a spill file
+int writeRunRecord(ExternalJob *job, const RunRecord *record, FILE *file, int asCsv) {
+    const float *scores = (const float *)(record + 1);
+    int j;
+
+    if (!asCsv) {
+        job->spillBytes += record->size;
+        return fwrite(record, record->size, 1, file) == 1;
+    }
+    fprintf(file, "%lld,%.*s", (long long)record->id, (int)record->nameLength,
+            (const char *)(scores + job->courseCount));
+    for (j = 0; j < job->courseCount; j++) {
+        writeScoreField(file, scores[j]);
+    }
+    return fputc('\n', file) != EOF;
+}
+
+// Function 247: Create an unnamed temporary file for runs; it disappears when closed, even after a crash
+FILE *openSpillFile(const char *directory, char *buffer) {
+    char path[1024];
+    FILE *file;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/student-sort-XXXXXX", directory);
+    if ((fd = mkstemp(path)) < 0) {
+        return NULL;
+    }
+    unlink(path);
+    if ((file = fdopen(fd, "w+b")) == NULL) {
+        close(fd);
+        return NULL;
+    }
+    setvbuf(file, buffer, _IOFBF, EXTERNAL_WRITE_BUFFER);
+    return file;
+}
+
+// Function 248: Sort the records gathered in memory and write them out as one run (or the whole
+// output, when they are all the input there is)
+int spillRun(ExternalJob *job, FILE *output) {
+    RunRecord **pointers = (RunRecord **)(job->arena + job->arenaSize) - job->arenaRecords;
+    FILE *file = output != NULL ? output : job->spill[0];
+    SortRun *grown;
+    size_t i;
+
+    externalCourseCount = job->courseCount;
+    qsort(pointers, job->arenaRecords, sizeof(RunRecord *), compareRunPointers);
+
+    if (output == NULL && job->runCount == job->runCapacity) {
+        job->runCapacity = job->runCapacity ? job->runCapacity * 2 : 64;
+        if ((grown = realloc(job->runs, job->runCapacity * sizeof(SortRun))) == NULL) {
+            printf("ERROR: Not enough memory.\n");
+            return 0;
+        }
+        job->runs = grown;
+    }
+    if (output == NULL) job->runs[job->runCount].start = job->spillBytes;
+    for (i = 0; i < job->arenaRecords; i++) {
+        if (!writeRunRecord(job, pointers[i], file, output != NULL)) {
+            printf("ERROR: Cannot write sorted records.\n");
+            return 0;
+        }
+    }
+    if (output == NULL) job->runs[job->runCount++].end = job->spillBytes;
+
+    job->arenaUsed = 0;
+    job->arenaRecords = 0;
+    return 1;
+}
+
+// Function 249: Make a run reader's next record whole in its buffer; current is NULL at the end of the run
+int loadRunRecord(RunReader *reader) {
+    size_t available = reader->used - reader->position, want;
+    const RunRecord *record = (const RunRecord *)(reader->buffer + reader->position);
+    ssize_t got;
+
+    if (available < sizeof(RunRecord) || available < record->size) {
+        // Move the partial record to the front and read the rest of the buffer from the run
+        memmove(reader->buffer, reader->buffer + reader->position, available);
+        reader->used = available;
+        reader->position = 0;
+        want = reader->capacity - reader->used;
+        if (want > reader->end - reader->next) want = reader->end - reader->next;
+        while (want > 0) {
+            if ((got = pread(reader->fd, reader->buffer + reader->used, want, (off_t)reader->next)) <= 0) {
+                return 0;
+            }
+            reader->used += got;
+            reader->next += got;
+            want -= got;
+        }
+        available = reader->used;
+        record = (const RunRecord *)reader->buffer;
+    }
+
+    if (available == 0) {
+        reader->current = NULL;
+        return 1;
+    }
+    if (available < sizeof(RunRecord) || record->size < sizeof(RunRecord) || record->size > available) {
+        return 0;
+    }
+    reader->current = record;
+    return 1;
+}
+
+// Function 250: Whether run a's current record comes before run b's; finished runs come last
+int runReaderBefore(const RunReader *readers, int a, int b, int courseCount) {
+    if (readers[a].current == NULL) return 0;
+    if (readers[b].current == NULL) return 1;
+    return compareRunRecords(readers[a].current, readers[b].current, courseCount) < 0;
+}
+
+// Function 251: Build a tournament (loser) tree over k runs: tree[0] holds the run with the smallest
+// record and tree[1..k-1] the loser of each match; leaf i sits at node k + i
+void buildTournament(int *tree, const RunReader *readers, int k, int courseCount) {
+    int leaf, node, winner, swap;
+
+    for (node = 1; node < k; node++) {
+        tree[node] = -1;
+    }
+    for (leaf = 0; leaf < k; leaf++) {
+        // The first run to reach a node waits there for the winner of the other subtree
+        winner = leaf;
+        for (node = (leaf + k) / 2; node > 0 && winner >= 0; node /= 2) {
+            if (tree[node] < 0) {
+                tree[node] = winner;
+                winner = -1;
+            } else if (runReaderBefore(readers, tree[node], winner, courseCount)) {
+                swap = tree[node];
+                tree[node] = winner;
+                winner = swap;
+            }
+        }
+        if (winner >= 0) {
+            tree[0] = winner;
+        }
+    }
+}
+
+// Function 252: Replay the matches from one leaf to the root after its run moved on, O(log k)
+void replayTournament(int *tree, const RunReader *readers, int k, int leaf, int courseCount) {
+    int node, winner = leaf, swap;
+
+    for (node = (leaf + k) / 2; node > 0; node /= 2) {
+        if (runReaderBefore(readers, tree[node], winner, courseCount)) {
+            swap = tree[node];
+            tree[node] = winner;
+            winner = swap;
+        }
+    }
+    tree[0] = winner;
+}
+
+// Function 253: Merge k runs of the current spill file into the sorted output or onto the other spill file
+int mergeRuns(ExternalJob *job, const SortRun *runs, int k, size_t bufferSize, FILE *to, int asCsv) {
+    RunReader *readers = calloc(k, sizeof(RunReader));
+    int *tree = malloc(k * sizeof(int));
+    int i, winner, ok = readers != NULL && tree != NULL;
+
+    for (i = 0; ok && i < k; i++) {
+        readers[i].fd = fileno(job->spill[0]);
+        readers[i].next = runs[i].start;
+        readers[i].end = runs[i].end;
+        readers[i].capacity = bufferSize;
+        ok = (readers[i].buffer = malloc(bufferSize)) != NULL;
+        if (ok && !loadRunRecord(&readers[i])) {
+            printf("ERROR: Cannot read a sorted run back.\n");
+            ok = 0;
+        }
+    }
+    if (ok) {
+        buildTournament(tree, readers, k, job->courseCount);
+        while (ok && readers[winner = tree[0]].current != NULL) {
+            if (!writeRunRecord(job, readers[winner].current, to, asCsv)) {
+                printf("ERROR: Cannot write sorted records.\n");
+                ok = 0;
+            } else {
+                readers[winner].position += readers[winner].current->size;
+                if (!loadRunRecord(&readers[winner])) {
+                    printf("ERROR: Cannot read a sorted run back.\n");
+                    ok = 0;
+                }
+                replayTournament(tree, readers, k, winner, job->courseCount);
+            }
+        }
+    } else if (readers == NULL || tree == NULL) {
+        printf("ERROR: Not enough memory.\n");
+    }
+
+    for (i = 0; readers != NULL && i < k; i++) {
+        free(readers[i].buffer);
+    }
+    free(readers);
+    free(tree);
+    return ok;
+}
+
+// Function 254: Merge every run into the output, in extra passes between the two spill files while
+// there are more runs than read buffers fit in the memory limit
+int mergeAllRuns(ExternalJob *job, FILE *output) {
+    size_t budget = job->memoryLimit - EXTERNAL_RESERVED, bufferSize;
+    int fanIn, group, next, count;
+    FILE *swap;
+
+    for (;;) {
+        bufferSize = budget / (job->runCount + 1);
+        if (bufferSize < EXTERNAL_MIN_BUFFER) bufferSize = EXTERNAL_MIN_BUFFER;
+        fanIn = (int)(budget / bufferSize) - 1;
+        if (fanIn < 2) fanIn = 2;
+        if (fflush(job->spill[0]) != 0) {
+            printf("ERROR: Cannot write sorted records.\n");
+            return 0;
+        }
+        if (job->runCount <= fanIn) {
+            return mergeRuns(job, job->runs, job->runCount, bufferSize, output, 1);
+        }
+
+        // Each group of fanIn runs becomes one longer run in the other spill file
+        job->passes++;
+        if (ftruncate(fileno(job->spill[1]), 0) != 0 || fseeko(job->spill[1], 0, SEEK_SET) != 0) {
+            printf("ERROR: Cannot write sorted records.\n");
+            return 0;
+        }
+        job->spillBytes = 0;
+        for (group = 0, next = 0; group < job->runCount; group += fanIn, next++) {
+            count = job->runCount - group < fanIn ? job->runCount - group : fanIn;
+            uint64_t start = job->spillBytes;
+            if (!mergeRuns(job, job->runs + group, count, bufferSize, job->spill[1], 0)) {
+                return 0;
+            }
+            job->runs[next].start = start;
+            job->runs[next].end = job->spillBytes;
+        }
+        job->runCount = next;
+        swap = job->spill[0];
+        job->spill[0] = job->spill[1];
+        job->spill[1] = swap;
+    }
+}
+
+// Function 255: Course report over the streamed rows, laid out like menu option 3
+void printExternalStatistics(const ExternalJob *job) {
+    const Distribution *totals = &job->distributions[job->courseCount];
+    int j;
+
+    printf("\n============================================\n");
+    printf("            COURSE STATISTICS\n");
+    printf("============================================\n");
+    for (j = 0; j < job->courseCount; j++) {
+        printCourseSummary(j, &job->aggregates[j], &job->distributions[j]);
+    }
+    printf("\nTotal Score per Student:\n");
+    printf("  Average Score: %.2f\n", totals->sum / DISTRIBUTION_SUM_ONE / totals->count);
+    printDistribution(totals);
+}
+
+// Function 256: Out-of-core mode: stream a CSV roster once in bounded memory, sorting it into
+// outputPath with sorted runs and a k-way merge (order VIEW_COUNT skips sorting) and/or
+// gathering course statistics; bad rows go to the reject report
+int runExternalJob(const char *inputPath, const char *outputPath, ViewKind order, int withStats,
+                   size_t memoryLimit, const char *tempDir, const char *rejectPath) {
+    ExternalJob job;
+    CsvLineReader reader;
+    StudentTable shape;
+    Student student;
+    FILE *output = NULL, *rejects = NULL;
+    char *line, *end, *writeBuffers[3] = {NULL, NULL, NULL};
+    const char *reason;
+    size_t size, reserve;
+    struct timespec began;
+    int status, j, tenths, runs = 0, ok = 1;
+    double seconds;
+
+    memset(&job, 0, sizeof(job));
+    memset(&reader, 0, sizeof(reader));
+    memset(&shape, 0, sizeof(shape));
+    job.order = order;
+    job.memoryLimit = memoryLimit;
+    job.attributeCount = shape.attributeCount = attributeSchemaCount;
+    shape.tenths = compactScores;
+    clock_gettime(CLOCK_MONOTONIC, &began);
+
+    if ((reader.file = fopen(inputPath, "rb")) == NULL) {
+        printf("ERROR: Cannot open '%s'.\n", inputPath);
+        return 0;
+    }
+    if ((reader.buffer = malloc(IMPORT_BUFFER_SIZE)) == NULL) {
+        printf("ERROR: Not enough memory.\n");
+        fclose(reader.file);
+        return 0;
+    }
+
+    while (ok && (status = readCsvLine(&reader, &line, &end)) != 0) {
+        reason = NULL;
+        if (status < 0) {
+            reason = "line is too long";
+        } else if (line == end) {
+            continue;
+        } else if (job.courseCount == 0) {
+            // The first line sets the course count, as in --import
+            job.courseCount = countCsvFields(line, end) - 2 - job.attributeCount;
+            if (job.courseCount < 1 || job.courseCount > MAX_COURSES) {
+                printf("ERROR: '%s' must have between 1 and %d course columns.\n", inputPath, MAX_COURSES);
+                ok = 0;
+                break;
+            }
+            shape.courseCount = job.courseCount;
+            if (withStats) {
+                ok = (job.aggregates = calloc(job.courseCount, sizeof(CourseAggregate))) != NULL &&
+                     (job.distributions = calloc(job.courseCount + 1, sizeof(Distribution))) != NULL;
+                for (j = 0; ok && j <= job.courseCount; j++) {
+                    // Every field keeps bins and a sketch from the start: an off-grid value can turn up anywhere
+                    Distribution *distribution = &job.distributions[j];
+
+                    distribution->binCount = j < job.courseCount ? SCORE_BINS : job.courseCount * (SCORE_BINS - 1) + 1;
+                    ok = (distribution->bins = calloc(distribution->binCount, sizeof(long))) != NULL &&
+                         (distribution->sketch = calloc(SKETCH_BUCKETS, sizeof(long))) != NULL;
+                }
+            }
+            if (ok && order != VIEW_COUNT) {
+                job.arenaSize = memoryLimit - EXTERNAL_RESERVED;
+                ok = (job.arena = malloc(job.arenaSize)) != NULL &&
+                     (writeBuffers[2] = malloc(EXTERNAL_WRITE_BUFFER)) != NULL;
+            }
+            if (!ok) {
+                printf("ERROR: Not enough memory.\n");
+                break;
+            }
+            if (isHeaderLine(line, end)) {
+                continue;
+            }
+        }
+
+        if (reason == NULL && parseStudentCsvLine(line, end, &shape, &student, &reason)) {
+            if (shape.tenths) {
+                // Tenths tables sum their scores exactly
+                for (j = 0, tenths = 0; j < job.courseCount; j++) {
+                    tenths += scoreBin(student.scores[j]);
+                }
+                student.total = tenthsValue(tenths);
+            }
+            if (withStats) {
+                for (j = 0; j < job.courseCount; j++) {
+                    addScoreToAggregate(&job.aggregates[j], student.scores[j]);
+                    updateDistribution(&job.distributions[j], student.scores[j], scoreBin(student.scores[j]), 1);
+                }
+                updateDistribution(&job.distributions[job.courseCount], student.total,
+                                   scoresTotalBin(student.scores, job.courseCount), 1);
+            }
+            if (order != VIEW_COUNT) {
+                // Records fill the arena from the front, their pointers from the back; room is kept
+                // for a second pointer array in case qsort needs scratch space
+                size = runRecordSize(job.courseCount, runRecordTextLength(&job, &student),
+                                     order == VIEW_NAME ? strlen(student.name) : 0);
+                reserve = (job.arenaRecords + 1) * 2 * sizeof(RunRecord *);
+                if (job.arenaUsed + size + reserve > job.arenaSize) {
+                    if (job.spill[0] == NULL &&
+                        ((writeBuffers[0] = malloc(EXTERNAL_WRITE_BUFFER)) == NULL ||
+                         (writeBuffers[1] = malloc(EXTERNAL_WRITE_BUFFER)) == NULL ||
+                         (job.spill[0] = openSpillFile(tempDir, writeBuffers[0])) == NULL ||
+                         (job.spill[1] = openSpillFile(tempDir, writeBuffers[1])) == NULL)) {
+                        printf("ERROR: Cannot create temporary files in '%s'.\n", tempDir);
+                        ok = 0;
+                        break;
+                    }
+                    if (!spillRun(&job, NULL)) {
+                        ok = 0;
+                        break;
+                    }
+                }
+                makeRunRecord(&job, &student, job.records, (RunRecord *)(job.arena + job.arenaUsed));
+                ((RunRecord **)(job.arena + job.arenaSize))[-(long)++job.arenaRecords] =
+                    (RunRecord *)(job.arena + job.arenaUsed);
+                job.arenaUsed += size;
+            }
+            job.records++;
+            continue;
+        }
+
+        job.rejected++;
+        if (rejects == NULL && rejectPath != NULL) {
+            rejects = fopen(rejectPath, "w");
+        }
+        if (rejects != NULL) {
+            fprintf(rejects, "line %ld: %s: %.*s\n", reader.lines, reason, status < 0 ? 0 : (int)(end - line), line);
+        }
+    }
+    if (ok && ferror(reader.file)) {
+        printf("ERROR: Cannot read '%s'.\n", inputPath);
+        ok = 0;
+    }
+    free(reader.buffer);
+    fclose(reader.file);
+    if (rejects != NULL) {
+        fclose(rejects);
+    }
+    if (ok && job.courseCount == 0) {
+        printf("ERROR: '%s' holds no records.\n", inputPath);
+        ok = 0;
+    }
+
+    if (ok && order != VIEW_COUNT) {
+        if ((output = fopen(outputPath, "w")) == NULL) {
+            printf("ERROR: Cannot create '%s'.\n", outputPath);
+            ok = 0;
+        } else {
+            setvbuf(output, writeBuffers[2], _IOFBF, EXTERNAL_WRITE_BUFFER);
+            fprintf(output, "id,name");
+            for (j = 0; j < job.attributeCount; j++) {
+                fprintf(output, ",%s", attributeSchema[j]);
+            }
+            for (j = 0; j < job.courseCount; j++) {
+                fprintf(output, ",course%d", j + 1);
+            }
+            fputc('\n', output);
+
+            // A roster that fit in memory is written straight out; otherwise the last run is spilled
+            // and the arena's memory goes to the merge buffers
+            if (job.runCount == 0) {
+                ok = spillRun(&job, output);
+            } else {
+                ok = spillRun(&job, NULL);
+                runs = job.runCount;
+                free(job.arena);
+                job.arena = NULL;
+                ok = ok && mergeAllRuns(&job, output);
+                job.passes++;
+            }
+            if (fclose(output) != 0 && ok) {
+                printf("ERROR: Cannot write '%s'.\n", outputPath);
+                ok = 0;
+            }
+        }
+    }
+
+    if (ok) {
+        seconds = elapsedSeconds(&began);
+        if (withStats && job.records > 0) {
+            printExternalStatistics(&job);
+        }
+        if (order != VIEW_COUNT) {
+            printf("\nSorted %ld records from '%s' into '%s' in %.3f s (%d run%s, %d merge pass%s, %ld MB limit).\n",
+                   job.records, inputPath, outputPath, seconds, runs > 0 ? runs : 1, runs > 1 ? "s" : "",
+                   job.passes, job.passes == 1 ? "" : "es", (long)(memoryLimit >> 20));
+        } else {
+            printf("\nRead %ld records from '%s' in %.3f s (%.1f MB/s).\n", job.records, inputPath, seconds,
+                   seconds > 0 ? reader.bytes / seconds / 1e6 : 0.0);
+        }
+        if (job.rejected > 0) {
+            printf("%ld rows rejected, see '%s'.\n", job.rejected, rejectPath);
+        }
+    }
+
+    free(job.arena);
+    free(job.runs);
+    for (j = 0; j < 2; j++) {
+        if (job.spill[j] != NULL) fclose(job.spill[j]);
+    }
+    for (j = 0; j < 3; j++) {
+        free(writeBuffers[j]);
+    }
+    free(job.aggregates);
+    freeDistributions(job.distributions, job.courseCount + 1);
+    return ok;
+}
+
+// Function 257: Apply one row of an import in file order: append it unless its ID is taken, otherwise
+// note it in the reject report (line is NULL for rows with no text to show); 0 when memory runs out
+int applyImportRow(StudentTable *table, const Student *student, const char *reason, const char *line, int length,
+                   ImportSummary *summary, const char *rejectPath, FILE **rejects) {
+    if (reason == NULL) {
+        if (findStudentById(table, student->id) >= 0) {
+            reason = "duplicate ID";
+        } else if (!appendStudent(table, student)) {
+            printf("ERROR: Not enough memory.\n");
+            return 0;
+        } else {
+            summary->imported++;
+            return 1;
+        }
+    }
+
+    summary->rejected++;
+    if (*rejects == NULL && rejectPath != NULL) {
+        *rejects = fopen(rejectPath, "w");
+    }
+    if (*rejects != NULL) {
+        if (line != NULL) {
+            fprintf(*rejects, "line %ld: %s: %.*s\n", summary->lines, reason, length, line);
+        } else {
+            fprintf(*rejects, "line %ld: %s\n", summary->lines, reason);
+        }
+    }
+    return 1;
+}
+
+// Function 258: Wait for a ring to change: yield the CPU at first, then sleep in short steps
+void ringBackoff(int *attempts) {
+    struct timespec pause = {0, 50000};
+
+    if (++*attempts < 100) {
+        sched_yield();
+    } else {
+        nanosleep(&pause, NULL);
+    }
+}
+
+// Function 259: Set up an empty ring with room for at least minSlots chunks
+int initChunkRing(ChunkRing *ring, int minSlots) {
+    unsigned long slots = 1;
+
+    while (slots < (unsigned long)minSlots) slots <<= 1;
+    ring->mask = slots - 1;
+    ring->head = ring->tail = 0;
+    return (ring->slots = malloc(slots * sizeof(ImportChunk *))) != NULL;
+}
+
+// Function 260: Append a chunk to a ring, waiting while it is full; only one thread may push
+void pushChunk(ChunkRing *ring, ImportChunk *chunk) {
+    unsigned long tail = ring->tail;
+    int attempts = 0;
+
+    while (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) > ring->mask) {
+        ringBackoff(&attempts);
+    }
+    ring->slots[tail & ring->mask] = chunk;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+// Function 261: Take the oldest chunk from a ring, waiting while it is empty; only one thread may pop
+ImportChunk *popChunk(ChunkRing *ring) {
+    unsigned long head = ring->head;
+    ImportChunk *chunk;
+    int attempts = 0;
+
+    while (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == head) {
+        ringBackoff(&attempts);
+    }
+    chunk = ring->slots[head & ring->mask];
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return chunk;
+}
+
+// Function 262: Parse and validate every line of a chunk; blank lines are only counted
+void parseImportChunk(const StudentTable *shape, ImportChunk *chunk) {
+    char *line = chunk->text, *end = chunk->text + chunk->length, *newline, *lineEnd;
+    ParsedRow *row, *grown;
+
+    chunk->lineCount = chunk->rowCount = 0;
+    chunk->outOfMemory = 0;
+    while (line < end) {
+        newline = memchr(line, '\n', end - line);   // Every line in a chunk ends with one
+        lineEnd = newline;
+        if (lineEnd > line && lineEnd[-1] == '\r') lineEnd--;
+
+        if (lineEnd > line) {
+            if (chunk->rowCount == chunk->rowCapacity) {
+                int capacity = chunk->rowCapacity ? chunk->rowCapacity * 2 : 1024;
+                if ((grown = realloc(chunk->rows, capacity * sizeof(ParsedRow))) == NULL) {
+                    chunk->outOfMemory = 1;
+                    return;
+                }
+                chunk->rows = grown;
+                chunk->rowCapacity = capacity;
+            }
+            row = &chunk->rows[chunk->rowCount++];
+            row->line = line;
+            row->length = (int)(lineEnd - line);
+            row->lineIndex = chunk->lineCount;
+            if (parseStudentCsvLine(line, lineEnd, shape, &row->student, &row->reason)) {
+                row->reason = NULL;
+            }
+        }
+        chunk->lineCount++;
+        line = newline + 1;
+    }
+}
+
+// Function 263: Parser stage: parse the chunks of one ring and pass them on in the same order
+void *importParserMain(void *arg) {
+    ImportParser *parser = arg;
+    ImportPipeline *pipeline = parser->pipeline;
+    ImportChunk *chunk;
+
+    do {
+        chunk = popChunk(&pipeline->toParser[parser->index]);
+        if (chunk != &importEndMarker && !chunk->tooLong) {
+            parseImportChunk(&pipeline->shape, chunk);
+        }
+        pushChunk(&pipeline->toInserter[parser->index], chunk);
+    } while (chunk != &importEndMarker);
+    return NULL;
+}
+
+// Function 264: Insert stage: take parsed chunks in file order, so duplicate IDs resolve exactly as
+// in a one-row-at-a-time import, and hand each chunk back to the reader
+void *importInserterMain(void *arg) {
+    ImportPipeline *pipeline = arg;
+    ImportSummary *summary = pipeline->summary;
+    ImportChunk *chunk;
+    unsigned long sequence;
+    long firstLine;
+    int i;
+
+    for (sequence = 0;; sequence++) {
+        chunk = popChunk(&pipeline->toInserter[sequence % pipeline->parserCount]);
+        if (chunk == &importEndMarker) {
+            break;
+        }
+        if (chunk->outOfMemory && !pipeline->failed) {
+            printf("ERROR: Not enough memory.\n");
+            __atomic_store_n(&pipeline->failed, 1, __ATOMIC_RELEASE);
+        }
+        if (!pipeline->failed) {
+            if (chunk->tooLong) {
+                summary->lines++;
+                applyImportRow(pipeline->table, NULL, "line is too long", NULL, 0, summary, pipeline->rejectPath,
+                               pipeline->rejects);
+            } else {
+                firstLine = summary->lines;
+                for (i = 0; i < chunk->rowCount; i++) {
+                    ParsedRow *row = &chunk->rows[i];
+
+                    summary->lines = firstLine + row->lineIndex + 1;
+                    if (!applyImportRow(pipeline->table, &row->student, row->reason, row->line, row->length, summary,
+                                        pipeline->rejectPath, pipeline->rejects)) {
+                        __atomic_store_n(&pipeline->failed, 1, __ATOMIC_RELEASE);
+                        break;
+                    }
+                }
+                summary->lines = firstLine + chunk->lineCount;
+            }
+        }
+        pushChunk(&pipeline->freeChunks, chunk);
+    }
+    return NULL;
+}
+
+// Function 265: Start parserCount parser threads and the insert thread for an import whose first line
+// has been handled; 0 leaves the import on the calling thread
+int startImportPipeline(ImportPipeline *pipeline, StudentTable *table, ImportSummary *summary,
+                        const char *rejectPath, FILE **rejects, int parserCount) {
+    int i, started;
+
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->table = table;
+    pipeline->shape.courseCount = table->courseCount;
+    pipeline->shape.tenths = table->tenths;
+    pipeline->shape.attributeCount = table->attributeCount;
+    pipeline->summary = summary;
+    pipeline->rejectPath = rejectPath;
+    pipeline->rejects = rejects;
+    pipeline->parserCount = parserCount;
+    pipeline->chunkCount = parserCount * IMPORT_CHUNKS_PER_PARSER;
+
+    // Every ring can hold every chunk, so a push never waits on a ring nobody is draining
+    if ((pipeline->parsers = calloc(parserCount, sizeof(ImportParser))) == NULL ||
+        (pipeline->toParser = calloc(parserCount, sizeof(ChunkRing))) == NULL ||
+        (pipeline->toInserter = calloc(parserCount, sizeof(ChunkRing))) == NULL ||
+        (pipeline->chunks = calloc(pipeline->chunkCount, sizeof(ImportChunk))) == NULL ||
+        !initChunkRing(&pipeline->freeChunks, pipeline->chunkCount)) {
+        freeImportPipeline(pipeline);
+        return 0;
+    }
+    for (i = 0; i < parserCount; i++) {
+        if (!initChunkRing(&pipeline->toParser[i], pipeline->chunkCount) ||
+            !initChunkRing(&pipeline->toInserter[i], pipeline->chunkCount + 1)) {
+            freeImportPipeline(pipeline);
+            return 0;
+        }
+    }
+    for (i = 0; i < pipeline->chunkCount; i++) {
+        pipeline->chunks[i].capacity = IMPORT_CHUNK_SIZE;
+        if ((pipeline->chunks[i].text = malloc(IMPORT_CHUNK_SIZE)) == NULL) {
+            freeImportPipeline(pipeline);
+            return 0;
+        }
+        pushChunk(&pipeline->freeChunks, &pipeline->chunks[i]);
+    }
+    pipeline->filling = popChunk(&pipeline->freeChunks);
+
+    for (started = 0; started < parserCount; started++) {
+        pipeline->parsers[started].pipeline = pipeline;
+        pipeline->parsers[started].index = started;
+        if (pthread_create(&pipeline->parsers[started].thread, NULL, importParserMain,
+                           &pipeline->parsers[started]) != 0) {
+            break;
+        }
+    }
+    if (started == parserCount && pthread_create(&pipeline->inserter, NULL, importInserterMain, pipeline) == 0) {
+        return 1;
+    }
+
+    // Stop whatever did start; nothing has been queued yet
+    for (i = 0; i < started; i++) {
+        pushChunk(&pipeline->toParser[i], &importEndMarker);
+        pthread_join(pipeline->parsers[i].thread, NULL);
+    }
+    freeImportPipeline(pipeline);
+    return 0;
+}
+
+// Function 266: Send the chunk being filled to the next parser in turn and take an empty one
+void dispatchImportChunk(ImportPipeline *pipeline) {
+    pushChunk(&pipeline->toParser[pipeline->sequence % pipeline->parserCount], pipeline->filling);
+    pipeline->sequence++;
+    pipeline->filling = popChunk(&pipeline->freeChunks);
+    pipeline->filling->length = 0;
+    pipeline->filling->tooLong = 0;
+}
+
+// Function 267: Copy whole lines into chunks for the parsers, splitting only at line ends; the last
+// line may lack its newline at the end of the file
+int queueImportLines(ImportPipeline *pipeline, const char *start, const char *end) {
+    ImportChunk *chunk;
+    const char *cut, *lineEnd;
+    size_t room, needed;
+    char *grown;
+
+    while (start < end) {
+        chunk = pipeline->filling;
+        room = chunk->capacity - chunk->length;
+        if ((size_t)(end - start) + 1 <= room) {
+            cut = end;
+        } else if ((cut = memrchr(start, '\n', room)) != NULL) {
+            cut++;
+        } else if (chunk->length > 0) {
+            dispatchImportChunk(pipeline);
+            continue;
+        } else {
+            // One line longer than a chunk: this chunk grows to hold it
+            lineEnd = memchr(start, '\n', end - start);
+            needed = (lineEnd != NULL ? (size_t)(lineEnd - start) : (size_t)(end - start)) + 1;
+            if ((grown = realloc(chunk->text, needed)) == NULL) {
+                printf("ERROR: Not enough memory.\n");
+                return 0;
+            }
+            chunk->text = grown;
+            chunk->capacity = needed;
+            continue;
+        }
+
+        memcpy(chunk->text + chunk->length, start, cut - start);
+        chunk->length += cut - start;
+        if (cut == end && end[-1] != '\n') {
+            chunk->text[chunk->length++] = '\n';
+        }
+        start = cut;
+    }
+    return 1;
+}
+
+// Function 268: Queue a line too long for the read buffer as a chunk of its own, so it is counted in order
+void queueTooLongLine(ImportPipeline *pipeline) {
+    if (pipeline->filling->length > 0) {
+        dispatchImportChunk(pipeline);
+    }
+    pipeline->filling->tooLong = 1;
+    dispatchImportChunk(pipeline);
+}
+
+// Function 269: Flush the last chunk, stop every stage and release the pipeline; 0 if inserting failed
+int finishImportPipeline(ImportPipeline *pipeline) {
+    int i, ok;
+
+    if (pipeline->filling->length > 0) {
+        dispatchImportChunk(pipeline);
+    }
+    // Each parser gets the end marker in turn, so the inserter meets it right after the last chunk
+    for (i = 0; i < pipeline->parserCount; i++) {
+        pushChunk(&pipeline->toParser[(pipeline->sequence + i) % pipeline->parserCount], &importEndMarker);
+    }
+    for (i = 0; i < pipeline->parserCount; i++) {
+        pthread_join(pipeline->parsers[i].thread, NULL);
+    }
+    pthread_join(pipeline->inserter, NULL);
+    ok = !pipeline->failed;
+    freeImportPipeline(pipeline);
+    return ok;
+}
+
+// Function 270: Release the rings and chunks of an import pipeline
+void freeImportPipeline(ImportPipeline *pipeline) {
+    int i;
+
+    for (i = 0; pipeline->chunks != NULL && i < pipeline->chunkCount; i++) {
+        free(pipeline->chunks[i].text);
+        free(pipeline->chunks[i].rows);
+    }
+    for (i = 0; i < pipeline->parserCount; i++) {
+        if (pipeline->toParser != NULL) free(pipeline->toParser[i].slots);
+        if (pipeline->toInserter != NULL) free(pipeline->toInserter[i].slots);
+    }
+    free(pipeline->freeChunks.slots);
+    free(pipeline->chunks);
+    free(pipeline->toParser);
+    free(pipeline->toInserter);
+    free(pipeline->parsers);
+    memset(pipeline, 0, sizeof(*pipeline));
+}
+
+// Function 271: Set the attribute columns new tables get from a list such as "section,year"
+int parseAttributeList(const char *list) {
+    const char *start = list, *comma;
+    size_t length, k;
+    int a, count = 0;
+
+    while (1) {
+        comma = strchr(start, ',');
+        length = comma != NULL ? (size_t)(comma - start) : strlen(start);
+        if (count == MAX_ATTRIBUTES) {
+            printf("ERROR: At most %d attributes are allowed.\n", MAX_ATTRIBUTES);
+            return 0;
+        }
+        if (length == 0 || length >= ATTRIBUTE_NAME_LEN) {
+            printf("ERROR: Attribute names must be 1 to %d characters long.\n", ATTRIBUTE_NAME_LEN - 1);
+            return 0;
+        }
+        for (k = 0; k < length; k++) {
+            if (!isalnum((unsigned char)start[k]) && start[k] != '_') {
+                printf("ERROR: Attribute names may hold only letters, digits and underscores.\n");
+                return 0;
+            }
+        }
+        memcpy(attributeSchema[count], start, length);
+        attributeSchema[count][length] = '\0';
+        for (a = 0; a < count; a++) {
+            if (strcmp(attributeSchema[a], attributeSchema[count]) == 0) {
+                printf("ERROR: Attribute '%s' is listed twice.\n", attributeSchema[a]);
+                return 0;
+            }
+        }
+        count++;
+        if (comma == NULL) break;
+        start = comma + 1;
+    }
+    attributeSchemaCount = count;
+    return 1;
+}
+
+// Function 272: One row's value of an attribute, "" when it has none
+const char *attributeValue(const StudentTable *table, int attribute, int row) {
+    const AttributeColumn *column = &table->attributes[attribute];
+    int code = column->codes[row];
+
+    return code > 0 ? column->values[code] : "";
+}
+
+// Function 273: Attribute column with the given name, -1 if the table has none
+int findAttribute(const StudentTable *table, const char *name) {
+    int a;
+
+    for (a = 0; a < table->attributeCount; a++) {
+        if (strcmp(table->attributes[a].name, name) == 0) {
+            return a;
+        }
+    }
+    return -1;
+}
+
+// Function 274: FNV-1a hash of an attribute value
+uint32_t attributeHash(const char *text) {
+    uint32_t hash = 2166136261u;
+
+    while (*text != '\0') {
+        hash = (hash ^ (unsigned char)*text++) * 16777619u;
+    }
+    return hash;
+}
+
+// Function 275: Dictionary code of a value, added if it is new; 0 for the empty value, -1 when
+// the dictionary is full or memory runs out
+int internAttributeValue(AttributeColumn *column, const char *value) {
+    uint32_t slot, size;
+    int code;
+    void *grown;
+
+    if (value[0] == '\0') {
+        return 0;
+    }
+    for (slot = attributeHash(value) & column->lookupMask; column->lookup != NULL && (code = column->lookup[slot]) != 0;
+         slot = (slot + 1) & column->lookupMask) {
+        if (strcmp(column->values[code], value) == 0) {
+            return code;
+        }
+    }
+    if (column->valueCount >= MAX_ATTRIBUTE_VALUES) {
+        return -1;
+    }
+
+    // Code 0 is kept for the empty value
+    if (column->valueCount + 1 > column->valueCapacity) {
+        int capacity = column->valueCapacity > 0 ? column->valueCapacity * 2 : 16;
+
+        if (capacity > MAX_ATTRIBUTE_VALUES) capacity = MAX_ATTRIBUTE_VALUES;
+        if ((grown = realloc(column->values, capacity * sizeof(*column->values))) == NULL) return -1;
+        column->values = grown;
+        column->valueCapacity = capacity;
+    }
+    if (column->valueCount == 0) {
+        column->values[0][0] = '\0';
+        column->valueCount = 1;
+    }
+
+    // The hash stays at most half full; growing it re-places every code
+    if (column->lookup == NULL || (uint32_t)(column->valueCount + 1) * 2 > column->lookupMask + 1) {
+        uint16_t *lookup;
+
+        size = column->lookup != NULL ? (column->lookupMask + 1) * 2 : 64;
+        if ((lookup = calloc(size, sizeof(uint16_t))) == NULL) return -1;
+        for (code = 1; code < column->valueCount; code++) {
+            for (slot = attributeHash(column->values[code]) & (size - 1); lookup[slot] != 0; slot = (slot + 1) & (size - 1)) {
+            }
+            lookup[slot] = (uint16_t)code;
+        }
+        free(column->lookup);
+        column->lookup = lookup;
+        column->lookupMask = size - 1;
+    }
+
+    code = column->valueCount++;
+    strcpy(column->values[code], value);
+    for (slot = attributeHash(value) & column->lookupMask; column->lookup[slot] != 0; slot = (slot + 1) & column->lookupMask) {
+    }
+    column->lookup[slot] = (uint16_t)code;
+    return code;
+}
+
+// Function 276: Whether text can be an attribute value: no control characters, commas, quotes or tabs
+int isValidAttributeValue(const char *text) {
+    for (; *text != '\0'; text++) {
+        unsigned char c = (unsigned char)*text;
+        if (c < 0x20 || c == 0x7f || c == ',' || c == '"') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Function 277: Copy one CSV attribute field, trimmed and unquoted like names; returns why it
+// is invalid, NULL if it is fine
+const char *parseAttributeField(const char *field, const char *end, char *value) {
+    size_t length;
+
+    while (field < end && *field == ' ') field++;
+    length = end - field;
+    while (length > 0 && field[length - 1] == ' ') length--;
+    if (length >= 2 && field[0] == '"' && field[length - 1] == '"') {
+        field++;
+        length -= 2;
+    }
+    if (length >= ATTRIBUTE_VALUE_LEN) {
+        return "attribute value is too long";
+    }
+    memcpy(value, field, length);
+    value[length] = '\0';
+    return isValidAttributeValue(value) ? NULL : "invalid attribute value";
+}
+
+// Function 278: Read a value for each of the table's attributes from the keyboard
+void promptAttributeValues(const StudentTable *table, Student *student) {
+    char line[MAX_NAME_LEN];
+    int a;
+
+    for (a = 0; a < table->attributeCount; a++) {
+        while (1) {
+            printf("%s (Enter for none): ", table->attributes[a].name);
+            if (fgets(line, sizeof(line), stdin) == NULL) {
+                line[0] = '\0';
+            }
+            line[strcspn(line, "\n")] = '\0';
+
+            if (strlen(line) >= ATTRIBUTE_VALUE_LEN) {
+                printf("ERROR: Values are at most %d bytes.\n", ATTRIBUTE_VALUE_LEN - 1);
+                continue;
+            }
+            if (!isValidAttributeValue(line)) {
+                printf("ERROR: Commas and quotes are not allowed.\n");
+                continue;
+            }
+            break;
+        }
+        strcpy(student->attributes[a], line);
+    }
+}
+
+// Function 279: Release the attribute dictionaries and any heap-owned code columns
+void freeAttributeColumns(StudentTable *table) {
+    int a;
+
+    for (a = 0; a < table->attributeCount; a++) {
+        AttributeColumn *column = &table->attributes[a];
+
+        if (!insideMapping(table, column->codes)) {
+            free(column->codes);
+        }
+        free(column->values);
+        free(column->lookup);
+    }
+}
+
+// Function 280: Give a freshly initialised table the attribute names and dictionaries of another,
+// so every code means the same value in both; the code columns come with the rows
+int copyAttributeDictionaries(const StudentTable *source, StudentTable *copy) {
+    int a, code;
+
+    memset(copy->attributes, 0, sizeof(copy->attributes));
+    copy->attributeCount = source->attributeCount;
+    for (a = 0; a < source->attributeCount; a++) {
+        const AttributeColumn *from = &source->attributes[a];
+        AttributeColumn *to = &copy->attributes[a];
+
+        memcpy(to->name, from->name, ATTRIBUTE_NAME_LEN);
+        for (code = 1; code < from->valueCount; code++) {
+            if (internAttributeValue(to, from->values[code]) != code) return 0;
+        }
+    }
+    return 1;
+}
+
+// Function 281: Pack the attribute names and values into one block for a snapshot: for each
+// attribute its name, then its values in code order, each NUL-terminated, then an empty string
+char *encodeAttributeDictionary(const StudentTable *table, size_t *size) {
+    size_t length = 0;
+    char *blob, *out;
+    int a, code;
+
+    for (a = 0; a < table->attributeCount; a++) {
+        length += strlen(table->attributes[a].name) + 2;
+        for (code = 1; code < table->attributes[a].valueCount; code++) {
+            length += strlen(table->attributes[a].values[code]) + 1;
+        }
+    }
+    *size = length;
+    if ((blob = malloc(length > 0 ? length : 1)) == NULL) {
+        return NULL;
+    }
+    out = blob;
+    for (a = 0; a < table->attributeCount; a++) {
+        out = stpcpy(out, table->attributes[a].name) + 1;
+        for (code = 1; code < table->attributes[a].valueCount; code++) {
+            out = stpcpy(out, table->attributes[a].values[code]) + 1;
+        }
+        *out++ = '\0';
+    }
+    return blob;
+}
+
+// Function 282: Rebuild the attribute dictionaries from a snapshot block and check that every
+// row's code has a value; the code columns must already point at the rows
+int decodeAttributeDictionary(StudentTable *table, const char *blob, size_t size, int attributeCount) {
+    const char *end = blob + size, *text;
+    size_t length;
+    int a, row;
+
+    table->attributeCount = attributeCount;
+    for (a = 0; a < attributeCount; a++) {
+        AttributeColumn *column = &table->attributes[a];
+        int values = 0;
+
+        if ((text = memchr(blob, '\0', end - blob)) == NULL || text == blob ||
+            (length = text - blob) >= ATTRIBUTE_NAME_LEN) {
+            return 0;
+        }
+        memcpy(column->name, blob, length + 1);
+        for (blob = text + 1; blob < end && *blob != '\0'; blob = text + 1) {
+            if ((text = memchr(blob, '\0', end - blob)) == NULL || text - blob >= ATTRIBUTE_VALUE_LEN ||
+                internAttributeValue(column, blob) != ++values) {
+                return 0;
+            }
+        }
+        if (blob >= end) {
+            return 0;
+        }
+        blob++;
+        for (row = 0; row < table->count; row++) {
+            if (column->codes[row] > values) {
+                return 0;
+            }
+        }
+    }
+    return blob == end;
+}
+
+// Function 283: Parse the attributes to group by, e.g. "section" or "section,year"; returns how many
+int parseGroupAttributes(const StudentTable *table, const char *list, int *attributes, const char **reason) {
+    char name[ATTRIBUTE_NAME_LEN];
+    const char *start = list, *comma;
+    size_t length;
+    int count = 0, k;
+
+    if (table->attributeCount == 0) {
+        *reason = "the roster has no attributes (import with --attributes)";
+        return 0;
+    }
+    while (1) {
+        comma = strchr(start, ',');
+        length = comma != NULL ? (size_t)(comma - start) : strlen(start);
+        if (length >= ATTRIBUTE_NAME_LEN || count == MAX_ATTRIBUTES) {
+            *reason = "unknown attribute";
+            return 0;
+        }
+        memcpy(name, start, length);
+        name[length] = '\0';
+        if ((attributes[count] = findAttribute(table, name)) < 0) {
+            *reason = "unknown attribute";
+            return 0;
+        }
+        for (k = 0; k < count; k++) {
+            if (attributes[k] == attributes[count]) {
+                *reason = "attribute listed twice";
+                return 0;
+            }
+        }
+        count++;
+        if (comma == NULL) break;
+        start = comma + 1;
+    }
+    return count;
+}
+
+// Function 284: Group of a key in one part's hash table, added if new; -1 when memory runs out
+int findGroup(GroupPart *part, uint64_t key) {
+    uint32_t slot, size;
+    int group;
+    void *grown;
+
+    for (slot = (uint32_t)((key * 0x9e3779b97f4a7c15ULL) >> 32) & part->slotMask;
+         part->slots != NULL && (group = part->slots[slot]) != 0; slot = (slot + 1) & part->slotMask) {
+        if (part->keys[group - 1] == key) {
+            return group - 1;
+        }
+    }
+
+    if (part->groupCount == part->groupCapacity) {
+        int capacity = part->groupCapacity > 0 ? part->groupCapacity * 2 : 64;
+
+        if ((grown = realloc(part->keys, capacity * sizeof(uint64_t))) == NULL) return -1;
+        part->keys = grown;
+        if ((grown = realloc(part->counts, capacity * sizeof(long))) == NULL) return -1;
+        part->counts = grown;
+        part->groupCapacity = capacity;
+    }
+    // The table stays at most half full; growing it re-places every group
+    if (part->slots == NULL || (uint32_t)(part->groupCount + 1) * 2 > part->slotMask + 1) {
+        int *slots;
+
+        size = part->slots != NULL ? (part->slotMask + 1) * 2 : 256;
+        if ((slots = calloc(size, sizeof(int))) == NULL) return -1;
+        for (group = 0; group < part->groupCount; group++) {
+            for (slot = (uint32_t)((part->keys[group] * 0x9e3779b97f4a7c15ULL) >> 32) & (size - 1); slots[slot] != 0;
+                 slot = (slot + 1) & (size - 1)) {
+            }
+            slots[slot] = group + 1;
+        }
+        free(part->slots);
+        part->slots = slots;
+        part->slotMask = size - 1;
+    }
+
+    group = part->groupCount++;
+    part->keys[group] = key;
+    part->counts[group] = 0;
+    for (slot = (uint32_t)((key * 0x9e3779b97f4a7c15ULL) >> 32) & part->slotMask; part->slots[slot] != 0;
+         slot = (slot + 1) & part->slotMask) {
+    }
+    part->slots[slot] = group + 1;
+    return group;
+}
+
+// Function 285: Cells for every group a part found, each extreme primed so any value replaces it
+int allocateGroupCells(GroupPart *part, int fieldCount) {
+    long i, cellCount = (long)part->groupCount * fieldCount;
+
+    if ((part->cells = calloc(cellCount > 0 ? cellCount : 1, sizeof(GroupCell))) == NULL) {
+        return 0;
+    }
+    for (i = 0; i < cellCount; i++) {
+        part->cells[i].lowest = 100;
+        part->cells[i].highest = 0;
+    }
+    return 1;
+}
+
+// Function 286: One part of a group report: every row's group from its own hash table, then
+// each score column and the average column in one sequential pass apiece
+void groupRangeTask(void *context, int part, int begin, int end) {
+    GroupJob *job = context;
+    GroupPart *local = &job->parts[part];
+    const StudentTable *table = job->table;
+    const uint16_t *codes[MAX_ATTRIBUTES];
+    int fieldCount = job->fieldCount, row, group, j, k;
+    uint64_t key;
+
+    for (k = 0; k < job->attributeCount; k++) {
+        codes[k] = table->attributes[job->attributes[k]].codes;
+    }
+    for (row = begin; row < end; row++) {
+        key = 0;
+        for (k = 0; k < job->attributeCount; k++) {
+            key = key << 16 | codes[k][row];
+        }
+        if ((group = findGroup(local, key)) < 0) {
+            local->failed = 1;
+            return;
+        }
+        job->rowGroups[row] = group;
+        local->counts[group]++;
+    }
+    if (!allocateGroupCells(local, fieldCount)) {
+        local->failed = 1;
+        return;
+    }
+
+    for (j = 0; j < fieldCount; j++) {
+        GroupCell *cells = local->cells + j;
+
+        if (j < table->courseCount && table->tenths) {
+            // Tenths are summed as they are; the score and band of each come from small tables
+            const uint16_t *column = table->scores[j];
+
+            for (row = begin; row < end; row++) {
+                GroupCell *cell = &cells[(long)job->rowGroups[row] * fieldCount];
+                int tenths = column[row];
+                float score = job->tenthsScores[tenths];
+
+                cell->sum += tenths;
+                cell->bands[job->tenthsBands[tenths]]++;
+                if (score < cell->lowest) cell->lowest = score;
+                if (score > cell->highest) cell->highest = score;
+            }
+        } else {
+            const float *column = j < table->courseCount ? table->scores[j] : table->averages;
+
+            for (row = begin; row < end; row++) {
+                GroupCell *cell = &cells[(long)job->rowGroups[row] * fieldCount];
+                float score = column[row];
+
+                cell->sum += scoreToFixed(score);
+                // Same bands as gradeBand, without a branch for every row
+                cell->bands[(score >= 60) + (score >= 70) + (score >= 80) + (score >= 90)]++;
+                if (score < cell->lowest) cell->lowest = score;
+                if (score > cell->highest) cell->highest = score;
+            }
+        }
+    }
+}
+
+// Function 287: qsort comparator for group orders, by their sort keys
+int compareGroupOrders(const void *a, const void *b) {
+    uint64_t left = ((const GroupOrder *)a)->sortKey, right = ((const GroupOrder *)b)->sortKey;
+
+    return (left > right) - (left < right);
+}
+
+// Function 288: qsort comparator for pointers to attribute values
+int compareAttributeValues(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+// Function 289: Count, sum, extremes and grade bands of every course and the average for each
+// combination of the given attributes, in one pass over the rows; groups are in value order
+int runGroupReport(const StudentTable *table, const int *attributes, int attributeCount, GroupReport *report) {
+    GroupJob job;
+    GroupPart merged;
+    GroupOrder *order = NULL;
+    uint16_t *ranks[MAX_ATTRIBUTES];
+    const char **sorted = NULL;
+    int parts, part, group, target, j, k, code, mostValues = 1, ok = 1;
+    long cellCount;
+
+    memset(report, 0, sizeof(*report));
+    memset(&job, 0, sizeof(job));
+    memset(&merged, 0, sizeof(merged));
+    memset(ranks, 0, sizeof(ranks));
+    job.table = table;
+    memcpy(job.attributes, attributes, attributeCount * sizeof(int));
+    job.attributeCount = attributeCount;
+    job.fieldCount = table->courseCount + 1;
+    for (k = 0; table->tenths && k < SCORE_BINS; k++) {
+        job.tenthsScores[k] = tenthsValue(k);
+        job.tenthsBands[k] = (unsigned char)gradeBand(job.tenthsScores[k]);
+    }
+
+    // Each part fills its own hash table; the server runs readers side by side, and the pool
+    // takes one job at a time, so there the scan stays on the calling thread
+    parts = (table->count >= PARALLEL_MIN_ROWS && workerPool.threadCount > 1 && server.listenFd < 0)
+                ? workerPool.threadCount : 1;
+    if ((job.parts = calloc(parts, sizeof(GroupPart))) == NULL ||
+        (job.rowGroups = malloc((table->count > 0 ? table->count : 1) * sizeof(int))) == NULL) {
+        free(job.parts);
+        return 0;
+    }
+    if (parts > 1) {
+        runParallel(groupRangeTask, &job, table->count);
+    } else {
+        groupRangeTask(&job, 0, 0, table->count);
+    }
+
+    // Parts are merged in order: sums are integers and the rest are counts and extremes,
+    // so the report does not depend on the thread count
+    for (part = 0; ok && part < parts; part++) {
+        ok = !job.parts[part].failed;
+        for (group = 0; ok && group < job.parts[part].groupCount; group++) {
+            ok = findGroup(&merged, job.parts[part].keys[group]) >= 0;
+        }
+    }
+    ok = ok && allocateGroupCells(&merged, job.fieldCount);
+    for (part = 0; ok && part < parts; part++) {
+        const GroupPart *from = &job.parts[part];
+
+        for (group = 0; group < from->groupCount; group++) {
+            target = findGroup(&merged, from->keys[group]);
+            merged.counts[target] += from->counts[group];
+            for (j = 0; j < job.fieldCount; j++) {
+                GroupCell *into = &merged.cells[(long)target * job.fieldCount + j];
+                const GroupCell *cell = &from->cells[(long)group * job.fieldCount + j];
+
+                into->sum += cell->sum;
+                for (k = 0; k < GRADE_BANDS; k++) into->bands[k] += cell->bands[k];
+                if (cell->lowest < into->lowest) into->lowest = cell->lowest;
+                if (cell->highest > into->highest) into->highest = cell->highest;
+            }
+        }
+    }
+
+    // Groups are listed by the first attribute's value, then the next; rows with no value come last
+    for (k = 0; k < attributeCount; k++) {
+        if (table->attributes[attributes[k]].valueCount > mostValues) {
+            mostValues = table->attributes[attributes[k]].valueCount;
+        }
+    }
+    ok = ok && (sorted = malloc(mostValues * sizeof(char *))) != NULL;
+    for (k = 0; ok && k < attributeCount; k++) {
+        const AttributeColumn *column = &table->attributes[attributes[k]];
+        int values = column->valueCount > 1 ? column->valueCount : 1;
+
+        ok = (ranks[k] = malloc(values * sizeof(uint16_t))) != NULL;
+        for (code = 1; ok && code < values; code++) {
+            sorted[code - 1] = column->values[code];
+        }
+        if (ok) {
+            qsort(sorted, values - 1, sizeof(char *), compareAttributeValues);
+            for (code = 0; code < values - 1; code++) {
+                ranks[k][(sorted[code] - column->values[0]) / ATTRIBUTE_VALUE_LEN] = (uint16_t)code;
+            }
+            ranks[k][0] = UINT16_MAX;
+        }
+    }
+    if (ok && (order = malloc((merged.groupCount > 0 ? merged.groupCount : 1) * sizeof(GroupOrder))) == NULL) {
+        ok = 0;
+    }
+    for (group = 0; ok && group < merged.groupCount; group++) {
+        order[group].group = group;
+        order[group].sortKey = 0;
+        for (k = 0; k < attributeCount; k++) {
+            code = (int)(merged.keys[group] >> (16 * (attributeCount - 1 - k)) & 0xffff);
+            order[group].sortKey = order[group].sortKey << 16 | ranks[k][code];
+        }
+    }
+
+    cellCount = (long)merged.groupCount * job.fieldCount;
+    if (ok && ((report->keys = malloc((merged.groupCount > 0 ? merged.groupCount : 1) * sizeof(uint64_t))) == NULL ||
+               (report->counts = malloc((merged.groupCount > 0 ? merged.groupCount : 1) * sizeof(long))) == NULL ||
+               (report->cells = malloc((cellCount > 0 ? cellCount : 1) * sizeof(GroupCell))) == NULL)) {
+        ok = 0;
+    }
+    if (ok) {
+        qsort(order, merged.groupCount, sizeof(GroupOrder), compareGroupOrders);
+        for (group = 0; group < merged.groupCount; group++) {
+            report->keys[group] = merged.keys[order[group].group];
+            report->counts[group] = merged.counts[order[group].group];
+            memcpy(&report->cells[(long)group * job.fieldCount], &merged.cells[(long)order[group].group * job.fieldCount],
+                   job.fieldCount * sizeof(GroupCell));
+        }
+        memcpy(report->attributes, attributes, attributeCount * sizeof(int));
+        report->attributeCount = attributeCount;
+        report->fieldCount = job.fieldCount;
+        report->groupCount = merged.groupCount;
+        report->tenths = table->tenths;
+    } else {
+        freeGroupReport(report);
+    }
+
+    for (part = 0; part < parts; part++) {
+        freeGroupPart(&job.parts[part]);
+    }
+    freeGroupPart(&merged);
+    for (k = 0; k < attributeCount; k++) {
+        free(ranks[k]);
+    }
+    free(sorted);
+    free(order);
+    free(job.parts);
+    free(job.rowGroups);
+    return ok;
+}
+
+// Function 290: Release one part's hash table and cells
+void freeGroupPart(GroupPart *part) {
+    free(part->keys);
+    free(part->counts);
+    free(part->cells);
+    free(part->slots);
+}
+
+// Function 291: Release a group report
+void freeGroupReport(GroupReport *report) {
+    free(report->keys);
+    free(report->counts);
+    free(report->cells);
+    memset(report, 0, sizeof(*report));
+}
+
+// Function 292: Mean of one field of a group; course sums of tenths tables are in tenths
+double groupMean(const GroupReport *report, int group, int field) {
+    const GroupCell *cell = &report->cells[(long)group * report->fieldCount + field];
+
+    if (report->tenths && field < report->fieldCount - 1) {
+        return cell->sum / 10.0 / report->counts[group];
+    }
+    return cell->sum / SCORE_FIXED_ONE / report->counts[group];
+}
+
+// Function 293: A group's values joined with commas; empty values are shown as none
+void groupLabel(const StudentTable *table, const GroupReport *report, int group, const char *none, char *label,
+                size_t size) {
+    size_t used = 0;
+    int k, code;
+
+    label[0] = '\0';
+    for (k = 0; k < report->attributeCount; k++) {
+        const AttributeColumn *column = &table->attributes[report->attributes[k]];
+
+        code = (int)(report->keys[group] >> (16 * (report->attributeCount - 1 - k)) & 0xffff);
+        used += snprintf(label + used, used < size ? size - used : 0, "%s%s", k > 0 ? "," : "",
+                         code > 0 ? column->values[code] : none);
+    }
+}
+
+// Function 294: Course and average statistics for each section, year or other attribute value
+void showGroupReport(StudentTable *table) {
+    char line[BATCH_LINE_LEN], label[MAX_ATTRIBUTES * ATTRIBUTE_VALUE_LEN + 16];
+    int attributes[MAX_ATTRIBUTES], attributeCount, group, j, a;
+    const char *reason;
+    GroupReport report;
+    struct timespec began;
+
+    if (table->attributeCount == 0) {
+        printf("\nERROR: The roster has no attributes. Import it with --attributes (e.g. --attributes section).\n");
+        return;
+    }
+    printf("\nGroup by (");
+    for (a = 0; a < table->attributeCount; a++) {
+        printf("%s%s", a > 0 ? ", " : "", table->attributes[a].name);
+    }
+    printf("; several may be joined with commas): ");
+    clearInputBuffer();
+    if (fgets(line, sizeof(line), stdin) == NULL) {
+        return;
+    }
+    line[strcspn(line, " \r\n")] = '\0';
+    if ((attributeCount = parseGroupAttributes(table, line, attributes, &reason)) == 0) {
+        printf("\nERROR: %s.\n", reason);
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    if (!runGroupReport(table, attributes, attributeCount, &report)) {
+        printf("\nERROR: Not enough memory.\n");
+        return;
+    }
+
+    printf("\n============================================\n");
+    printf("            GROUP STATISTICS\n");
+    printf("============================================\n");
+    for (group = 0; group < report.groupCount; group++) {
+        groupLabel(table, &report, group, "(none)", label, sizeof(label));
+        printf("\n%s: %s (%ld students)\n", line, label, report.counts[group]);
+        printf("             Average  Lowest  Highest      A      B      C      D      F\n");
+        for (j = 0; j < report.fieldCount; j++) {
+            const GroupCell *cell = &report.cells[(long)group * report.fieldCount + j];
+
+            if (j < table->courseCount) {
+                printf("  Course %-2d ", j + 1);
+            } else {
+                printf("  Average   ");
+            }
+            printf("%8.2f %7.2f %8.2f %6ld %6ld %6ld %6ld %6ld\n", groupMean(&report, group, j), cell->lowest,
+                   cell->highest, cell->bands[4], cell->bands[3], cell->bands[2], cell->bands[1], cell->bands[0]);
+        }
+    }
+    printf("\nGroups: %d\n", report.groupCount);
+    freeGroupReport(&report);
+    printReportTiming(&began);
+}
+
+// Function 295: group ATTR[,ATTR...] [course N | average]: one line per group and field with the
+// count, mean, extremes and A-F counts
+int batchGroup(BatchSession *session, char **args, int argCount) {
+    StudentTable *table = session->table;
+    char label[MAX_ATTRIBUTES * ATTRIBUTE_VALUE_LEN + 16];
+    int attributes[MAX_ATTRIBUTES], attributeCount, first = 0, last = table->courseCount, group, j;
+    const char *reason;
+    GroupReport report;
+
+    if (argCount == 3 && strcmp(args[1], "course") == 0) {
+        first = atoi(args[2]) - 1;
+        if (first < 0 || first >= table->courseCount) {
+            return batchError(session, "course must be between 1 and %d", table->courseCount);
+        }
+        last = first;
+    } else if (argCount == 2 && strcmp(args[1], "average") == 0) {
+        first = table->courseCount;
+    } else if (argCount != 1) {
+        return batchError(session, "usage: group ATTRIBUTE[,ATTRIBUTE...] [course N | average]");
+    }
+    if ((attributeCount = parseGroupAttributes(table, args[0], attributes, &reason)) == 0) {
+        return batchError(session, "%s", reason);
+    }
+    if (!runGroupReport(table, attributes, attributeCount, &report)) {
+        return batchError(session, "not enough memory");
+    }
+
+    for (group = 0; group < report.groupCount; group++) {
+        groupLabel(table, &report, group, "", label, sizeof(label));
+        for (j = first; j <= last; j++) {
+            const GroupCell *cell = &report.cells[(long)group * report.fieldCount + j];
+
+            if (j < table->courseCount) {
+                fprintf(session->out, "%s\t%d", label, j + 1);
+            } else {
+                fprintf(session->out, "%s\taverage", label);
+            }
+            fprintf(session->out, "\t%ld\t%g\t%g\t%g\t%ld\t%ld\t%ld\t%ld\t%ld\n", report.counts[group],
+                    groupMean(&report, group, j), cell->lowest, cell->highest, cell->bands[4], cell->bands[3],
+                    cell->bands[2], cell->bands[1], cell->bands[0]);
+            session->rows++;
+        }
+    }
+    freeGroupReport(&report);
+    return BATCH_OK;
+}
+
+// Function 296: Bytes of a run record's text: the name, then a comma and each attribute value
+size_t runRecordTextLength(const ExternalJob *job, const Student *student) {
+    size_t length = strlen(student->name);
+    int a;
+
+    for (a = 0; a < job->attributeCount; a++) {
+        length += 1 + strlen(student->attributes[a]);
+    }
+    return length;
+}
+
+// Function 297: Room for extra bytes at the end of a buffer; NULL once memory has run out
+unsigned char *reserveBytes(ByteBuffer *buffer, size_t extra) {
+    size_t capacity;
+    unsigned char *grown;
+
+    if (buffer->failed) {
+        return NULL;
+    }
+    if (buffer->used + extra > buffer->capacity) {
+        capacity = buffer->capacity > 0 ? buffer->capacity * 2 : 256;
+        while (capacity < buffer->used + extra) capacity *= 2;
+        if ((grown = realloc(buffer->bytes, capacity)) == NULL) {
+            buffer->failed = 1;
+            return NULL;
+        }
+        buffer->bytes = grown;
+        buffer->capacity = capacity;
+    }
+    return buffer->bytes + buffer->used;
+}
+
+// Function 298: Append bytes to a buffer
+void putBytes(ByteBuffer *buffer, const void *data, size_t size) {
+    unsigned char *out = reserveBytes(buffer, size);
+
+    if (out != NULL) {
+        memcpy(out, data, size);
+        buffer->used += size;
+    }
+}
+
+// Function 299: Append a varint: seven bits per byte, low bits first, the high bit set on all but the last
+void putVarint(ByteBuffer *buffer, uint64_t value) {
+    unsigned char *out = reserveBytes(buffer, 10);
+    size_t length = 0;
+
+    if (out == NULL) {
+        return;
+    }
+    while (value >= 0x80) {
+        out[length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (unsigned char)value;
+    buffer->used += length;
+}
+
+// Function 300: Read a varint; 0 if it runs past the end or does not fit in 64 bits
+int getVarint(const unsigned char **cursor, const unsigned char *end, uint64_t *value) {
+    const unsigned char *p = *cursor;
+    uint64_t result = 0;
+    int shift;
+
+    for (shift = 0; p < end && shift < 64; shift += 7) {
+        result |= (uint64_t)(*p & 0x7f) << shift;
+        if ((*p++ & 0x80) == 0) {
+            *value = result;
+            *cursor = p;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function 301: Tenths a stored score counts as when the next change to it is encoded
+int historyTenths(float score) {
+    return (int)(score * 10 + 0.5f);
+}
+
+// Function 302: Append one score change to a course block: the key gap, then the change in tenths
+// (zigzag-coded and shifted left one bit), or 1 and the float itself for scores that are not whole tenths
+void putScoreChange(ByteBuffer *block, uint32_t gap, float before, float after) {
+    int bin = scoreBin(after);
+    int64_t change;
+
+    putVarint(block, gap);
+    if (bin >= 0) {
+        change = (int64_t)bin - historyTenths(before);
+        putVarint(block, (uint64_t)(change >= 0 ? change * 2 : -change * 2 - 1) << 1);
+    } else {
+        putVarint(block, 1);
+        putBytes(block, &after, sizeof(after));
+    }
+}
+
+// Function 303: Decode the new score of a course block entry from the old one; 0 if the entry is damaged
+int getScoreChange(const unsigned char **cursor, const unsigned char *end, float before, float *after) {
+    uint64_t code;
+    int64_t tenths;
+
+    if (!getVarint(cursor, end, &code)) {
+        return 0;
+    }
+    if (code & 1) {
+        if (code != 1 || end - *cursor < (ptrdiff_t)sizeof(*after)) return 0;
+        memcpy(after, *cursor, sizeof(*after));
+        *cursor += sizeof(*after);
+        return *after >= 0 && *after <= 100;
+    }
+    code >>= 1;
+    tenths = historyTenths(before) + ((code & 1) ? -(int64_t)(code >> 1) - 1 : (int64_t)(code >> 1));
+    if (tenths < 0 || tenths >= SCORE_BINS) {
+        return 0;
+    }
+    *after = tenthsValue((int)tenths);
+    return 1;
+}
+
+// Function 304: Step over a course block entry's score without decoding it
+int skipScoreChange(const unsigned char **cursor, const unsigned char *end) {
+    uint64_t code;
+
+    if (!getVarint(cursor, end, &code)) {
+        return 0;
+    }
+    if (code == 1) {
+        if (end - *cursor < (ptrdiff_t)sizeof(float)) return 0;
+        *cursor += sizeof(float);
+    }
+    return 1;
+}
+
+// Function 305: Bytes a term takes in the history file
+uint64_t termBytes(const TermInfo *info) {
+    uint64_t bytes = sizeof(TermHeader) + info->header.blockCount * sizeof(TermBlock);
+    uint32_t b;
+
+    for (b = 0; b < info->header.blockCount; b++) {
+        bytes += info->blocks[b].size;
+    }
+    return bytes;
+}
+
+// Function 306: Open the term history and index its terms, once. A missing file is an empty history
+// unless create is set; a term cut short by a crash during "term close" is left out and later overwritten
+int openTermHistory(int create, const char **reason) {
+    HistoryHeader header;
+    TermInfo info, *grown;
+    struct stat status;
+    off_t offset;
+    size_t tableBytes;
+    uint32_t b, keyCount = 0;
+
+    if (history.fd >= 0) {
+        return 1;
+    }
+    if (history.path[0] == '\0') {
+        *reason = "snapshots are off, so there is no term history (use --history FILE)";
+        return 0;
+    }
+    if (!create && access(history.path, F_OK) != 0) {
+        *reason = "no term has been closed yet";
+        return 0;
+    }
+    if ((history.fd = open(history.path, O_RDWR | O_CREAT, 0644)) < 0 || fstat(history.fd, &status) != 0) {
+        *reason = "cannot open the term history";
+        closeTermHistory();
+        return 0;
+    }
+
+    // A file too short for its header has never had a whole term written to it
+    history.termCount = history.courseCount = 0;
+    history.validEnd = 0;
+    if (status.st_size < (off_t)sizeof(header)) {
+        return 1;
+    }
+    if (pread(history.fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        memcmp(header.magic, HISTORY_MAGIC, sizeof(header.magic)) != 0 || header.version != HISTORY_VERSION ||
+        header.headerSize != sizeof(header) || header.courseCount < 1 || header.courseCount > MAX_COURSES) {
+        *reason = "the term history file is damaged or from an incompatible version";
+        closeTermHistory();
+        return 0;
+    }
+    history.courseCount = header.courseCount;
+    history.validEnd = offset = sizeof(header);
+    tableBytes = (TERM_BLOCK_COURSES + header.courseCount) * sizeof(TermBlock);
+
+    while (offset + (off_t)(sizeof(TermHeader) + tableBytes) <= status.st_size) {
+        memset(&info, 0, sizeof(info));
+        if (pread(history.fd, &info.header, sizeof(info.header), offset) != (ssize_t)sizeof(info.header) ||
+            info.header.magic != TERM_MAGIC || info.header.blockCount != TERM_BLOCK_COURSES + header.courseCount ||
+            info.header.keyCount < keyCount || info.header.memberCount > info.header.keyCount ||
+            pread(history.fd, info.blocks, tableBytes, offset + sizeof(info.header)) != (ssize_t)tableBytes) {
+            break;
+        }
+        info.header.name[TERM_NAME_LEN - 1] = '\0';
+        info.offset = offset + sizeof(info.header) + tableBytes;
+        info.firstKey = keyCount;
+        offset = info.offset;
+        for (b = 0; b < info.header.blockCount; b++) {
+            offset += info.blocks[b].size;
+        }
+        if (offset > status.st_size) {
+            break;
+        }
+
+        if (history.termCount == history.termCapacity) {
+            int capacity = history.termCapacity > 0 ? history.termCapacity * 2 : 16;
+
+            if ((grown = realloc(history.terms, capacity * sizeof(*grown))) == NULL) {
+                *reason = "not enough memory";
+                closeTermHistory();
+                return 0;
+            }
+            history.terms = grown;
+            history.termCapacity = capacity;
+        }
+        history.terms[history.termCount++] = info;
+        history.validEnd = offset;
+        keyCount = info.header.keyCount;
+    }
+    return 1;
+}
+
+// Function 307: Close the term history file and drop its index
+void closeTermHistory(void) {
+    if (history.fd >= 0) {
+        close(history.fd);
+    }
+    history.fd = -1;
+    free(history.terms);
+    history.terms = NULL;
+    history.termCount = history.termCapacity = 0;
+}
+
+// Function 308: Term given by name, or else by number counting from 1; -1 if there is none
+int findTerm(const char *text) {
+    char *end;
+    long number;
+    int t;
+
+    for (t = 0; t < history.termCount; t++) {
+        if (strcmp(history.terms[t].header.name, text) == 0) {
+            return t;
+        }
+    }
+    number = strtol(text, &end, 10);
+    return end != text && *end == '\0' && number >= 1 && number <= history.termCount ? (int)number - 1 : -1;
+}
+
+// Function 309: Read one block of a term and check it against its checksum; 0 if it is unreadable,
+// damaged or memory runs out
+int loadTermBlock(int term, int block, ByteBuffer *into) {
+    const TermInfo *info = &history.terms[term];
+    off_t offset = info->offset;
+    uint32_t size = info->blocks[block].size, done = 0;
+    ssize_t got;
+    int b;
+
+    for (b = 0; b < block; b++) {
+        offset += info->blocks[b].size;
+    }
+    into->used = 0;
+    if (reserveBytes(into, size > 0 ? size : 1) == NULL) {
+        return 0;
+    }
+    while (done < size) {
+        if ((got = pread(history.fd, into->bytes + done, size - done, offset + done)) <= 0) {
+            return 0;
+        }
+        done += got;
+    }
+    into->used = size;
+    return journalChecksum(into->bytes, size) == info->blocks[block].checksum;
+}
+
+// Function 310: Start decoding the history from its first term. Only the courses in courseMask are
+// decoded, and IDs and names only when asked for
+void startTermCursor(TermCursor *cursor, int wantIds, int wantNames, uint64_t courseMask) {
+    memset(cursor, 0, sizeof(*cursor));
+    cursor->wantIds = wantIds;
+    cursor->wantNames = wantNames;
+    cursor->courseMask = courseMask;
+    if (wantNames) {
+        // Offset 0 is the empty name every key starts with
+        putBytes(&cursor->names, "", 1);
+    }
+}
+
+// Function 311: Room for keyCount students in every array the cursor keeps; new ones start off the
+// roster with no name and zero scores
+int growTermCursor(TermCursor *cursor, uint32_t keyCount) {
+    uint32_t capacity = cursor->capacity > 0 ? cursor->capacity : 1024, old = cursor->capacity;
+    void *grown;
+    int j;
+
+    if (keyCount <= old) {
+        return 1;
+    }
+    while (capacity < keyCount) capacity *= 2;
+
+    if ((grown = realloc(cursor->members, capacity)) == NULL) return 0;
+    cursor->members = grown;
+    memset(cursor->members + old, 0, capacity - old);
+    if (cursor->wantIds) {
+        if ((grown = realloc(cursor->ids, capacity * sizeof(long))) == NULL) return 0;
+        cursor->ids = grown;
+    }
+    if (cursor->wantNames) {
+        if ((grown = realloc(cursor->nameOffsets, capacity * sizeof(uint32_t))) == NULL) return 0;
+        cursor->nameOffsets = grown;
+        memset(cursor->nameOffsets + old, 0, (capacity - old) * sizeof(uint32_t));
+    }
+    for (j = 0; j < history.courseCount; j++) {
+        if (cursor->courseMask >> j & 1) {
+            if ((grown = realloc(cursor->scores[j], capacity * sizeof(float))) == NULL) return 0;
+            cursor->scores[j] = grown;
+            memset(cursor->scores[j] + old, 0, (capacity - old) * sizeof(float));
+        }
+    }
+    cursor->capacity = capacity;
+    return 1;
+}
+
+// Function 312: Apply the next term: its new students, who left or came back, renames and score
+// changes, keeping each decoded course's sum over the roster current; 0 if a block is damaged or
+// memory runs out
+int advanceTermCursor(TermCursor *cursor) {
+    const TermInfo *info = &history.terms[cursor->term];
+    const unsigned char *p, *end;
+    uint32_t previous = cursor->keyCount, keyCount = info->header.keyCount, key, next;
+    uint64_t gap, length;
+    long id = 0;
+    float after;
+    int j;
+
+    if (!growTermCursor(cursor, keyCount)) {
+        return 0;
+    }
+
+    // New students join with zero scores, so their first scores arrive as changes
+    memset(cursor->members + previous, 1, keyCount - previous);
+    cursor->memberCount += keyCount - previous;
+    if (cursor->wantIds) {
+        if (!loadTermBlock(cursor->term, TERM_BLOCK_IDS, &cursor->block)) return 0;
+        p = cursor->block.bytes;
+        end = p + cursor->block.used;
+        for (key = previous; key < keyCount; key++) {
+            if (!getVarint(&p, end, &gap) || gap == 0 || gap > (uint64_t)(LONG_MAX - id)) return 0;
+            id += (long)gap;
+            cursor->ids[key] = id;
+        }
+        if (p != end) return 0;
+    }
+
+    if (!loadTermBlock(cursor->term, TERM_BLOCK_MEMBERS, &cursor->block)) {
+        return 0;
+    }
+    p = cursor->block.bytes;
+    end = p + cursor->block.used;
+    for (next = 0; p < end; next = key + 1) {
+        if (!getVarint(&p, end, &gap) || gap >= previous - next) return 0;
+        key = next + (uint32_t)gap;
+        cursor->members[key] ^= 1;
+        cursor->memberCount += cursor->members[key] ? 1 : -1;
+        for (j = 0; j < history.courseCount; j++) {
+            if (cursor->courseMask >> j & 1) {
+                cursor->sums[j] += cursor->members[key] ? cursor->scores[j][key] : -cursor->scores[j][key];
+            }
+        }
+    }
+
+    if (cursor->wantNames) {
+        if (!loadTermBlock(cursor->term, TERM_BLOCK_NAMES, &cursor->block)) return 0;
+        p = cursor->block.bytes;
+        end = p + cursor->block.used;
+        for (next = 0; p < end; next = key + 1) {
+            if (!getVarint(&p, end, &gap) || gap >= keyCount - next || !getVarint(&p, end, &length) ||
+                length == 0 || length >= MAX_NAME_LEN || (uint64_t)(end - p) < length) {
+                return 0;
+            }
+            key = next + (uint32_t)gap;
+            cursor->nameOffsets[key] = (uint32_t)cursor->names.used;
+            putBytes(&cursor->names, p, length);
+            putBytes(&cursor->names, "", 1);
+            p += length;
+        }
+        if (cursor->names.failed) return 0;
+    }
+
+    for (j = 0; j < history.courseCount; j++) {
+        float *scores = cursor->scores[j];
+
+        if (!(cursor->courseMask >> j & 1)) {
+            continue;
+        }
+        if (!loadTermBlock(cursor->term, TERM_BLOCK_COURSES + j, &cursor->block)) return 0;
+        p = cursor->block.bytes;
+        end = p + cursor->block.used;
+        for (next = 0; p < end; next = key + 1) {
+            if (!getVarint(&p, end, &gap) || gap >= keyCount - next) return 0;
+            key = next + (uint32_t)gap;
+            if (!getScoreChange(&p, end, scores[key], &after)) return 0;
+            if (cursor->members[key]) {
+                cursor->sums[j] += (double)after - scores[key];
+            }
+            scores[key] = after;
+        }
+    }
+
+    cursor->keyCount = keyCount;
+    cursor->term++;
+    return cursor->memberCount == (long)info->header.memberCount;
+}
+
+// Function 313: Release a cursor's arrays
+void freeTermCursor(TermCursor *cursor) {
+    int j;
+
+    free(cursor->members);
+    free(cursor->ids);
+    free(cursor->nameOffsets);
+    free(cursor->names.bytes);
+    free(cursor->block.bytes);
+    for (j = 0; j < MAX_COURSES; j++) {
+        free(cursor->scores[j]);
+    }
+    memset(cursor, 0, sizeof(*cursor));
+}
+
+// Function 314: Total of a student's scores; whole tenths are summed as integers, as tenths tables do
+float historyTotal(const float *scores, int courseCount) {
+    float total = 0;
+    int tenths = 0, j, bin;
+
+    for (j = 0; j < courseCount && (bin = scoreBin(scores[j])) >= 0; j++) {
+        tenths += bin;
+    }
+    if (j == courseCount) {
+        return tenthsValue(tenths);
+    }
+    for (j = 0; j < courseCount; j++) {
+        total += scores[j];
+    }
+    return total;
+}
+
+// Function 315: One student's course score, total or average in the cursor's current term
+float termFieldValue(const TermCursor *cursor, uint32_t key, int field) {
+    float scores[MAX_COURSES], total;
+    int j;
+
+    if (field >= 0) {
+        return cursor->scores[field][key];
+    }
+    for (j = 0; j < history.courseCount; j++) {
+        scores[j] = cursor->scores[j][key];
+    }
+    total = historyTotal(scores, history.courseCount);
+    return field == RANGE_BY_AVERAGE ? total / history.courseCount : total;
+}
+
+// Function 316: qsort comparator for student IDs
+int compareLongs(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+
+    return (x > y) - (x < y);
+}
+
+// Function 317: Record the roster as a new term, stored as what changed since the term before: IDs
+// and names of new students, renames, who left or came back, and each changed score
+int closeTerm(StudentTable *table, const char *name, TermInfo *closed, const char **reason) {
+    ByteBuffer blocks[TERM_BLOCK_COURSES + MAX_COURSES];
+    TermBlock sizes[TERM_BLOCK_COURSES + MAX_COURSES];
+    HistoryHeader fileHeader;
+    TermCursor state;
+    TermInfo info, *grown;
+    int *rowOfKey = NULL, blockCount = TERM_BLOCK_COURSES + table->courseCount, row, b, j, ok = 0;
+    uint8_t *claimed = NULL;
+    long *newIds = NULL, newCount = 0, previousId = 0;
+    uint32_t key, next, keyCount;
+    off_t end;
+
+    if (strlen(name) == 0 || strlen(name) >= TERM_NAME_LEN || strpbrk(name, " \t") != NULL ||
+        !isValidAttributeValue(name)) {
+        *reason = "term names are 1 to 31 characters without spaces, commas or quotes";
+        return 0;
+    }
+    if (table->count <= 0) {
+        *reason = "no data loaded";
+        return 0;
+    }
+    if (!openTermHistory(1, reason)) {
+        return 0;
+    }
+    if (history.courseCount != 0 && history.courseCount != table->courseCount) {
+        *reason = "the roster's course count differs from the earlier terms'";
+        return 0;
+    }
+    for (b = 0; b < history.termCount; b++) {
+        if (strcmp(history.terms[b].header.name, name) == 0) {
+            *reason = "a term with that name already exists";
+            return 0;
+        }
+    }
+    memset(blocks, 0, sizeof(blocks));
+    *reason = "not enough memory";
+
+    // Decode the latest term in full; it is what the new one is compared against
+    startTermCursor(&state, 1, 1, history.courseCount > 0 ? (1ULL << history.courseCount) - 1 : 0);
+    while (state.term < history.termCount) {
+        if (!advanceTermCursor(&state)) {
+            *reason = "the term history is damaged";
+            goto done;
+        }
+    }
+
+    // Students keep their key for good; ones never seen before get the next keys in ID order
+    if ((rowOfKey = malloc(((size_t)state.keyCount + table->count) * sizeof(int))) == NULL ||
+        (claimed = calloc(table->count, 1)) == NULL || (newIds = malloc(table->count * sizeof(long))) == NULL) {
+        goto done;
+    }
+    for (key = 0; key < state.keyCount; key++) {
+        if ((rowOfKey[key] = findStudentById(table, state.ids[key])) >= 0) {
+            claimed[rowOfKey[key]] = 1;
+        }
+    }
+    for (row = 0; row < table->count; row++) {
+        if (!claimed[row]) newIds[newCount++] = table->ids[row];
+    }
+    qsort(newIds, newCount, sizeof(long), compareLongs);
+    for (b = 0; b < newCount; b++) {
+        rowOfKey[state.keyCount + b] = findStudentById(table, newIds[b]);
+        putVarint(&blocks[TERM_BLOCK_IDS], (uint64_t)(newIds[b] - previousId));
+        previousId = newIds[b];
+    }
+    keyCount = state.keyCount + (uint32_t)newCount;
+
+    for (key = 0, next = 0; key < keyCount; key++) {
+        const char *text;
+
+        if ((row = rowOfKey[key]) < 0) continue;
+        text = studentName(table, row);
+        if (key >= state.keyCount || strcmp((const char *)state.names.bytes + state.nameOffsets[key], text) != 0) {
+            putVarint(&blocks[TERM_BLOCK_NAMES], key - next);
+            putVarint(&blocks[TERM_BLOCK_NAMES], strlen(text));
+            putBytes(&blocks[TERM_BLOCK_NAMES], text, strlen(text));
+            next = key + 1;
+        }
+    }
+    for (key = 0, next = 0; key < state.keyCount; key++) {
+        if ((rowOfKey[key] >= 0) != state.members[key]) {
+            putVarint(&blocks[TERM_BLOCK_MEMBERS], key - next);
+            next = key + 1;
+        }
+    }
+
+    // A score is stored only when it differs from the student's last stored score in that course
+    memset(&info, 0, sizeof(info));
+    for (j = 0; j < table->courseCount; j++) {
+        ByteBuffer *block = &blocks[TERM_BLOCK_COURSES + j];
+
+        for (key = 0, next = 0; key < keyCount; key++) {
+            float before, after;
+
+            if ((row = rowOfKey[key]) < 0) continue;
+            before = key < state.keyCount ? state.scores[j][key] : 0;
+            after = scoreAt(table, j, row);
+            if (after != before) {
+                putScoreChange(block, key - next, before, after);
+                next = key + 1;
+                info.header.changeCount++;
+            }
+        }
+    }
+    for (b = 0; b < blockCount; b++) {
+        if (blocks[b].failed) goto done;
+        sizes[b].size = (uint32_t)blocks[b].used;
+        sizes[b].checksum = journalChecksum(blocks[b].bytes, (uint32_t)blocks[b].used);
+    }
+
+    info.header.magic = TERM_MAGIC;
+    info.header.blockCount = blockCount;
+    snprintf(info.header.name, sizeof(info.header.name), "%s", name);
+    info.header.keyCount = keyCount;
+    info.header.memberCount = table->count;
+    memcpy(info.blocks, sizes, blockCount * sizeof(TermBlock));
+    info.firstKey = state.keyCount;
+    if (history.termCount == history.termCapacity) {
+        int capacity = history.termCapacity > 0 ? history.termCapacity * 2 : 16;
+
+        if ((grown = realloc(history.terms, capacity * sizeof(*grown))) == NULL) goto done;
+        history.terms = grown;
+        history.termCapacity = capacity;
+    }
+
+    // Anything past the last whole term is a torn append; the new term replaces it
+    *reason = "cannot write the term history";
+    if (ftruncate(history.fd, history.validEnd) != 0 || lseek(history.fd, history.validEnd, SEEK_SET) < 0) {
+        goto done;
+    }
+    if (history.validEnd == 0) {
+        memset(&fileHeader, 0, sizeof(fileHeader));
+        memcpy(fileHeader.magic, HISTORY_MAGIC, sizeof(fileHeader.magic));
+        fileHeader.version = HISTORY_VERSION;
+        fileHeader.headerSize = sizeof(fileHeader);
+        fileHeader.courseCount = table->courseCount;
+        if (!writeAll(history.fd, &fileHeader, sizeof(fileHeader))) goto done;
+        history.validEnd = sizeof(fileHeader);
+        history.courseCount = table->courseCount;
+    }
+    info.offset = history.validEnd + sizeof(info.header) + blockCount * sizeof(TermBlock);
+    end = history.validEnd + (off_t)termBytes(&info);
+    if (!writeAll(history.fd, &info.header, sizeof(info.header)) ||
+        !writeAll(history.fd, sizes, blockCount * sizeof(TermBlock))) {
+        goto done;
+    }
+    for (b = 0; b < blockCount; b++) {
+        if (!writeAll(history.fd, blocks[b].bytes, blocks[b].used)) goto done;
+    }
+    if (fsync(history.fd) != 0) {
+        goto done;
+    }
+
+    history.terms[history.termCount++] = info;
+    history.validEnd = end;
+    *closed = info;
+    ok = 1;
+
+done:
+    for (b = 0; b < TERM_BLOCK_COURSES + MAX_COURSES; b++) {
+        free(blocks[b].bytes);
+    }
+    freeTermCursor(&state);
+    free(rowOfKey);
+    free(claimed);
+    free(newIds);
+    return ok;
+}
+
+// Function 318: One student in every term: records[t] holds their name and scores in term t and
+// present[t] whether they were on its roster. Each block is read only up to the student's entry;
+// returns the term count, or -1 with a reason
+int termStudentHistory(long id, Student **records, uint8_t **present, const char **reason) {
+    ByteBuffer block = {0};
+    Student current;
+    const unsigned char *p, *end;
+    uint64_t gap, length;
+    uint32_t key = 0, next, entry;
+    long seenId;
+    int t, first = -1, j, member = 0, ok = 0;
+
+    *records = NULL;
+    *present = NULL;
+    if (!openTermHistory(0, reason)) {
+        return -1;
+    }
+    *reason = "the term history is damaged";
+
+    // New IDs are stored in ascending order, so each term's list is read only up to the ID
+    for (t = 0; t < history.termCount && first < 0; t++) {
+        if (!loadTermBlock(t, TERM_BLOCK_IDS, &block)) goto done;
+        p = block.bytes;
+        end = p + block.used;
+        for (key = history.terms[t].firstKey, seenId = 0; p < end && seenId < id; key++) {
+            if (!getVarint(&p, end, &gap)) goto done;
+            seenId += (long)gap;
+            if (seenId == id) first = t;
+        }
+    }
+    if (first < 0) {
+        *reason = "the student is in no term";
+        goto done;
+    }
+    key--;
+
+    *reason = "not enough memory";
+    if ((*records = calloc(history.termCount, sizeof(Student))) == NULL ||
+        (*present = calloc(history.termCount, 1)) == NULL) {
+        goto done;
+    }
+    memset(&current, 0, sizeof(current));
+    current.id = id;
+
+    *reason = "the term history is damaged";
+    for (t = first; t < history.termCount; t++) {
+        if (t == first) {
+            member = 1;
+        } else {
+            if (!loadTermBlock(t, TERM_BLOCK_MEMBERS, &block)) goto done;
+            p = block.bytes;
+            end = p + block.used;
+            for (next = 0; p < end; next = entry + 1) {
+                if (!getVarint(&p, end, &gap)) goto done;
+                if ((entry = next + (uint32_t)gap) >= key) {
+                    member ^= entry == key;
+                    break;
+                }
+            }
+        }
+
+        if (!loadTermBlock(t, TERM_BLOCK_NAMES, &block)) goto done;
+        p = block.bytes;
+        end = p + block.used;
+        for (next = 0; p < end; next = entry + 1) {
+            if (!getVarint(&p, end, &gap) || !getVarint(&p, end, &length) || length >= MAX_NAME_LEN ||
+                (uint64_t)(end - p) < length) {
+                goto done;
+            }
+            if ((entry = next + (uint32_t)gap) >= key) {
+                if (entry == key) {
+                    memcpy(current.name, p, length);
+                    current.name[length] = '\0';
+                }
+                break;
+            }
+            p += length;
+        }
+
+        for (j = 0; j < history.courseCount; j++) {
+            if (!loadTermBlock(t, TERM_BLOCK_COURSES + j, &block)) goto done;
+            p = block.bytes;
+            end = p + block.used;
+            for (next = 0; p < end; next = entry + 1) {
+                if (!getVarint(&p, end, &gap)) goto done;
+                if ((entry = next + (uint32_t)gap) == key) {
+                    if (!getScoreChange(&p, end, current.scores[j], &current.scores[j])) goto done;
+                    break;
+                }
+                if (entry > key) break;
+                if (!skipScoreChange(&p, end)) goto done;
+            }
+        }
+
+        current.total = historyTotal(current.scores, history.courseCount);
+        current.average = current.total / history.courseCount;
+        (*records)[t] = current;
+        (*present)[t] = (uint8_t)member;
+    }
+    ok = 1;
+
+done:
+    free(block.bytes);
+    if (!ok) {
+        free(*records);
+        free(*present);
+        *records = NULL;
+        *present = NULL;
+        return -1;
+    }
+    return history.termCount;
+}
+
+// Function 319: Mean of a course (or RANK_BY_TOTAL, RANGE_BY_AVERAGE) over each term's roster, from sums
+// kept up to date change by change; only the courses the field needs are decoded. Returns the term
+// count, or -1 with a reason
+int termFieldMeans(int field, double **means, long **counts, const char **reason) {
+    TermCursor cursor;
+    uint64_t mask;
+    double sum;
+    int t, j;
+
+    *means = NULL;
+    *counts = NULL;
+    if (!openTermHistory(0, reason)) {
+        return -1;
+    }
+    if (field >= history.courseCount) {
+        *reason = "course number is past the history's courses";
+        return -1;
+    }
+    mask = field >= 0 ? 1ULL << field : (1ULL << history.courseCount) - 1;
+    if ((*means = malloc(history.termCount * sizeof(double))) == NULL ||
+        (*counts = malloc(history.termCount * sizeof(long))) == NULL) {
+        free(*means);
+        *means = NULL;
+        *reason = "not enough memory";
+        return -1;
+    }
+
+    startTermCursor(&cursor, 0, 0, mask);
+    for (t = 0; t < history.termCount; t++) {
+        if (!advanceTermCursor(&cursor)) {
+            freeTermCursor(&cursor);
+            free(*means);
+            free(*counts);
+            *means = NULL;
+            *counts = NULL;
+            *reason = "the term history is damaged";
+            return -1;
+        }
+        for (j = 0, sum = 0; j < history.courseCount; j++) {
+            if (mask >> j & 1) sum += cursor.sums[j];
+        }
+        if (field == RANGE_BY_AVERAGE) {
+            sum /= history.courseCount;
+        }
+        (*counts)[t] = cursor.memberCount;
+        (*means)[t] = cursor.memberCount > 0 ? sum / cursor.memberCount : 0;
+    }
+    freeTermCursor(&cursor);
+    return history.termCount;
+}
+
+// Function 320: qsort comparator for improvement candidates: largest gain first, then by ID
+int compareImprovers(const void *a, const void *b) {
+    const ImproverCandidate *x = a, *y = b;
+    float gainX = x->after - x->before, gainY = y->after - y->before;
+
+    if (gainX != gainY) {
+        return gainX < gainY ? 1 : -1;
+    }
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+// Function 321: The k students on both rosters whose course score, total or average rose most from
+// term `from` to term `to`; only the courses the field needs are decoded, and names only for the
+// winners. Returns how many were found, or -1 with a reason
+int termImprovers(int from, int to, int field, int k, TermImprover **out, const char **reason) {
+    TermCursor cursor;
+    ImproverCandidate *candidates = NULL;
+    float *earlier = NULL;
+    uint8_t *onEarlier = NULL;
+    int *winnerOf = NULL, first = from < to ? from : to, last = from < to ? to : from, t, found = -1;
+    long count = 0;
+    uint32_t key, next, earlierKeys = 0;
+    const unsigned char *p, *end;
+    uint64_t gap, length;
+
+    *out = NULL;
+    if (field >= history.courseCount) {
+        *reason = "course number is past the history's courses";
+        return -1;
+    }
+    startTermCursor(&cursor, 1, 0, field >= 0 ? 1ULL << field : (1ULL << history.courseCount) - 1);
+
+    for (t = 0; t <= last; t++) {
+        if (!advanceTermCursor(&cursor)) {
+            *reason = "the term history is damaged";
+            goto done;
+        }
+        if (t == first) {
+            earlierKeys = cursor.keyCount;
+            *reason = "not enough memory";
+            if ((earlier = malloc((earlierKeys > 0 ? earlierKeys : 1) * sizeof(float))) == NULL ||
+                (onEarlier = malloc(earlierKeys > 0 ? earlierKeys : 1)) == NULL) {
+                goto done;
+            }
+            for (key = 0; key < earlierKeys; key++) {
+                onEarlier[key] = cursor.members[key];
+                earlier[key] = onEarlier[key] ? termFieldValue(&cursor, key, field) : 0;
+            }
+        }
+    }
+
+    // Only students on both rosters have a change to rank
+    if ((candidates = malloc((earlierKeys > 0 ? earlierKeys : 1) * sizeof(ImproverCandidate))) == NULL) {
+        *reason = "not enough memory";
+        goto done;
+    }
+    for (key = 0; key < earlierKeys; key++) {
+        if (onEarlier[key] && cursor.members[key]) {
+            float value = termFieldValue(&cursor, key, field);
+            ImproverCandidate *candidate = &candidates[count++];
+
+            candidate->id = cursor.ids[key];
+            candidate->before = from < to ? earlier[key] : value;
+            candidate->after = from < to ? value : earlier[key];
+            candidate->key = key;
+        }
+    }
+    qsort(candidates, count, sizeof(ImproverCandidate), compareImprovers);
+    if (count > k) {
+        count = k;
+    }
+    *reason = "not enough memory";
+    if ((*out = calloc(count > 0 ? count : 1, sizeof(TermImprover))) == NULL ||
+        (winnerOf = calloc(earlierKeys > 0 ? earlierKeys : 1, sizeof(int))) == NULL) {
+        goto done;
+    }
+    for (t = 0; t < count; t++) {
+        (*out)[t].id = candidates[t].id;
+        (*out)[t].before = candidates[t].before;
+        (*out)[t].after = candidates[t].after;
+        winnerOf[candidates[t].key] = t + 1;
+    }
+
+    // Names are read back for the winners alone, from every term up to the later one
+    *reason = "the term history is damaged";
+    for (t = 0; t <= last; t++) {
+        if (!loadTermBlock(t, TERM_BLOCK_NAMES, &cursor.block)) goto done;
+        p = cursor.block.bytes;
+        end = p + cursor.block.used;
+        for (next = 0; p < end; next = key + 1) {
+            if (!getVarint(&p, end, &gap) || !getVarint(&p, end, &length) || length >= MAX_NAME_LEN ||
+                (uint64_t)(end - p) < length) {
+                goto done;
+            }
+            key = next + (uint32_t)gap;
+            if (key < earlierKeys && winnerOf[key] > 0) {
+                memcpy((*out)[winnerOf[key] - 1].name, p, length);
+                (*out)[winnerOf[key] - 1].name[length] = '\0';
+            }
+            p += length;
+        }
+    }
+    found = (int)count;
+
+done:
+    if (found < 0) {
+        free(*out);
+        *out = NULL;
+    }
+    freeTermCursor(&cursor);
+    free(candidates);
+    free(earlier);
+    free(onEarlier);
+    free(winnerOf);
+    return found;
+}
+
+// Function 322: Copy the term index for listing; returns the term count, or -1 with a reason
+int listTerms(TermInfo **terms, const char **reason) {
+    *terms = NULL;
+    if (!openTermHistory(0, reason)) {
+        return -1;
+    }
+    if ((*terms = malloc((history.termCount > 0 ? history.termCount : 1) * sizeof(TermInfo))) == NULL) {
+        *reason = "not enough memory";
+        return -1;
+    }
+    memcpy(*terms, history.terms, history.termCount * sizeof(TermInfo));
+    return history.termCount;
+}
+
+// Function 323: Read "course N", "total" or "average" into a field (a course index, RANK_BY_TOTAL or
+// RANGE_BY_AVERAGE); returns the words used, 0 if they are not a field
+int parseTermField(char **args, int argCount, int *field) {
+    if (argCount >= 1 && strcmp(args[0], "total") == 0) {
+        *field = RANK_BY_TOTAL;
+        return 1;
+    }
+    if (argCount >= 1 && strcmp(args[0], "average") == 0) {
+        *field = RANGE_BY_AVERAGE;
+        return 1;
+    }
+    if (argCount >= 2 && strcmp(args[0], "course") == 0 && atoi(args[1]) >= 1) {
+        *field = atoi(args[1]) - 1;
+        return 2;
+    }
+    return 0;
+}
+
+// Function 324: term close NAME | list | student ID | course N|total|average |
+// improvers A B [K] [course N|total|average]
+int batchTerm(BatchSession *session, char **args, int argCount) {
+    const char *reason;
+    int t, j, count, used, field = RANK_BY_TOTAL, status = BATCH_OK;
+
+    pthread_mutex_lock(&history.lock);
+    if (strcmp(args[0], "close") == 0 && argCount == 2) {
+        TermInfo closed;
+
+        if (!closeTerm(session->table, args[1], &closed, &reason)) {
+            status = batchError(session, "%s", reason);
+        } else {
+            fprintf(session->out, "%s\t%u\t%u\t%llu\t%llu\n", closed.header.name, closed.header.memberCount,
+                    closed.header.keyCount - closed.firstKey, (unsigned long long)closed.header.changeCount,
+                    (unsigned long long)termBytes(&closed));
+            session->rows++;
+        }
+    } else if (strcmp(args[0], "list") == 0 && argCount == 1) {
+        TermInfo *terms;
+
+        if ((count = listTerms(&terms, &reason)) < 0) {
+            status = batchError(session, "%s", reason);
+        } else {
+            for (t = 0; t < count; t++) {
+                fprintf(session->out, "%d\t%s\t%u\t%u\t%llu\t%llu\n", t + 1, terms[t].header.name,
+                        terms[t].header.memberCount, terms[t].header.keyCount - terms[t].firstKey,
+                        (unsigned long long)terms[t].header.changeCount, (unsigned long long)termBytes(&terms[t]));
+                session->rows++;
+            }
+            free(terms);
+        }
+    } else if (strcmp(args[0], "student") == 0 && argCount == 2) {
+        Student *records;
+        uint8_t *present;
+
+        if ((count = termStudentHistory(atol(args[1]), &records, &present, &reason)) < 0) {
+            status = batchError(session, "%s", reason);
+        } else {
+            for (t = 0; t < count; t++) {
+                if (!present[t]) continue;
+                fprintf(session->out, "%s\t%ld\t%s", history.terms[t].header.name, records[t].id, records[t].name);
+                for (j = 0; j < history.courseCount; j++) {
+                    fprintf(session->out, "\t%g", records[t].scores[j]);
+                }
+                fprintf(session->out, "\t%g\t%g\n", records[t].total, records[t].average);
+                session->rows++;
+            }
+            free(records);
+            free(present);
+        }
+    } else if (strcmp(args[0], "course") == 0 && argCount == 2 &&
+               (parseTermField(args + 1, 1, &field) > 0 || (field = atoi(args[1]) - 1) >= 0)) {
+        double *means;
+        long *counts;
+
+        if ((count = termFieldMeans(field, &means, &counts, &reason)) < 0) {
+            status = batchError(session, "%s", reason);
+        } else {
+            for (t = 0; t < count; t++) {
+                fprintf(session->out, "%s\t%ld\t%g\n", history.terms[t].header.name, counts[t], means[t]);
+                session->rows++;
+            }
+            free(means);
+            free(counts);
+        }
+    } else if (strcmp(args[0], "improvers") == 0 && argCount >= 3) {
+        TermImprover *improvers;
+        int from, to, k = 10, next = 3;
+
+        if (next < argCount && isdigit((unsigned char)args[next][0])) {
+            k = atoi(args[next++]);
+        }
+        if (next < argCount && (used = parseTermField(args + next, argCount - next, &field)) > 0) {
+            next += used;
+        }
+        if (next != argCount || k <= 0) {
+            status = batchError(session, "usage: term improvers A B [K] [course N | total | average]");
+        } else if (!openTermHistory(0, &reason)) {
+            status = batchError(session, "%s", reason);
+        } else if ((from = findTerm(args[1])) < 0 || (to = findTerm(args[2])) < 0) {
+            status = batchError(session, "no term '%s'", from < 0 ? args[1] : args[2]);
+        } else if (from == to) {
+            status = batchError(session, "the two terms must differ");
+        } else if ((count = termImprovers(from, to, field, k, &improvers, &reason)) < 0) {
+            status = batchError(session, "%s", reason);
+        } else {
+            for (t = 0; t < count; t++) {
+                fprintf(session->out, "%ld\t%s\t%g\t%g\t%g\n", improvers[t].id, improvers[t].name,
+                        improvers[t].before, improvers[t].after, improvers[t].after - improvers[t].before);
+                session->rows++;
+            }
+            free(improvers);
+        }
+    } else {
+        status = batchError(session, "usage: term close NAME | list | student ID | course N|total|average | "
+                                     "improvers A B [K] [course N|total|average]");
+    }
+    pthread_mutex_unlock(&history.lock);
+    return status;
+}
+
+// Function 325: Close a term, or look back over the closed ones: one student in every term, a course
+// average per term, or the biggest improvers between two terms
+void showTermHistory(StudentTable *table) {
+    char first[TERM_NAME_LEN * 2], second[TERM_NAME_LEN * 2];
+    const char *reason;
+    int choice, count, t, j, field = 0, from, to, k = 0;
+    long id = 0;
+    struct timespec began;
+
+    printf("\n1. Close the current term\n");
+    printf("2. One student in every term\n");
+    printf("3. Course average per term\n");
+    printf("4. Biggest improvers between two terms\n");
+    printf("5. List terms\n");
+    printf("Choice: ");
+    if (scanf("%d", &choice) != 1 || choice < 1 || choice > 5) {
+        printf("ERROR: Invalid choice.\n");
+        clearInputBuffer();
+        return;
+    }
+    if (choice == 1) {
+        printf("Term name (e.g. 2024-fall): ");
+        if (scanf("%63s", first) != 1) choice = 0;
+    } else if (choice == 2) {
+        printf("Student ID: ");
+        if (scanf("%ld", &id) != 1) choice = 0;
+    } else if (choice == 3) {
+        printf("Course (0 = total score): ");
+        if (scanf("%d", &field) != 1 || field < 0) choice = 0;
+    } else if (choice == 4) {
+        printf("From term and to term (names or numbers): ");
+        if (scanf("%63s %63s", first, second) != 2) choice = 0;
+        printf("Rank by (0 = total score, or a course number): ");
+        if (choice != 0 && (scanf("%d", &field) != 1 || field < 0)) choice = 0;
+        printf("How many students: ");
+        if (choice != 0 && (scanf("%d", &k) != 1 || k <= 0)) choice = 0;
+    }
+    clearInputBuffer();
+    if (choice == 0) {
+        printf("ERROR: Invalid input.\n");
+        return;
+    }
+    field = field > 0 ? field - 1 : RANK_BY_TOTAL;
+
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    pthread_mutex_lock(&history.lock);
+    if (choice == 1) {
+        TermInfo closed;
+
+        if (!closeTerm(table, first, &closed, &reason)) {
+            printf("\nERROR: %s.\n", reason);
+        } else {
+            printf("\nSUCCESS: Term '%s' closed: %u students (%u new), %llu changed scores, %llu bytes.\n",
+                   closed.header.name, closed.header.memberCount, closed.header.keyCount - closed.firstKey,
+                   (unsigned long long)closed.header.changeCount, (unsigned long long)termBytes(&closed));
+        }
+    } else if (choice == 2) {
+        Student *records;
+        uint8_t *present;
+
+        if ((count = termStudentHistory(id, &records, &present, &reason)) < 0) {
+            printf("\nERROR: %s.\n", reason);
+        } else {
+            printf("\n============================================\n");
+            printf("     STUDENT %ld IN EVERY TERM\n", id);
+            printf("============================================\n");
+            printf("%-16s %-20s", "Term", "Name");
+            for (j = 0; j < history.courseCount; j++) {
+                printf("    C%-2d", j + 1);
+            }
+            printf("   Total  Average\n");
+            for (t = 0; t < count; t++) {
+                printf("%-16s ", history.terms[t].header.name);
+                if (!present[t]) {
+                    printf("(not enrolled)\n");
+                    continue;
+                }
+                printf("%s%*s", records[t].name, namePadding(records[t].name, 20), "");
+                for (j = 0; j < history.courseCount; j++) {
+                    printf(" %6.1f", records[t].scores[j]);
+                }
+                printf(" %7.1f %8.2f\n", records[t].total, records[t].average);
+            }
+            free(records);
+            free(present);
+        }
+    } else if (choice == 3) {
+        double *means;
+        long *counts;
+
+        if ((count = termFieldMeans(field, &means, &counts, &reason)) < 0) {
+            printf("\nERROR: %s.\n", reason);
+        } else {
+            printf("\n============================================\n");
+            if (field == RANK_BY_TOTAL) {
+                printf("     AVERAGE TOTAL SCORE PER TERM\n");
+            } else {
+                printf("     AVERAGE OF COURSE %d PER TERM\n", field + 1);
+            }
+            printf("============================================\n");
+            printf("%-16s %10s %10s\n", "Term", "Students", "Average");
+            for (t = 0; t < count; t++) {
+                printf("%-16s %10ld %10.2f\n", history.terms[t].header.name, counts[t], means[t]);
+            }
+            free(means);
+            free(counts);
+        }
+    } else if (choice == 4) {
+        TermImprover *improvers;
+
+        if (!openTermHistory(0, &reason)) {
+            printf("\nERROR: %s.\n", reason);
+        } else if ((from = findTerm(first)) < 0 || (to = findTerm(second)) < 0 || from == to) {
+            printf("\nERROR: Give two different terms, by name or by number in option 5.\n");
+        } else if ((count = termImprovers(from, to, field, k, &improvers, &reason)) < 0) {
+            printf("\nERROR: %s.\n", reason);
+        } else {
+            printf("\n============================================\n");
+            printf("     BIGGEST IMPROVERS: %s TO %s\n", history.terms[from].header.name,
+                   history.terms[to].header.name);
+            printf("============================================\n");
+            printf("  #  Student ID    Student Name            Before     After    Change\n");
+            for (t = 0; t < count; t++) {
+                printf("%3d  %-12ld  %s%*s %9.1f %9.1f %+9.1f\n", t + 1, improvers[t].id, improvers[t].name,
+                       namePadding(improvers[t].name, 20), "", improvers[t].before, improvers[t].after,
+                       improvers[t].after - improvers[t].before);
+            }
+            free(improvers);
+        }
+    } else {
+        TermInfo *terms;
+
+        if ((count = listTerms(&terms, &reason)) < 0) {
+            printf("\nERROR: %s.\n", reason);
+        } else {
+            printf("\n  #  %-16s %10s %8s %12s %12s\n", "Term", "Students", "New", "Changed", "Bytes");
+            for (t = 0; t < count; t++) {
+                printf("%3d  %-16s %10u %8u %12llu %12llu\n", t + 1, terms[t].header.name,
+                       terms[t].header.memberCount, terms[t].header.keyCount - terms[t].firstKey,
+                       (unsigned long long)terms[t].header.changeCount, (unsigned long long)termBytes(&terms[t]));
+            }
+            free(terms);
+        }
+    }
+    pthread_mutex_unlock(&history.lock);
+    printReportTiming(&began);
+}
+
+// Function 326: Whether a name handle read from a snapshot points at a NUL-free, well-formed UTF-8
+// name of an allowed length, then its folded key of the same length, both terminated inside the arena.
+// Offsets already found valid are marked in checked; another handle at one of them is valid exactly
+// when that name's first terminator is where its length says
+int validArenaName(const NameArena *arena, NameRef ref, uint64_t *checked) {
+    const unsigned char *name = (const unsigned char *)arena->bytes + ref.offset;
+    uint32_t i;
+    int length;
+
+    if (ref.length == 0 || ref.length >= MAX_NAME_LEN || (uint64_t)ref.offset + 2 * ref.length + 2 > arena->used ||
+        memchr(name, '\0', ref.length + 1) != name + ref.length) {
+        return 0;
+    }
+    if (checked[ref.offset / 64] & (1ULL << (ref.offset % 64))) {
+        return 1;
+    }
+    if (memchr(name + ref.length + 1, '\0', ref.length + 1) != name + 2 * ref.length + 1) {
+        return 0;
+    }
+    for (i = 0; i < ref.length; i += length) {
+        if ((length = utf8SequenceLength(name + i)) == 0) {
+            return 0;
+        }
+    }
+    checked[ref.offset / 64] |= 1ULL << (ref.offset % 64);
+    return 1;
+}
+
+// Function 327: Exact histogram bin of a row's total: the sum of its scores in tenths, or -1 when a
+// score is off the 0.1 grid. Float totals can drift from that sum by rounding, so it is taken
+// from the scores rather than from the total
+int totalBin(const StudentTable *table, int row) {
+    int bin = 0, score, j;
+
+    for (j = 0; j < table->courseCount; j++) {
+        if (table->tenths) {
+            bin += ((const uint16_t *)table->scores[j])[row];
+        } else if ((score = scoreBin(((const float *)table->scores[j])[row])) < 0) {
+            return -1;
+        } else {
+            bin += score;
+        }
+    }
+    return bin;
+}
+
+// Function 328: Exact histogram bin of the total of a record's scores, -1 when one is off the 0.1 grid
+int scoresTotalBin(const float *scores, int courseCount) {
+    int bin = 0, score, j;
+
+    for (j = 0; j < courseCount; j++) {
+        if ((score = scoreBin(scores[j])) < 0) {
+            return -1;
+        }
+        bin += score;
+    }
+    return bin;
+}
+
+// Function 329: Code point of a UTF-8 character already checked by utf8SequenceLength
+unsigned int utf8CodePoint(const unsigned char *text, int length) {
+    unsigned int codePoint;
+    int i;
+
+    if (length == 1) {
+        return text[0];
+    }
+    codePoint = text[0] & (0x7F >> length);
+    for (i = 1; i < length; i++) {
+        codePoint = (codePoint << 6) | (text[i] & 0x3F);
+    }
+    return codePoint;
+}
+
+// Function 330: Whether a non-ASCII code point is a letter of a script names are written in.
+// Symbols, punctuation, dashes and emoji fall outside every range
+int isNameLetter(unsigned int codePoint) {
+    static const unsigned int letters[][2] = {
+        {0x00C0, 0x00D6}, {0x00D8, 0x00F6}, {0x00F8, 0x024F},   // Latin-1 letters and Latin Extended
+        {0x0370, 0x0373}, {0x0376, 0x0377}, {0x037B, 0x037D}, {0x037F, 0x037F},
+        {0x0386, 0x0386}, {0x0388, 0x03F5}, {0x03F7, 0x03FF},   // Greek
+        {0x0400, 0x0481}, {0x048A, 0x052F},                     // Cyrillic
+        {0x0531, 0x0556}, {0x0561, 0x0587},                     // Armenian
+        {0x05D0, 0x05EA}, {0x0620, 0x0652},                     // Hebrew and Arabic letters
+        {0x0900, 0x0963}, {0x0971, 0x097F},                     // Devanagari without dandas and digits
+        {0x0E01, 0x0E3A}, {0x0E40, 0x0E4E}, {0x10A0, 0x10FF},   // Thai and Georgian
+        {0x1E00, 0x1EFF},                                       // Latin Extended Additional
+        {0x3041, 0x3096}, {0x30A1, 0x30FA}, {0x30FC, 0x30FC},   // Hiragana and Katakana
+        {0x3400, 0x4DBF}, {0x4E00, 0x9FFF},                     // CJK ideographs
+        {0xAC00, 0xD7A3},                                       // Hangul syllables
+    };
+    size_t i;
+
+    for (i = 0; i < sizeof(letters) / sizeof(letters[0]); i++) {
+        if (codePoint >= letters[i][0] && codePoint <= letters[i][1]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function 331: Sort rows into a view's order; rows given in ascending order keep it among equal
+// keys, as every sort here is stable, so ties go to the lower row like the old bubble sorts
+int sortViewRows(const StudentTable *table, ViewKind kind, int *rows, int n) {
+    uint64_t *keys = NULL;
+    int *scratch = NULL;
+    int i, ok = 1;
+
+    switch (kind) {
+        case VIEW_TOTAL_DESC:
+        case VIEW_TOTAL_ASC:
+            if ((keys = malloc((n > 0 ? n : 1) * sizeof(uint64_t))) == NULL) {
+                ok = 0;
+                break;
+            }
+            for (i = 0; i < n; i++) {
+                keys[i] = floatSortKey(table->totals[rows[i]]);
+                if (kind == VIEW_TOTAL_DESC) keys[i] ^= 0xffffffffULL;
+            }
+            ok = radixSortRows(keys, rows, n, 4);
+            break;
+        case VIEW_ID:
+            if ((keys = malloc((n > 0 ? n : 1) * sizeof(uint64_t))) == NULL) {
+                ok = 0;
+                break;
+            }
+            for (i = 0; i < n; i++) {
+                keys[i] = (uint64_t)table->ids[rows[i]] ^ 0x8000000000000000ULL;
+            }
+            ok = radixSortRows(keys, rows, n, 8);
+            break;
+        case VIEW_NAME:
+            if ((scratch = malloc((n > 0 ? n : 1) * sizeof(int))) == NULL) {
+                ok = 0;
+                break;
+            }
+            mergeSortRowsByName(table, rows, scratch, n);
+            break;
+        default:
+            ok = 0;
+    }
+
+    free(keys);
+    free(scratch);
+    return ok;
+}
+
+// Function 332: Size the columns and the ID index for the rows a CSV file holds, judged by the
+// length of its first record, so a large import does not regrow and rehash them again and again.
+// Only a hint: when memory is short the import simply grows as it goes
+void reserveImportRows(StudentTable *table, long long fileBytes, long lineBytes) {
+    long long estimate = fileBytes / (lineBytes > 0 ? lineBytes : 1);
+    int rows;
+
+    if (estimate <= INITIAL_CAPACITY) {
+        return;
+    }
+    rows = table->count + (int)(estimate < INT_MAX / 4 - table->count ? estimate : INT_MAX / 4 - table->count);
+    if (reserveStudentRows(table, rows) && table->idIndex.mask + 1 < rows * 2) {
+        buildIdIndex(table, rows);
+    }
+}
+
+// Function 333: Parse a plain CSV row (digits for the ID, an ASCII name, unsigned decimal scores,
+// no attributes) in one pass, validating and copying the name as it is read. The scores and totals
+// come out bit for bit as parseScoreField makes them. 0 leaves the row to the field-by-field checks,
+// which accept what this one does not handle and give the reason for anything they reject
+int parsePlainCsvLine(const char *p, const char *end, const StudentTable *table, Student *student) {
+    static const float powersOfTen[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f};
+    long id = 0, mantissa;
+    int length = 0, digits, decimals, seenPoint, j;
+
+    if (table->attributeCount > 0) {
+        return 0;
+    }
+    for (digits = 0; p < end && *p >= '0' && *p <= '9' && digits < 18; p++, digits++) {
+        id = id * 10 + (*p - '0');
+    }
+    if (digits == 0 || p == end || *p != ',' || id < MIN_STUDENT_ID || id > maxStudentId) {
+        return 0;
+    }
+    student->id = id;
+
+    // Letters, then single spaces and hyphens between them; quotes, padding and UTF-8 go the long way
+    for (p++; p < end && *p != ','; p++) {
+        if (length == MAX_NAME_LEN - 1) return 0;
+        if ((unsigned)((*p | 0x20) - 'a') >= 26) {
+            if (length == 0 || (*p != '-' && (*p != ' ' || student->name[length - 1] == ' '))) return 0;
+        }
+        student->name[length++] = *p;
+    }
+    if (length == 0 || student->name[length - 1] == ' ') {
+        return 0;
+    }
+    student->name[length] = '\0';
+
+    student->total = 0;
+    for (j = 0; j < table->courseCount; j++) {
+        if (p == end) {
+            return 0;
+        }
+        mantissa = 0;
+        digits = decimals = seenPoint = 0;
+        for (p++; p < end && *p != ','; p++) {
+            if (*p >= '0' && *p <= '9' && digits < 7) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits++;
+                decimals += seenPoint;
+            } else if (*p == '.' && !seenPoint) {
+                seenPoint = 1;
+            } else {
+                return 0;
+            }
+        }
+        if (digits == 0) {
+            return 0;
+        }
+        student->scores[j] = (float)mantissa / powersOfTen[decimals];
+        if (student->scores[j] > 100 || (table->tenths && scoreBin(student->scores[j]) < 0)) {
+            return 0;
+        }
+        student->total += student->scores[j];
+    }
+    if (p != end) {
+        return 0;
+    }
+    student->average = (table->courseCount > 0) ? student->total / table->courseCount : 0;
+    return 1;
+}
+
+// Main Function
+int main(int argc, char *argv[]) {
+    StudentTable table;
+    int studentCount = 0, courseCount = 0;
+    int choice, i;
+    const char *importPath = NULL, *rejectPath = NULL, *batchPath = NULL;
+    const char *servePath = NULL, *connectPath = NULL, *loadPath = NULL;
+    long loadClients = DEFAULT_LOAD_CLIENTS, writePercent = DEFAULT_WRITE_PERCENT;
+    double loadSeconds = DEFAULT_LOAD_SECONDS;
+    const char *generatePath = NULL, *benchSizes = NULL, *benchOutput = DEFAULT_BENCH_OUTPUT;
+    long generateStudents = 0, generateCourses = DEFAULT_GENERATE_COURSES, generateSections = 0;
+    uint64_t seed = DEFAULT_SEED;
+    const char *snapshotPath = DEFAULT_SNAPSHOT_PATH, *kernel = "auto", *historyPath = NULL;
+    int verifySnapshot = 0, haveTable = 0, useJournal = 1, dumpStats = 0;
+    const char *statsSetting = getenv(STATS_ENV);
+    OperationTimer timer;
+    long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+    char defaultRejectPath[1024];
+    const char *externalPath = NULL, *externalOutput = NULL, *tempDir = getenv("TMPDIR");
+    ViewKind externalOrder = VIEW_TOTAL_DESC;
+    int externalSort = 0, externalStats = 0;
+    long memoryLimit = DEFAULT_MEMORY_LIMIT;
+    FILE *notices;
+
+    // Command-line options
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--import") == 0 && i + 1 < argc) {
+            importPath = argv[++i];
+        } else if (strcmp(argv[i], "--rejects") == 0 && i + 1 < argc) {
+            rejectPath = argv[++i];
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshotPath = argv[++i];
+        } else if (strcmp(argv[i], "--no-snapshot") == 0) {
+            snapshotPath = NULL;
+        } else if (strcmp(argv[i], "--history") == 0 && i + 1 < argc) {
+            historyPath = argv[++i];
+        } else if (strcmp(argv[i], "--generate") == 0 && i + 1 < argc) {
+            generatePath = argv[++i];
+        } else if (strcmp(argv[i], "--students") == 0 && i + 1 < argc) {
+            generateStudents = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--courses") == 0 && i + 1 < argc) {
+            generateCourses = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--sections") == 0 && i + 1 < argc) {
+            generateSections = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--attributes") == 0 && i + 1 < argc) {
+            if (!parseAttributeList(argv[++i])) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-id") == 0 && i + 1 < argc && (maxStudentId = atol(argv[++i])) >= MIN_STUDENT_ID) {
+            // Generated rosters past 9000 students use IDs above 9999
+        } else if (strcmp(argv[i], "--benchmark") == 0) {
+            benchSizes = DEFAULT_BENCH_SIZES;
+        } else if (strcmp(argv[i], "--bench-sizes") == 0 && i + 1 < argc) {
+            benchSizes = argv[++i];
+        } else if (strcmp(argv[i], "--bench-output") == 0 && i + 1 < argc) {
+            benchOutput = argv[++i];
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            enableOperationStats();
+        } else if (strcmp(argv[i], "--no-intern") == 0) {
+            internNames = 0;
+        } else if (strcmp(argv[i], "--compact-scores") == 0) {
+            compactScores = 1;
+        } else if (strcmp(argv[i], "--no-journal") == 0) {
+            useJournal = 0;
+        } else if (strcmp(argv[i], "--journal-limit") == 0 && i + 1 < argc && (journal.limit = atol(argv[++i])) > 0) {
+            // Compaction starts once the journal grows past this many bytes
+        } else if (strcmp(argv[i], "--verify-snapshot") == 0) {
+            verifySnapshot = 1;
+        } else if (strcmp(argv[i], "--self-check") == 0) {
+            selfCheckEnabled = 1;
+        } else if (strcmp(argv[i], "--kernel") == 0 && i + 1 < argc) {
+            kernel = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batchPath = argv[++i];
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            servePath = argv[++i];
+        } else if (strcmp(argv[i], "--connect") == 0 && i + 1 < argc) {
+            connectPath = argv[++i];
+        } else if (strcmp(argv[i], "--loadgen") == 0 && i + 1 < argc) {
+            loadPath = argv[++i];
+        } else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc && (loadClients = atol(argv[++i])) > 0) {
+            // Connections the load generator keeps busy
+        } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc && (loadSeconds = atof(argv[++i])) > 0) {
+            // Seconds the load generator runs
+        } else if (strcmp(argv[i], "--write-percent") == 0 && i + 1 < argc &&
+                   (writePercent = atol(argv[++i])) >= 0 && writePercent <= 100) {
+            // Share of load generator commands that update a score
+        } else if (strcmp(argv[i], "--page") == 0 && i + 1 < argc && (listingOptions.page = atol(argv[++i])) > 0) {
+            if (listingOptions.pageSize == 0) listingOptions.pageSize = DEFAULT_PAGE_SIZE;
+        } else if (strcmp(argv[i], "--page-size") == 0 && i + 1 < argc &&
+                   (listingOptions.pageSize = atol(argv[++i])) > 0) {
+            if (listingOptions.page == 0) listingOptions.page = 1;
+        } else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc && parseColumnList(argv[++i], &listingOptions)) {
+            // Course numbers past the table's course count are skipped when listing
+        } else if ((strcmp(argv[i], "--external-sort") == 0 || strcmp(argv[i], "--external-stats") == 0) &&
+                   i + 1 < argc && (externalPath == NULL || strcmp(externalPath, argv[i + 1]) == 0)) {
+            // Both may be given for the same file; it is then read once
+            externalSort |= strcmp(argv[i], "--external-sort") == 0;
+            externalStats |= strcmp(argv[i], "--external-stats") == 0;
+            externalPath = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            externalOutput = argv[++i];
+        } else if (strcmp(argv[i], "--by") == 0 && i + 1 < argc &&
+                   ((strcmp(argv[i + 1], "total") == 0 && (externalOrder = VIEW_TOTAL_DESC, 1)) ||
+                    (strcmp(argv[i + 1], "total-asc") == 0 && (externalOrder = VIEW_TOTAL_ASC, 1)) ||
+                    (strcmp(argv[i + 1], "id") == 0 && (externalOrder = VIEW_ID, 1)) ||
+                    (strcmp(argv[i + 1], "name") == 0 && (externalOrder = VIEW_NAME, 1)))) {
+            i++;
+        } else if (strcmp(argv[i], "--memory-limit") == 0 && i + 1 < argc &&
+                   (memoryLimit = parseMemorySize(argv[++i])) >= EXTERNAL_MIN_MEMORY) {
+            // Covers the run buffer, merge buffers and statistics together
+        } else if (strcmp(argv[i], "--temp-dir") == 0 && i + 1 < argc) {
+            tempDir = argv[++i];
+        } else {
+            printf("Usage: %s [--import file.csv] [--rejects report.txt]\n"
+                   "       [--snapshot file.snap | --no-snapshot] [--verify-snapshot] [--self-check]\n"
+                   "       [--no-journal] [--journal-limit BYTES] [--history file.history]\n"
+                   "       [--stats] [--no-intern] [--compact-scores]\n"
+                   "       [--kernel auto|avx2|sse2|scalar] [--threads N] [--batch commands.txt | -]\n"
+                   "       [--page N] [--page-size M] [--columns id,name,1,2,...,total,average]\n"
+                   "       [--attributes section,year,...]\n"
+                   "       [--max-id N] [--generate file.csv --students N [--courses N] [--sections N] [--seed S]]\n"
+                   "       [--benchmark | --bench-sizes 1000,100000,...] [--bench-output results.tsv]\n"
+                   "       [--serve socket | --connect socket]\n"
+                   "       [--loadgen socket [--clients N] [--duration S] [--write-percent P] [--seed S]]\n"
+                   "       [--external-sort file.csv --output sorted.csv [--by total|total-asc|id|name]]\n"
+                   "       [--external-stats file.csv] [--memory-limit SIZE (at least 16M)] [--temp-dir DIR]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (!selectStatisticsKernel(kernel)) {
+        return 1;
+    }
+    if (statsSetting != NULL && statsSetting[0] != '\0' && strcmp(statsSetting, "0") != 0) {
+        enableOperationStats();
+        dumpStats = 1;
+    }
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount > MAX_THREADS) threadCount = MAX_THREADS;
+    startWorkerPool((int)threadCount);
+
+    // Generating data and benchmarking are stand-alone runs with no menu
+    if (generatePath != NULL) {
+        int ok = generateRoster(generatePath, generateStudents, (int)generateCourses, (int)generateSections, seed);
+
+        if (ok && MIN_STUDENT_ID + generateStudents - 1 > maxStudentId) {
+            printf("IDs go up to %ld; import with --max-id %ld.\n", MIN_STUDENT_ID + generateStudents - 1,
+                   MIN_STUDENT_ID + generateStudents - 1);
+        }
+        if (ok && generateSections > 0) {
+            printf("Rows have a section column; import with --attributes section.\n");
+        }
+        stopWorkerPool();
+        return !ok;
+    }
+    if (connectPath != NULL) {
+        long failures = runClient(connectPath, stdin, stdout);
+
+        stopWorkerPool();
+        return failures != 0;
+    }
+    if (loadPath != NULL) {
+        int ok = runLoadGenerator(loadPath, (int)loadClients, loadSeconds, (int)writePercent, seed);
+
+        stopWorkerPool();
+        return !ok;
+    }
+    if (externalPath != NULL) {
+        int ok;
+
+        if (externalSort && externalOutput == NULL) {
+            printf("ERROR: --external-sort needs --output.\n");
+            stopWorkerPool();
+            return 1;
+        }
+        if (rejectPath == NULL) {
+            snprintf(defaultRejectPath, sizeof(defaultRejectPath), "%s.rejects", externalPath);
+            rejectPath = defaultRejectPath;
+        }
+        ok = runExternalJob(externalPath, externalOutput, externalSort ? externalOrder : VIEW_COUNT, externalStats,
+                            (size_t)memoryLimit, tempDir != NULL && tempDir[0] != '\0' ? tempDir : "/tmp", rejectPath);
+        stopWorkerPool();
+        return !ok;
+    }
+    if (benchSizes != NULL) {
+        int ok = generateCourses >= 1 && generateCourses <= MAX_COURSES &&
+                 runBenchmarks(benchSizes, (int)generateCourses, seed, benchOutput);
+
+        stopWorkerPool();
+        return !ok;
+    }
+
+    // Closed terms are kept beside the snapshot unless --history names another file
+    if (historyPath != NULL) {
+        snprintf(history.path, sizeof(history.path), "%s", historyPath);
+    } else if (snapshotPath != NULL) {
+        snprintf(history.path, sizeof(history.path), "%s.history", snapshotPath);
+    }
+
+    if (batchPath != NULL || servePath != NULL) {
+        // Batch output is for scripts; progress notes go to stderr
+        notices = stderr;
+    } else {
+        // Taken after --stats, which may have replaced stdout with a counting stream
+        notices = stdout;
+        printf("\n============================================\n");
+        printf("     STUDENT MANAGEMENT SYSTEM\n");
+        printf("============================================\n");
+    }
+
+    // Bulk import replaces the interactive student and course count prompts
+    if (importPath != NULL) {
+        ImportSummary summary;
+
+        if (rejectPath == NULL) {
+            snprintf(defaultRejectPath, sizeof(defaultRejectPath), "%s.rejects", importPath);
+            rejectPath = defaultRejectPath;
+        }
+        if (!initStudentTable(&table, 0) ||
+            !importStudentsCsv(&table, importPath, rejectPath, &summary)) {
+            freeStudentTable(&table);
+            return 1;
+        }
+
+        fprintf(notices, "\nImported %ld records from '%s' in %.3f s (%.1f MB/s).\n",
+                summary.imported, importPath, summary.seconds,
+                summary.seconds > 0 ? summary.bytes / summary.seconds / 1e6 : 0.0);
+        if (summary.rejected > 0) {
+            fprintf(notices, "%ld rows rejected, see '%s'.\n", summary.rejected, rejectPath);
+        }
+        haveTable = 1;
+        hasUnsavedChanges = 1;
+    } else if (snapshotPath != NULL && access(snapshotPath, F_OK) == 0) {
+        // A saved snapshot replaces the student and course count prompts
+        struct timespec began;
+
+        clock_gettime(CLOCK_MONOTONIC, &began);
+        if (!loadSnapshot(&table, snapshotPath, verifySnapshot)) {
+            printf("Start with --no-snapshot to ignore it.\n");
+            return 1;
+        }
+        fprintf(notices, "\nLoaded %d records (%d courses) from '%s' in %.3f ms.\n",
+                table.count, table.courseCount, snapshotPath, elapsedSeconds(&began) * 1e3);
+        haveTable = 1;
+    }
+
+    // Changes made since the snapshot are replayed from the journal, which then records new ones
+    if (snapshotPath != NULL && useJournal) {
+        long recovered;
+
+        if (!haveTable && !initStudentTable(&table, 0)) {
+            printf("ERROR: Not enough memory.\n");
+            return 1;
+        }
+        if ((recovered = openJournal(&table, snapshotPath, importPath == NULL)) < 0) {
+            printf("Start with --no-journal to ignore it.\n");
+            return 1;
+        }
+        if (recovered > 0) {
+            fprintf(notices, "Recovered %ld changes from '%s'.\n", recovered, journal.path);
+        }
+        if (importPath != NULL && checkpointTable(&table, snapshotPath)) {
+            // The imported roster is the new starting point for the journal
+            hasUnsavedChanges = 0;
+        }
+        if (table.courseCount > 0) {
+            haveTable = 1;
+        } else if (!haveTable) {
+            freeStudentTable(&table);
+        }
+    }
+
+    if (haveTable) {
+        studentCount = table.count;
+        courseCount = table.courseCount;
+        hasDataBeenEntered = table.count > 0;
+    }
+
+    // Server mode answers batch commands from many clients until it is stopped
+    if (servePath != NULL) {
+        int ok;
+
+        if (!haveTable && !initStudentTable(&table, 0)) {
+            fprintf(stderr, "ERROR: Not enough memory.\n");
+            return 1;
+        }
+        ok = runServer(&table, servePath, snapshotPath);
+        closeJournal();
+        closeTermHistory();
+        freeStudentTable(&table);
+        stopWorkerPool();
+        if (dumpStats) {
+            writeOperationStats(stderr, 0);
+        }
+        return !ok;
+    }
+
+    // Batch mode runs commands back to back with no menu or prompts
+    if (batchPath != NULL) {
+        FILE *commands = strcmp(batchPath, "-") == 0 ? stdin : fopen(batchPath, "r");
+        long failures;
+
+        if (commands == NULL) {
+            fprintf(stderr, "ERROR: Cannot open '%s'.\n", batchPath);
+            return 1;
+        }
+        if (!haveTable && !initStudentTable(&table, 0)) {
+            fprintf(stderr, "ERROR: Not enough memory.\n");
+            return 1;
+        }
+        failures = runBatch(&table, commands, stdout, snapshotPath);
+        if (commands != stdin) {
+            fclose(commands);
+        }
+        closeJournal();
+        closeTermHistory();
+        freeStudentTable(&table);
+        stopWorkerPool();
+        if (dumpStats) {
+            writeOperationStats(stderr, 0);
+        }
+        return failures > 0;
+    }
+
+    // Get number of students; a saved roster with no rows still needs to know how many to enter
+    while (studentCount <= 0) {
+        printf("\nEnter number of students: ");
+        if (scanf("%d", &studentCount) != 1) {
+            printf("ERROR: Invalid input.\n");
+            clearInputBuffer();
+            continue;
+        }
+
+        if (studentCount <= 0) {
+            printf("ERROR: Please enter at least 1 student.\n");
+        }
+    }
+
+    // Get number of courses
+    while (!haveTable && (courseCount <= 0 || courseCount > MAX_COURSES)) {
+        printf("Enter number of courses (1-%d): ", MAX_COURSES);
+        if (scanf("%d", &courseCount) != 1) {
+            printf("ERROR: Invalid input.\n");
+            clearInputBuffer();
+            continue;
+        }
+
+        if (courseCount <= 0 || courseCount > MAX_COURSES) {
+            printf("ERROR: Please enter between 1 and %d.\n", MAX_COURSES);
+        }
+    }
+
+    if (!haveTable) {
+        clearInputBuffer();
+
+        if (!initStudentTable(&table, courseCount)) {
+            printf("ERROR: Not enough memory.\n");
+            return 1;
+        }
+        // An empty table is not journaled: a session quit before any row is entered must leave
+        // nothing behind, or the next run would skip these prompts with no students to enter
+        journal.shapePending = 1;
+    }
+
+    // Main program loop
+    do {
+        choice = showMenu();
+        beginOperation(&timer);
+
+        switch (choice) {
+            case 1:
+                showHelp();
+                break;
+            case 2:
+                inputStudentData(&table, studentCount);
+                break;
+            case 3:
+                if (hasDataBeenEntered) {
+                    showCourseStatistics(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 4:
+                if (hasDataBeenEntered) {
+                    showStudentStatistics(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 5:
+                if (hasDataBeenEntered) {
+                    if (sortByTotalScore(&table, 1)) {
+                        printf("\nSORTED BY HIGHEST SCORES:\n");
+                        displayAllStudents(&table);
+                    }
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 6:
+                if (hasDataBeenEntered) {
+                    if (sortByTotalScore(&table, 0)) {
+                        printf("\nSORTED BY LOWEST SCORES:\n");
+                        displayAllStudents(&table);
+                    }
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 7:
+                if (hasDataBeenEntered) {
+                    if (sortByStudentId(&table)) {
+                        printf("\nSORTED BY STUDENT ID:\n");
+                        displayAllStudents(&table);
+                    }
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 8:
+                if (hasDataBeenEntered) {
+                    if (sortByStudentName(&table)) {
+                        printf("\nSORTED BY STUDENT NAME:\n");
+                        displayAllStudents(&table);
+                    }
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 9:
+                if (hasDataBeenEntered) {
+                    searchByStudentId(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 10:
+                if (hasDataBeenEntered) {
+                    searchByStudentName(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 11:
+                if (hasDataBeenEntered) {
+                    showGradeStatistics(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 12:
+                if (hasDataBeenEntered) {
+                    displayAllStudents(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 13:
+                if (snapshotPath == NULL) {
+                    printf("\nERROR: Snapshots are disabled (--no-snapshot).\n");
+                } else if (checkpointTable(&table, snapshotPath)) {
+                    hasUnsavedChanges = 0;
+                    printf("\nSUCCESS: %d records saved to '%s'.\n", table.count, snapshotPath);
+                }
+                break;
+            case 14:
+                if (hasDataBeenEntered) {
+                    showTopStudents(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 15:
+                if (hasDataBeenEntered) {
+                    showStudentRank(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 16:
+                addOneStudent(&table);
+                break;
+            case 17:
+                if (hasDataBeenEntered) {
+                    editStudentScore(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 18:
+                if (hasDataBeenEntered) {
+                    editStudentName(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 19:
+                if (hasDataBeenEntered) {
+                    removeStudent(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 20:
+                showOperationStats();
+                break;
+            case 21:
+                if (hasDataBeenEntered) {
+                    showRangeQuery(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 22:
+                if (hasDataBeenEntered) {
+                    showGroupReport(&table);
+                } else {
+                    printf("\nERROR: Please enter student data first (Option 2).\n");
+                }
+                break;
+            case 23:
+                showTermHistory(&table);
+                break;
+            case 0:
+                if (snapshotPath != NULL && hasUnsavedChanges && checkpointTable(&table, snapshotPath)) {
+                    printf("\nData saved to '%s'.\n", snapshotPath);
+                }
+                printf("\nThank you for using the Student Management System.\n");
+                break;
+            default:
+                if (choice != -1) {
+                    printf("\nERROR: Invalid choice. Please enter a number from 0 to %d.\n", MENU_MAX_CHOICE);
+                }
+                clearInputBuffer();
+        }
+
+        if (choice >= 0 && choice <= MENU_MAX_CHOICE) {
+            endOperation(&timer, choice, menuRecordsTouched(&table, choice, studentCount));
+        }
+
+        if (selfCheckEnabled && choice > 0 && ensureAggregates(&table)) {
+            verifyAggregates(&table);
+        }
+
+        // Whatever the action changed is on disk before the next prompt
+        if (!journalSync()) {
+            printf("\nWARNING: The journal could not be written; use option 13 to save.\n");
+        }
+
+        if (choice != 0) {
+            printf("\nPress Enter to continue...");
+            clearInputBuffer();
+        }
+
+    } while (choice != 0);
+
+    closeJournal();
+    closeTermHistory();
+    freeStudentTable(&table);
+    stopWorkerPool();
+    if (dumpStats) {
+        writeOperationStats(stderr, 0);
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#!/bin/sh
+# Regression checks: builds the program and drives it through its menu and batch modes.
+# Usage: tests/run.sh   (from anywhere; exits non-zero if a check fails)
+
+cd "$(dirname "$0")/.." || exit 1
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+program="$work/student_management"
+failures=0
+
+gcc -Wall -Wextra -O2 -pthread -o "$program" Student_Management.c -lm || exit 1
+
+check() {
+    if [ "$2" = "$3" ]; then
+        echo "ok   $1"
+    else
+        echo "FAIL $1: expected '$3', got '$2'"
+        failures=$((failures + 1))
+    fi
+}
+
+# A first session quit after the student and course counts must not leave an empty roster behind
+printf '2\n2\n0\ny\n' | timeout 10 "$program" --snapshot "$work/aborted.snap" > /dev/null 2>&1
+printf '2\n2\n2\n1001\nAnn\n80\n70\n1002\nBob\n60\n50\n0\ny\n' |
+    timeout 10 "$program" --snapshot "$work/aborted.snap" > "$work/relaunch.txt" 2>&1
+check "relaunch after an aborted session asks for the counts again" \
+    "$(grep -c 'Enter number of students: Enter number of courses' "$work/relaunch.txt")" "1"
+check "relaunch after an aborted session keeps the entered students" \
+    "$(printf 'count\n' | "$program" --snapshot "$work/aborted.snap" --batch - 2>/dev/null | head -1)" "$(printf '2\t2')"
+
+# Names may use letters of any script, but not emoji or other symbols
+printf 'id,name,c1,c2\n1001,Ann,80,70\n' > "$work/names.csv"
+check "an emoji name is rejected" \
+    "$(printf 'load %s\nrename 1001 Ann \360\237\230\200\n' "$work/names.csv" |
+        "$program" --no-snapshot --batch - 2>/dev/null | tail -1)" "$(printf 'error\tinvalid name')"
+check "an accented name is accepted" \
+    "$(printf 'load %s\nrename 1001 Jos\303\251 N\303\272\303\261ez\n' "$work/names.csv" |
+        "$program" --no-snapshot --batch - 2>/dev/null | tail -1)" "$(printf 'ok\t1')"
+
+# A batch load reports its rejected rows the way --import does
+printf 'id,name,c1,c2\n1001,Ann,80,70\n1002,B0b,60,50\n' > "$work/rejects.csv"
+check "a batch load names its rejects file" \
+    "$(printf 'load %s\n' "$work/rejects.csv" | "$program" --no-snapshot --batch - 2>/dev/null | head -1)" \
+    "$(printf '1\t2\t1\t%s' "$work/rejects.csv.rejects")"
+check "the rejects file lists the rejected row" \
+    "$(cat "$work/rejects.csv.rejects" 2>/dev/null)" "line 3: invalid name: 1002,B0b,60,50"
+
+[ "$failures" -eq 0 ]